@@ -0,0 +1,39 @@
+#!/bin/sh
+#
+#  module.sh
+#  Oberon
+#
+#  Created by Alvaro Costa Neto on 10/17/26.
+#  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+#
+# Uso: module.sh [MiB]
+#
+# Escreve na saída padrão um módulo sintético com cerca do tamanho dado (32 MiB por padrão) para “parse.c”: poucas
+# variáveis globais, para que a busca na tabela de símbolos pese pouco, e uma sequência fixa de atribuições, “IF”,
+# “WHILE” e comentários
+
+size=${1:-32}
+awk -v size="$size" 'BEGIN {
+	srand(1)
+	limit = size * 1024 * 1024
+	length_ = 0
+	print "MODULE Big;"
+	print "VAR"
+	print "  x, y, idx, count, total: INTEGER;"
+	print "BEGIN"
+	while (length_ < limit) {
+		kind = int(rand() * 4)
+		if (kind == 0)
+			line = sprintf("  x := x + x * %d - (x DIV 3);", int(rand() * 100))
+		else if (kind == 1)
+			line = sprintf("  y := x + x * %d - (y DIV 3);", int(rand() * 100))
+		else if (kind == 2)
+			line = "  IF x > y THEN x := x MOD 7 ELSE x := 0 END;"
+		else
+			line = "  (* comment about x and y *) WHILE x < 10 DO x := x + 1 END;"
+		print line
+		length_ += length(line) + 1
+	}
+	print "  x := 0"
+	print "END Big."
+}'
@@ -0,0 +1,94 @@
+//
+//  parse.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "atoms.h"
+#include "errors.h"
+#include "layout.h"
+#include "scanner.h"
+#include "symbol_table.h"
+#include "parser.h"
+
+// Mede o tempo por token das análises léxica e sintática, sem geração de código: as funções chamadas pelo analisador
+// sintático abaixo não fazem nada, então o tempo medido é o do analisador léxico, do sintático (inclusive os conjuntos
+// first e follow) e da tabela de símbolos. A entrada é lida duas vezes: a primeira só com o analisador léxico, que
+// também conta os tokens, e a segunda com o sintático; a diferença entre as duas é a parcela do analisador sintático
+// Uso: parse módulo (ver “module.sh”)
+//
+// Compilação, a partir deste diretório:
+//   cc -std=gnu99 -O2 -I.. -o parse parse.c ../parser.c ../scanner.c ../errors.c ../symbol_table.c ../arena.c
+//      ../atoms.c ../layout.c ../source.c
+
+void write_index_offset(item_t *item, item_t *index_item) { (void)item; (void)index_item; }
+void write_field_offset(item_t *item, address_t offset) { (void)item; (void)offset; }
+void write_unary_op(symbol_t symbol, item_t *item) { (void)symbol; (void)item; }
+void write_short_circuit(symbol_t symbol, item_t *item) { (void)symbol; (void)item; }
+void write_binary_op(symbol_t symbol, item_t *item, item_t *rhs_item) { (void)symbol; (void)item; (void)rhs_item; }
+void write_comparison(symbol_t symbol, item_t *item, item_t *rhs_item) { (void)symbol; (void)item; (void)rhs_item; }
+void write_branch(item_t *item, bool forward) { (void)item; (void)forward; }
+void write_inverse_branch(item_t *item, bool forward) { (void)item; (void)forward; }
+void write_label(item_t *item) { (void)item; }
+void write_store(item_t *dst_item, item_t *src_item) { (void)dst_item; (void)src_item; }
+void fixup_links(item_t *item) { (void)item; }
+void open_procedure(entry_t *entry) { (void)entry; }
+void close_procedure() {}
+void write_parameters(entry_t *entry) { (void)entry; }
+void write_actual_param(item_t *item, bool reference) { (void)item; (void)reference; }
+void write_call(entry_t *entry, item_t *params, unsigned int count) { (void)entry; (void)params; (void)count; }
+
+double elapsed(const struct timespec *start)
+{
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (double)(end.tv_sec - start->tv_sec) + (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, const char *argv[])
+{
+	if (argc != 2) {
+		printf("Usage: parse module\n");
+		return EXIT_FAILURE;
+	}
+	FILE *file = fopen(argv[1], "r");
+	if (!file) {
+		printf("Input file could not be opened.\n");
+		return EXIT_FAILURE;
+	}
+	struct timespec start;
+	unsigned long tokens = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (!initialize_atoms()) {
+		printf("Not enough memory.\n");
+		return EXIT_FAILURE;
+	}
+	initialize_scanner(file);
+	do {
+		read_token();
+		tokens++;
+	} while (current_token.lexem.symbol != symbol_eof);
+	finalize_scanner();
+	clear_atoms();
+	double scanning = elapsed(&start);
+	rewind(file);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (initialize_parser(file)) {
+		initialize_layout(layout_aligned, false, NULL, 0);
+		parse();
+	}
+	double parsing = elapsed(&start);
+	fclose(file);
+	if (errors_count > 0)
+		return EXIT_FAILURE;
+	printf("%lu tokens in %.3f s: %.1f ns/token (scanner %.1f, parser %.1f)\n", tokens, parsing, parsing * 1e9 / tokens,
+	       scanning * 1e9 / tokens, (parsing - scanning) * 1e9 / tokens);
+	return EXIT_SUCCESS;
+}
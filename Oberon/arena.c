@@ -0,0 +1,69 @@
+//
+//  arena.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdlib.h>
+
+#include "errors.h"
+#include "arena.h"
+
+typedef struct _arena_chunk {
+  struct _arena_chunk *previous;
+  size_t used, size;
+} arena_chunk_t;
+
+// Os dados de cada bloco começam logo após o cabeçalho, arredondado para manter o alinhamento de todas as alocações
+#define ARENA_CHUNK_HEADER_SIZE ((sizeof(arena_chunk_t) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+__thread arena_t compilation_arena = { .chunk = NULL, .chunk_size = ARENA_INITIAL_CHUNK_SIZE };
+
+void initialize_arena(arena_t *arena)
+{
+  clear_arena(arena);
+}
+
+bool add_chunk(arena_t *arena, size_t size)
+{
+  // Os blocos dobram de tamanho até o limite; requisições maiores que o bloco ganham um bloco exclusivo
+  size_t chunk_size = arena->chunk_size;
+  if (arena->chunk && chunk_size < ARENA_MAX_CHUNK_SIZE)
+    chunk_size *= 2;
+  if (size > chunk_size)
+    chunk_size = size;
+  arena_chunk_t *chunk = (arena_chunk_t *)malloc(ARENA_CHUNK_HEADER_SIZE + chunk_size);
+  if (!chunk)
+    return false;
+  chunk->previous = arena->chunk;
+  chunk->used = 0;
+  chunk->size = chunk_size;
+  arena->chunk = chunk;
+  if (chunk_size <= ARENA_MAX_CHUNK_SIZE)
+    arena->chunk_size = chunk_size;
+  return true;
+}
+
+void *arena_allocate(arena_t *arena, size_t size)
+{
+  size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+  if ((!arena->chunk || arena->chunk->size - arena->chunk->used < size) && !add_chunk(arena, size)) {
+    mark_not_enough_memory();
+    return NULL;
+  }
+  void *memory = (unsigned char *)arena->chunk + ARENA_CHUNK_HEADER_SIZE + arena->chunk->used;
+  arena->chunk->used += size;
+  return memory;
+}
+
+void clear_arena(arena_t *arena)
+{
+  while (arena->chunk) {
+    arena_chunk_t *previous = arena->chunk->previous;
+    free(arena->chunk);
+    arena->chunk = previous;
+  }
+  arena->chunk_size = ARENA_INITIAL_CHUNK_SIZE;
+}
@@ -0,0 +1,35 @@
+//
+//  arena.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_arena_h
+#define Oberon_arena_h
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define ARENA_ALIGNMENT 16
+#define ARENA_INITIAL_CHUNK_SIZE (64 * 1024)
+#define ARENA_MAX_CHUNK_SIZE (1024 * 1024)
+
+struct _arena_chunk;
+
+// Alocador por incremento de ponteiro: a memória é obtida em blocos (“chunks”) cada vez maiores e nunca é liberada
+// individualmente, somente de uma só vez em “clear_arena”. Todas as estruturas de uma compilação (entradas, tipos,
+// escopos, ligações de saltos etc.) vêm de “compilation_arena” e morrem juntas ao final de “parse”
+typedef struct _arena {
+  struct _arena_chunk *chunk;
+  size_t chunk_size;
+} arena_t;
+
+extern __thread arena_t compilation_arena;
+
+void initialize_arena(arena_t *arena);
+void *arena_allocate(arena_t *arena, size_t size);
+void clear_arena(arena_t *arena);
+
+#endif
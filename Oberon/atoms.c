@@ -0,0 +1,183 @@
+//
+//  atoms.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "errors.h"
+#include "atoms.h"
+
+#define ATOMS_INITIAL_CAPACITY 1024
+#define ATOMS_BLOCK_SIZE (64 * 1024)
+
+typedef struct _atom_record {
+  const char *text;
+  uint32_t length;
+  uint32_t hash;
+} atom_record_t;
+
+// Os textos ficam em blocos que nunca são realocados, de forma que o ponteiro devolvido por “id_for_atom” permanece
+// válido até “clear_atoms”. Cada bloco guarda no início o endereço do bloco anterior
+typedef struct _atom_block {
+  struct _atom_block *previous;
+  size_t used, size;
+  char text[];
+} atom_block_t;
+
+__thread atom_record_t *atom_records = NULL;
+__thread uint32_t atoms_count = 0, atoms_capacity = 0;
+// Tabela de espalhamento com endereçamento aberto contendo os átomos (zero indica uma posição vazia)
+__thread atom_t *atom_slots = NULL;
+__thread uint32_t atom_slots_capacity = 0;
+__thread atom_block_t *atom_block = NULL;
+
+uint32_t hash_text(const char *text, size_t length)
+{
+  uint32_t hash = ATOMS_HASH_SEED;
+  for (size_t index = 0; index < length; index++)
+    hash = ATOMS_HASH_STEP(hash, text[index]);
+  return hash;
+}
+
+const char *store_text(const char *text, size_t length)
+{
+  if (!atom_block || atom_block->size - atom_block->used < length + 1) {
+    size_t size = length + 1 > ATOMS_BLOCK_SIZE ? length + 1 : ATOMS_BLOCK_SIZE;
+    atom_block_t *block = (atom_block_t *)malloc(sizeof(atom_block_t) + size);
+    if (!block)
+      return NULL;
+    block->previous = atom_block;
+    block->used = 0;
+    block->size = size;
+    atom_block = block;
+  }
+  char *stored = atom_block->text + atom_block->used;
+  memcpy(stored, text, length);
+  stored[length] = '\0';
+  atom_block->used += length + 1;
+  return stored;
+}
+
+// Retorna a posição do átomo com o texto dado ou a posição vazia onde ele deveria ser inserido
+atom_t *probe_atoms(const char *text, size_t length, uint32_t hash)
+{
+  uint32_t mask = atom_slots_capacity - 1;
+  uint32_t index = hash & mask;
+  while (atom_slots[index]) {
+    atom_record_t *record = &atom_records[atom_slots[index]];
+    if (record->hash == hash && record->length == length && memcmp(record->text, text, length) == 0)
+      break;
+    index = (index + 1) & mask;
+  }
+  return &atom_slots[index];
+}
+
+bool grow_atoms()
+{
+  uint32_t capacity = atom_slots_capacity * 2;
+  atom_t *slots = (atom_t *)calloc(capacity, sizeof(atom_t));
+  atom_record_t *records = (atom_record_t *)realloc(atom_records, capacity * sizeof(atom_record_t));
+  if (!slots || !records) {
+    free(slots);
+    if (records)
+      atom_records = records;
+    return false;
+  }
+  free(atom_slots);
+  atom_records = records;
+  atoms_capacity = capacity;
+  atom_slots = slots;
+  atom_slots_capacity = capacity;
+  for (atom_t atom = 1; atom < atoms_count; atom++) {
+    atom_record_t *record = &atom_records[atom];
+    *probe_atoms(record->text, record->length, record->hash) = atom;
+  }
+  return true;
+}
+
+bool initialize_atoms()
+{
+  clear_atoms();
+  atom_slots = (atom_t *)calloc(ATOMS_INITIAL_CAPACITY, sizeof(atom_t));
+  atom_records = (atom_record_t *)malloc(ATOMS_INITIAL_CAPACITY * sizeof(atom_record_t));
+  if (!atom_slots || !atom_records) {
+    clear_atoms();
+    return false;
+  }
+  atom_slots_capacity = atoms_capacity = ATOMS_INITIAL_CAPACITY;
+  // O átomo zero corresponde ao texto vazio e nunca é inserido na tabela de espalhamento
+  atom_records[ATOM_NONE].text = "";
+  atom_records[ATOM_NONE].length = 0;
+  atom_records[ATOM_NONE].hash = 0;
+  atoms_count = 1;
+  return true;
+}
+
+void clear_atoms()
+{
+  while (atom_block) {
+    atom_block_t *previous = atom_block->previous;
+    free(atom_block);
+    atom_block = previous;
+  }
+  free(atom_slots);
+  free(atom_records);
+  atom_slots = NULL;
+  atom_records = NULL;
+  atom_slots_capacity = atoms_capacity = atoms_count = 0;
+}
+
+// “hash” deve ter sido calculado com “ATOMS_HASH_STEP” sobre todos os caracteres de “text”
+atom_t intern_hashed(const char *text, size_t length, uint32_t hash)
+{
+  if (!atom_slots && !initialize_atoms()) {
+    mark_not_enough_memory();
+    return ATOM_NONE;
+  }
+  if (length == 0)
+    return ATOM_NONE;
+  atom_t *slot = probe_atoms(text, length, hash);
+  if (*slot)
+    return *slot;
+  // A tabela é mantida com no máximo 3/4 de ocupação
+  if ((atoms_count + 1) * 4 > atom_slots_capacity * 3) {
+    if (!grow_atoms()) {
+      mark_not_enough_memory();
+      return ATOM_NONE;
+    }
+    slot = probe_atoms(text, length, hash);
+  }
+  const char *stored = store_text(text, length);
+  if (!stored) {
+    mark_not_enough_memory();
+    return ATOM_NONE;
+  }
+  atom_t atom = atoms_count++;
+  atom_records[atom].text = stored;
+  atom_records[atom].length = (uint32_t)length;
+  atom_records[atom].hash = hash;
+  *slot = atom;
+  return atom;
+}
+
+atom_t intern(const char *text, size_t length)
+{
+  return intern_hashed(text, length, hash_text(text, length));
+}
+
+atom_t intern_id(const char *id)
+{
+  return intern(id, strlen(id));
+}
+
+const char *id_for_atom(atom_t atom)
+{
+  if (atom >= atoms_count)
+    return "";
+  return atom_records[atom].text;
+}
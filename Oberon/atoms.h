@@ -0,0 +1,34 @@
+//
+//  atoms.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_atoms_h
+#define Oberon_atoms_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Cada texto distinto (identificadores, números, rótulos etc.) é guardado uma única vez e representado por um “átomo”:
+// um número de 32 bits. Dois átomos são iguais se, e somente se, os textos forem iguais, o que transforma comparações de
+// identificadores em comparações de inteiros. O átomo zero é reservado e representa a ausência de texto
+typedef uint32_t atom_t;
+
+#define ATOM_NONE 0
+
+// Função de espalhamento FNV-1a, exposta para que o analisador léxico possa calculá-la enquanto lê os caracteres
+#define ATOMS_HASH_SEED 2166136261u
+#define ATOMS_HASH_STEP(hash, c) (((hash) ^ (unsigned char)(c)) * 16777619u)
+
+bool initialize_atoms();
+void clear_atoms();
+atom_t intern(const char *text, size_t length);
+atom_t intern_hashed(const char *text, size_t length, uint32_t hash);
+atom_t intern_id(const char *id);
+const char *id_for_atom(atom_t atom);
+
+#endif
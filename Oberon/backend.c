@@ -8,109 +8,311 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <stdarg.h>
+#include <string.h>
+#include <limits.h>
 #include <stdbool.h>
-#include <strings.h>
 
 #include "backend.h"
+#include "dead.h"
 #include "errors.h"
+#include "frames.h"
+#include "inlining.h"
+#include "ir.h"
+#include "jit.h"
+#include "lowering.h"
+#include "native.h"
+#include "object.h"
+#include "peephole.h"
+#include "ranges.h"
+#include "registers.h"
+#include "strength.h"
+#include "values.h"
 #include "symbol_table.h"
 
-#define REGISTER_INDEX_COUNT 32
 #define BACKEND_FORWARD_LABEL "????????????????"
-#define BACKEND_EMPTY_LABEL "                "
+#define BACKEND_MODULE UINT_MAX
 
-FILE *output_file = NULL;
-unsigned char register_index = 0;
-address_t program_counter = 0;
+__thread FILE *output_file = NULL;
+__thread output_format_t output_format = output_format_text;
 
-void initialize_backend(FILE *file)
+// Representação intermediária do módulo, construída durante a análise sintática
+__thread ir_t module_ir;
+
+// Cada procedimento tem a sua representação intermediária, construída enquanto ele é analisado e otimizada e ligada ao
+// código do módulo apenas ao final da compilação. As entradas da tabela de símbolos deixam de existir antes disso, por
+// isso os procedimentos são identificados pela ordem em que foram abertos
+typedef struct _procedure {
+  ir_t ir;
+  unsigned int parent; // Procedimento que envolve este ou BACKEND_MODULE
+  bool reachable;      // Estado de “reachable” no procedimento que envolve este, restaurado ao fim deste
+  bool references;     // Algum parâmetro é passado por referência
+  bool called;         // O procedimento é chamado, direta ou indiretamente, pelo corpo do módulo
+  instruction_t *code; // Instruções da máquina alvo geradas ao final da compilação
+  unsigned int length;
+} procedure_t;
+
+__thread procedure_t *procedures = NULL;
+__thread unsigned int procedure_count = 0, procedure_capacity = 0;
+__thread unsigned int current_procedure = BACKEND_MODULE;
+
+// Instruções da máquina alvo, geradas a partir da representação intermediária ao final da compilação
+__thread instruction_t *code = NULL;
+__thread unsigned int program_counter = 0;
+
+const char *mnemonics[] = {
+  "NOP", "LOAD", "STORE", "MOV", "ADD", "SUB", "MUL", "DIV", "MOD", "SHL", "AND", "OR", "NEG", "NOT", "CMP",
+  "BREQ", "BRNE", "BRLS", "BRLE", "BRGR", "BRGE", "JUMP", "TRAP", "CALL", "ENTER", "RET"
+};
+
+// Depois de um desvio incondicional, o código só volta a ser alcançável em um rótulo que receba algum desvio (ver
+// “fixup_links”). Até lá, nenhuma instrução é escrita, o que elimina os trechos de estruturas cujas condições são
+// constantes
+__thread bool reachable = true;
+
+// Com as verificações ligadas, os índices variáveis são comparados com os limites do vetor durante a execução (os
+// constantes já são verificados pelo analisador sintático)
+__thread bool index_checks = false;
+
+void initialize_backend(FILE *file, output_format_t format, bool checks)
 {
   output_file = file;
+  output_format = format;
+  initialize_ir(&module_ir);
+  procedures = NULL;
+  procedure_count = procedure_capacity = 0;
+  current_procedure = BACKEND_MODULE;
+  reachable = true;
+  index_checks = checks;
 }
 
-void inc_index(unsigned char amount)
+static inline ir_t *current_ir()
 {
-  register_index = (register_index + amount) % REGISTER_INDEX_COUNT;
+  return current_procedure == BACKEND_MODULE ? &module_ir : &procedures[current_procedure].ir;
 }
 
-void dec_index(unsigned char amount)
+// Durante a análise, o registro de ativação do procedimento corrente começa em “frame_base” e ainda pode crescer
+static inline bool is_local_address(address_t address)
 {
-  register_index = (register_index - amount) % REGISTER_INDEX_COUNT;
+  return current_procedure != BACKEND_MODULE && address >= procedures[current_procedure].ir.frame_base;
 }
 
-void write(const char *text, ...)
+static inline ir_operand_t no_operand() { return ir_operand(ir_operand_none, 0); }
+static inline ir_operand_t register_operand(unsigned int index) { return ir_operand(ir_operand_register, (int)index); }
+static inline ir_operand_t constant_operand(int value) { return ir_operand(ir_operand_constant, value); }
+static inline ir_operand_t address_operand(int address) { return ir_operand(ir_operand_address, address); }
+
+// Retorna o expoente de “value” se ele for uma potência de 2 ou -1 caso contrário
+static inline int power_of_two(long long value)
 {
-  va_list args;
-  va_start(args, text);
-  vfprintf(output_file, text, args);
-  va_end(args);
+  if (value <= 0 || (value & (value - 1)) != 0)
+    return -1;
+  int exponent = 0;
+  while (value > 1) {
+    value >>= 1;
+    exponent++;
+  }
+  return exponent;
 }
 
-void write_line(const char *instruction, ...)
+ir_instruction_t *emit_ir(ir_opcode_t opcode, unsigned int dst, ir_operand_t a, ir_operand_t b)
 {
-  va_list args;
-  va_start(args, instruction);
-  vfprintf(output_file, instruction, args);
-  va_end(args);
-  fprintf(output_file, "\n");
-  program_counter++;
+  if (!reachable)
+    return NULL;
+  return write_ir(current_ir(), opcode, dst, a, b);
+}
+
+// Escreve uma instrução cujo resultado vai para um registrador virtual novo e retorna esse registrador. Em código
+// inalcançável o registrador é criado mesmo assim, para que os itens continuem consistentes
+unsigned int write_value(ir_opcode_t opcode, ir_operand_t a, ir_operand_t b)
+{
+  unsigned int dst = create_register(current_ir());
+  emit_ir(opcode, dst, a, b);
+  return dst;
+}
+
+// Os operandos da representação intermediária têm 32 bits; uma constante maior (apenas com “value_t” de 64 bits) é
+// montada em um registrador, 16 bits por vez
+static ir_operand_t value_operand(value_t value)
+{
+  long long wide = value;
+  if (wide >= INT_MIN && wide <= INT_MAX)
+    return constant_operand((int)wide);
+  unsigned int reg = write_value(ir_move, constant_operand((int)(wide >> 32)), no_operand());
+  for (int shift = 16; shift >= 0; shift -= 16) {
+    reg = write_value(ir_shl, register_operand(reg), constant_operand(16));
+    if ((wide >> shift) & 0xFFFF)
+      reg = write_value(ir_or, register_operand(reg), constant_operand((int)((wide >> shift) & 0xFFFF)));
+  }
+  return register_operand(reg);
+}
+
+// Junta a cadeia de desvios “links” à cadeia “chain”
+static void merge_links(link_t **chain, link_t *links)
+{
+  if (!links)
+    return;
+  link_t *last = links;
+  while (last->next)
+    last = last->next;
+  last->next = *chain;
+  *chain = links;
+}
+
+static void patch_links(link_t *link, int label)
+{
+  ir_t *ir = current_ir();
+  while (link) {
+    ir->instructions[link->position].dst = (unsigned int)label;
+    link = link->next;
+  }
+}
+
+// Os desvios da cadeia passam a levar à próxima instrução, que por isso se torna alcançável
+static void fixup_chain(link_t **chain)
+{
+  if (!*chain)
+    return;
+  patch_links(*chain, (int)current_ir()->length);
+  reachable = true;
+  *chain = NULL;
 }
 
 void write_load(item_t *item)
 {
   if (!item) return;
   if (item->addressing == addressing_immediate)
-    write_line("LOAD R%d, %d", register_index, item->value);
+    item->index = write_value(ir_move, value_operand(item->value), no_operand());
   else if (item->addressing == addressing_direct)
-    write_line("LOAD R%d, [%.4X]", register_index, item->address);
-  else if (item->addressing == addressing_indirect) {
-    write_line("LOAD R%d, [R%d]", item->index, item->index);
-    item->addressing = addressing_register;
-    return;
+    item->index = write_value(ir_load, address_operand(item->address), no_operand());
+  else if (item->addressing == addressing_indirect)
+    item->index = write_value(ir_load, register_operand(item->index), no_operand());
+  else if (item->addressing != addressing_register) {
+    // Uma comparação só decide desvios e não tem valor que possa ser guardado. Os itens desconhecidos já foram
+    // apontados como erro; em ambos os casos, o registrador recebe zero apenas para que o item continue consistente
+    if (item->addressing == addressing_condition) {
+      mark(error_parser, "A comparison can only be used as a condition.");
+      fixup_chain(&item->true_links);
+      fixup_chain(&item->false_links);
+    }
+    item->index = write_value(ir_move, constant_operand(0), no_operand());
   }
-  else
-    return; // TODO: Devo verificar e apontar erro ou deixar como está?
   item->addressing = addressing_register;
-  item->index = register_index;
-  inc_index(1);
 }
 
-void write_store(item_t *dst_item, item_t *src_item)
+// Constantes não precisam ocupar registradores: a representação intermediária as aceita como operandos
+ir_operand_t item_operand(item_t *item)
 {
-  if (!dst_item || !src_item) return;
-  // Se o item de origem já estiver em um registrador, a função “write_load” não mudará nada
-  write_load(src_item);
-  if (dst_item->addressing == addressing_indirect)
-    write_line("STORE [R%d], R%d", dst_item->index, src_item->index);
-  else
-    write_line("STORE [%.4X], R%d", dst_item->address, src_item->index);
-  dst_item->addressing = addressing_register;
-  dst_item->index = src_item->index;
-  // TODO: Se for reaproveitar o destino para as próximas contas, é necessário reduzir o índice de registradores?
-  dec_index(1);
+  if (item->addressing == addressing_immediate)
+    return value_operand(item->value);
+  write_load(item);
+  return register_operand(item->index);
+}
+
+// Copia o valor de “source” para “item”, inclusive as cadeias de “&” e “OR”, preservando o rótulo e as ligações dos
+// desvios que têm “item” como destino
+void take_item(item_t *item, const item_t *source)
+{
+  if (item == source)
+    return;
+  item->addressing = source->addressing;
+  item->type = source->type;
+  item->address = source->address;
+  item->value = source->value;
+  item->index = source->index;
+  item->condition = source->condition;
+  item->true_links = source->true_links;
+  item->false_links = source->false_links;
+}
+
+static inline void set_constant(item_t *item, value_t value)
+{
+  item->addressing = addressing_immediate;
+  item->value = value;
+}
+
+// Calcula a operação durante a compilação. O resultado precisa caber em “value_t”, pois é isso que a execução guardaria
+// na memória; comparações resultam em 0 (falso) ou 1 (verdadeiro). A divisão trunca o quociente, como na máquina alvo.
+// Com “value_t” de 64 bits, o próprio cálculo em “long long” pode transbordar
+value_t fold_constants(symbol_t symbol, value_t lhs, value_t rhs)
+{
+  long long result = 0;
+  bool valid = true;
+  switch (symbol) {
+    case symbol_plus: valid = checked_add(lhs, rhs, &result); break;
+    case symbol_minus: valid = checked_sub(lhs, rhs, &result); break;
+    case symbol_times: valid = checked_mul(lhs, rhs, &result); break;
+    case symbol_div:
+    case symbol_mod:
+      if (rhs == 0) {
+        mark(error_parser, "Division by zero.");
+        return 0;
+      }
+      // “MIN_VALUE div -1” não cabe em “long long” quando “value_t” tem 64 bits
+      if (rhs == -1)
+        valid = symbol == symbol_mod || checked_sub(0, lhs, &result);
+      else
+        result = symbol == symbol_div ? (long long)lhs / rhs : (long long)lhs % rhs;
+      break;
+    case symbol_and: result = lhs & rhs; break;
+    case symbol_or: result = lhs | rhs; break;
+    case symbol_equal: result = lhs == rhs; break;
+    case symbol_not_equal: result = lhs != rhs; break;
+    case symbol_less: result = lhs < rhs; break;
+    case symbol_less_equal: result = lhs <= rhs; break;
+    case symbol_greater: result = lhs > rhs; break;
+    case symbol_greater_equal: result = lhs >= rhs; break;
+    default: break; // TODO: Verificar operadores binários inválidos
+  }
+  if (!valid) {
+    mark(error_parser, "Constant expression overflows (the result is not between %lld and %lld).",
+         (long long)MIN_VALUE, (long long)MAX_VALUE);
+    return 0;
+  }
+  if (result < MIN_VALUE || result > MAX_VALUE) {
+    mark(error_parser, "Constant expression overflows (%lld is not between %lld and %lld).", result,
+         (long long)MIN_VALUE, (long long)MAX_VALUE);
+    return 0;
+  }
+  return (value_t)result;
 }
 
+// O deslocamento é um endereço, não um “value_t”, por isso é calculado aqui e não por “write_binary_op”. Tamanhos que
+// são potências de 2 usam um deslocamento de bits no lugar da multiplicação
 void write_index_offset(item_t *item, item_t *index_item)
 {
   if (!item || !index_item) return;
-  // TODO: Adicionar rotina “trap” para índices fora do limite
-  write_load(index_item);
-  write_line("MUL R%d, %d", index_item->index, item->type->base->size);
+  ir_operand_t offset = item_operand(index_item);
+  if (index_checks && offset.kind != ir_operand_constant) {
+    ir_instruction_t *check = emit_ir(ir_check, IR_NO_REGISTER, offset, constant_operand(item->type->length));
+    if (check)
+      check->condition = IR_CHECK_LOWER | IR_CHECK_UPPER;
+  }
+  // Em uma estrutura de vetores, o índice aponta para a primeira coluna (ver “layout.h”)
+  int size = item->type->columns ? 1 : (int)item->type->base->size, exponent = power_of_two(size);
+  if (offset.kind == ir_operand_constant)
+    offset = constant_operand(offset.value * size);
+  else if (exponent > 0)
+    offset = register_operand(write_value(ir_shl, offset, constant_operand(exponent)));
+  else if (exponent < 0)
+    offset = register_operand(write_value(ir_mul, offset, constant_operand(size)));
   if (item->addressing == addressing_direct) {
-    write_line("ADD R%d, %d", index_item->index, item->address);
-    item->index = index_item->index;
+    // O vetor inteiro pode ser escrito por instruções indiretas, o que a redução de força precisa saber
+    write_indexed_range(current_ir(), item->address, item->type->size);
+    // No início da área de dados, o deslocamento já é o endereço
+    if (item->address == 0 && !is_local_address(0) && offset.kind == ir_operand_register)
+      item->index = (unsigned int)offset.value;
+    else
+      item->index = write_value(ir_add, offset, address_operand(item->address));
     item->addressing = addressing_indirect;
   }
-  else if (item->addressing == addressing_indirect) {
-    write_line("ADD R%d, R%d", item->index, index_item->index);
-    dec_index(1);
-  }
+  else if (item->addressing == addressing_indirect && (offset.kind != ir_operand_constant || offset.value != 0))
+    item->index = write_value(ir_add, register_operand(item->index), offset);
 }
 
 void write_field_offset(item_t *item, address_t offset)
 {
-  write_line("ADD R%d, %d", item->index, offset);
+  if (offset != 0)
+    item->index = write_value(ir_add, register_operand(item->index), constant_operand(offset));
 }
 
 void write_unary_op(symbol_t symbol, item_t *item)
@@ -119,180 +321,670 @@ void write_unary_op(symbol_t symbol, item_t *item)
   if (symbol == symbol_minus) {
     // Se o item for uma constante, o próprio compilador pode fazer a conta e continuar o processo
     if (item->addressing == addressing_immediate) {
-      item->value = -item->value;
+      item->value = fold_constants(symbol_minus, 0, item->value);
       return;
     }
-    write_load(item);
-    write_line("NEG R%d", item->index);
+    item->index = write_value(ir_neg, item_operand(item), no_operand());
   } else if (symbol == symbol_not) {
-    if (item->addressing == addressing_immediate) {
-      item->value = ~item->value;
-      return;
+    // “~” é a negação lógica: comparações apenas trocam de condição (e as cadeias de desvios, entre si) e os demais
+    // valores lógicos (0 ou 1) são subtraídos de 1
+    if (item->addressing == addressing_immediate)
+      item->value = !item->value;
+    else if (item->addressing == addressing_condition) {
+      item->condition = inverse_condition(item->condition);
+      link_t *links = item->true_links;
+      item->true_links = item->false_links;
+      item->false_links = links;
+    }
+    else {
+      ir_operand_t value = item_operand(item);
+      item->index = write_value(ir_sub, constant_operand(1), value);
     }
-    write_load(item);
-    write_line("NOT R%d", item->index);
   }
   // TODO: Verificar operadores unários inválidos
 }
 
-void write_binary_op(symbol_t symbol, item_t *item, item_t *rhs_item)
+// Desvios para frente ficam ligados ao item até que “fixup_links” conheça o destino; desvios para trás usam o rótulo
+// já marcado no item. Itens sem comparação geram desvios incondicionais
+void write_branch_link(symbol_t condition, item_t *item, bool forward)
 {
-  if (!item || !rhs_item) return;
-  if (item->addressing == addressing_immediate && rhs_item->addressing == addressing_immediate) {
-    if (symbol == symbol_plus)
-      item->value = item->value + rhs_item->value;
-    else if (symbol == symbol_minus)
-      item->value = item->value - rhs_item->value;
-    else if (symbol == symbol_times)
-      item->value = item->value * rhs_item->value;
-    else if (symbol == symbol_div)
-      item->value = item->value / rhs_item->value;
-//    else if (symbol == symbol_mod)
-//      item->value = item->value % rhs_item->value;
-    else if (symbol == symbol_and)
-      item->value = item->value & rhs_item->value;
-    else if (symbol == symbol_or)
-      item->value = item->value | rhs_item->value;
-    // TODO: Verificar operadores binários inválidos
+  if (!reachable)
     return;
-  } else {
-    char opcode[] = "NOP";
-    bool keep_order = false;
-    if (symbol == symbol_plus) {
-      strcpy(opcode, "ADD");
-    } else if (symbol == symbol_minus) {
-      strcpy(opcode, "SUB");
-      keep_order = true;
-    } else if (symbol == symbol_times) {
-      strcpy(opcode, "MUL");
-    } else if (symbol == symbol_div) {
-      strcpy(opcode, "DIV");
-      keep_order = true;
-//    } else if (symbol == symbol_mod) {
-//      strcpy(opcode, "MOD");
-//      keep_order = true;
-    } else if (symbol == symbol_and) {
-      strcpy(opcode, "AND");
-    } else if (symbol == symbol_or) {
-      strcpy(opcode, "OR");
-    }
-    if (item->addressing == addressing_immediate) {
-      write_load(rhs_item);
-      // Para algumas operações a ordem dos operandos é significante e deve ser respeitada
-      if (keep_order) {
-        // TODO: Trocar a ordem dos índices para remover a instrução “MOV”
-        write_load(item);
-        write_line("%s R%d, R%d", opcode, item->index, rhs_item->index);
-        // É preciso mover o resultado para o registrador de menor índice (neste caso, o do segundo operando) para que
-        // o índice de registradores em uso possa ser reduzido, evitando que a quantidade disponível de registradores
-        // esgote-se
-        write_line("MOV R%d, R%d", rhs_item->index, item->index);
-        item->index = rhs_item->index;
-        dec_index(1);
-        return;
-      }
-      write_line("%s R%d, %d", opcode, rhs_item->index, item->value);
-      item->addressing = addressing_register;
-      item->index = rhs_item->index;
-    } else if (rhs_item->addressing == addressing_immediate) {
-      write_load(item);
-      write_line("%s R%d, %d", opcode, item->index, rhs_item->value);
-    } else {
-      write_load(item);
-      write_load(rhs_item);
-      write_line("%s R%d, R%d", opcode, item->index, rhs_item->index);
-      if (item->index > rhs_item->index) {
-        write_line("MOV R%d, R%d", rhs_item->index, item->index);
-        item->index = rhs_item->index;
-      }
-      dec_index(1);
-    }
-  }
+  bool conditional = condition >= symbol_equal && condition <= symbol_greater_equal;
+  unsigned int target = forward ? IR_NO_BLOCK : (unsigned int)item->label;
+  if (forward)
+    add_link(create_link(current_ir()->length), &item->links);
+  ir_instruction_t *instruction = emit_ir(conditional ? ir_branch : ir_jump, target, no_operand(), no_operand());
+  if (instruction && conditional)
+    instruction->condition = (unsigned char)condition;
+  if (!conditional)
+    reachable = false;
 }
 
-void write_comparison(symbol_t symbol, item_t *item, item_t *rhs_item)
+// Transforma um valor lógico guardado (0 ou 1) na condição “diferente de zero”
+static void write_test(item_t *item)
 {
-  if (!item || !rhs_item) return;
-  write_load(item);
-  write_load(rhs_item);
-  write_line("CMP R%d, R%d", item->index, rhs_item->index);
+  ir_operand_t value = item_operand(item);
+  emit_ir(ir_compare, IR_NO_REGISTER, value, constant_operand(0));
   item->addressing = addressing_condition;
-  item->condition = symbol;
-  // É necessário liberar ambos os registradores após a comparação. Ou não?
-  dec_index(2);
+  item->condition = symbol_not_equal;
 }
 
-void write_conditional_branch(symbol_t condition)
+// Desvia para “target” conforme o valor lógico do item ou o seu inverso. Uma condição constante decide o desvio durante
+// a compilação: ele se torna incondicional ou desaparece. Valores lógicos guardados em variáveis são comparados com
+// zero. Os desvios já escritos pelos operandos de “&” e “OR” seguem o mesmo critério: os da cadeia que leva ao valor
+// procurado também vão para “target” e os da outra continuam na instrução seguinte
+void write_logical_branch(item_t *item, bool inverse, item_t *target, bool forward)
 {
-  switch (condition) {
-    case symbol_equal: write("BREQ "); break;
-    case symbol_not_equal: write("BRNE "); break;
-    case symbol_less: write("BRLS "); break;
-    case symbol_less_equal: write("BRLE "); break;
-    case symbol_greater: write("BRGR "); break;
-    case symbol_greater_equal: write("BRGE "); break;
-    default: write("JUMP "); break;
+  if (item->addressing == addressing_immediate) {
+    if ((item->value != 0) != inverse)
+      write_branch_link(symbol_null, target, forward);
   }
+  else {
+    if (item->addressing != addressing_condition)
+      write_test(item);
+    write_branch_link(inverse ? inverse_condition(item->condition) : item->condition, target, forward);
+  }
+  link_t **taken = inverse ? &item->false_links : &item->true_links;
+  if (forward)
+    merge_links(&target->links, *taken);
+  else
+    patch_links(*taken, target->label);
+  *taken = NULL;
+  fixup_chain(inverse ? &item->true_links : &item->false_links);
 }
 
-void write_branch_link(item_t *item, bool forward)
+// “&” e “OR” são avaliados em curto-circuito quando o primeiro operando é uma comparação: antes do segundo operando, o
+// desvio que já decide a expressão (falsa em “&”, verdadeira em “OR”) entra na cadeia correspondente do item. Com
+// valores inteiros, os dois operadores continuam sendo operações bit a bit
+void write_short_circuit(symbol_t symbol, item_t *item)
 {
-  if (forward) {
-    fpos_t position;
-    fgetpos(output_file, &position);
-    add_link(create_link(position), &item->links);
-    write_line(BACKEND_FORWARD_LABEL);
+  if (!item || item->addressing != addressing_condition || (symbol != symbol_and && symbol != symbol_or))
+    return;
+  bool conjunction = symbol == symbol_and;
+  item_t decided;
+  decided.links = NULL;
+  write_logical_branch(item, conjunction, &decided, true);
+  if (conjunction)
+    item->false_links = decided.links;
+  else
+    item->true_links = decided.links;
+}
+
+// Completa “&” ou “OR” com ao menos um operando comparação: o resultado é a condição do último operando, com as cadeias
+// dos dois. Um primeiro operando que não é comparação só é conhecido depois do segundo; então o segundo desvia no lugar
+// dele e ele é comparado com zero. Os operandos não têm efeitos colaterais, então a ordem não muda o resultado
+static void write_logical_op(symbol_t symbol, item_t *item, item_t *rhs_item)
+{
+  bool conjunction = symbol == symbol_and;
+  if (item->addressing == addressing_condition) {
+    if (rhs_item->addressing != addressing_condition) {
+      // A comparação precisa de um registrador, mesmo com uma constante
+      if (rhs_item->addressing == addressing_immediate)
+        write_load(rhs_item);
+      write_test(rhs_item);
+    }
+    item->condition = rhs_item->condition;
+    merge_links(&item->true_links, rhs_item->true_links);
+    merge_links(&item->false_links, rhs_item->false_links);
+  }
+  else if (item->addressing == addressing_immediate) {
+    // “TRUE & c” e “FALSE OR c” valem “c”; “FALSE & c” e “TRUE OR c” já estão decididas e os desvios de “c” apenas
+    // continuam na instrução seguinte
+    if ((item->value != 0) == conjunction)
+      take_item(item, rhs_item);
+    else {
+      fixup_chain(&rhs_item->true_links);
+      fixup_chain(&rhs_item->false_links);
+      set_constant(item, !conjunction);
+    }
   }
   else {
-    if (item->label)
-      write_line(item->label);
-    else
-      write_line("GOD_KNOWS_WHERE!");
+    write_short_circuit(symbol, rhs_item);
+    write_test(item);
+    item->true_links = rhs_item->true_links;
+    item->false_links = rhs_item->false_links;
+  }
+}
+
+// Simplificações algébricas quando apenas um dos operandos é constante. Os operandos não têm efeitos colaterais, por
+// isso o outro pode ser descartado quando o resultado não depende dele (x * 0). Retorna verdadeiro se o resultado já
+// estiver em “item”
+bool simplify_binary_op(symbol_t symbol, item_t *item, item_t *rhs_item)
+{
+  bool constant_lhs = item->addressing == addressing_immediate;
+  item_t *other = constant_lhs ? rhs_item : item;
+  value_t value = constant_lhs ? item->value : rhs_item->value;
+  switch (symbol) {
+    case symbol_plus:
+      if (value != 0)
+        return false;
+      take_item(item, other);
+      return true;
+    case symbol_minus:
+      if (value != 0)
+        return false;
+      if (constant_lhs) {
+        write_unary_op(symbol_minus, rhs_item);
+        take_item(item, rhs_item);
+      }
+      return true;
+    case symbol_times:
+      if (value == 0)
+        set_constant(item, 0);
+      else if (value == 1)
+        take_item(item, other);
+      else if (value == -1) {
+        write_unary_op(symbol_minus, other);
+        take_item(item, other);
+      }
+      else if (power_of_two(value) > 0) {
+        item->index = write_value(ir_shl, item_operand(other), constant_operand(power_of_two(value)));
+        item->addressing = addressing_register;
+      }
+      else
+        return false;
+      return true;
+    case symbol_div:
+    case symbol_mod:
+      if (constant_lhs)
+        return false;
+      if (value == 0)
+        mark(error_parser, "Division by zero.");
+      else if (value == 1 || value == -1) {
+        if (symbol == symbol_mod)
+          set_constant(item, 0);
+        else if (value == -1)
+          write_unary_op(symbol_minus, item);
+      }
+      else
+        return false;
+      return true;
+    case symbol_and:
+    case symbol_or:
+      // x & 0 = 0, x & -1 = x, x OR 0 = x, x OR -1 = -1
+      if (value == 0 || value == -1) {
+        if ((value == 0) == (symbol == symbol_and))
+          set_constant(item, value);
+        else
+          take_item(item, other);
+        return true;
+      }
+      return false;
+    default:
+      return false;
+  }
+}
+
+void write_binary_op(symbol_t symbol, item_t *item, item_t *rhs_item)
+{
+  if (!item || !rhs_item) return;
+  if ((symbol == symbol_and || symbol == symbol_or) &&
+      (item->addressing == addressing_condition || rhs_item->addressing == addressing_condition)) {
+    write_logical_op(symbol, item, rhs_item);
+    return;
+  }
+  if (item->addressing == addressing_immediate && rhs_item->addressing == addressing_immediate) {
+    item->value = fold_constants(symbol, item->value, rhs_item->value);
+    return;
+  }
+  if ((item->addressing == addressing_immediate || rhs_item->addressing == addressing_immediate) &&
+      simplify_binary_op(symbol, item, rhs_item))
+    return;
+  ir_opcode_t opcode = ir_nop;
+  if (symbol == symbol_plus)
+    opcode = ir_add;
+  else if (symbol == symbol_minus)
+    opcode = ir_sub;
+  else if (symbol == symbol_times)
+    opcode = ir_mul;
+  else if (symbol == symbol_div)
+    opcode = ir_div;
+  else if (symbol == symbol_mod)
+    opcode = ir_mod;
+  else if (symbol == symbol_and)
+    opcode = ir_and;
+  else if (symbol == symbol_or)
+    opcode = ir_or;
+  // O operando da esquerda é carregado antes do da direita, como na ordem de avaliação do código fonte
+  ir_operand_t lhs = item_operand(item);
+  ir_operand_t rhs = item_operand(rhs_item);
+  item->index = write_value(opcode, lhs, rhs);
+  item->addressing = addressing_register;
+}
+
+void write_comparison(symbol_t symbol, item_t *item, item_t *rhs_item)
+{
+  if (!item || !rhs_item) return;
+  if (item->addressing == addressing_immediate && rhs_item->addressing == addressing_immediate) {
+    item->value = fold_constants(symbol, item->value, rhs_item->value);
+    return;
   }
+  ir_operand_t lhs = item_operand(item);
+  ir_operand_t rhs = item_operand(rhs_item);
+  emit_ir(ir_compare, IR_NO_REGISTER, lhs, rhs);
+  item->addressing = addressing_condition;
+  item->condition = symbol;
 }
 
 void write_branch(item_t *item, bool forward)
 {
   if (!item) return;
-  write_conditional_branch(item->condition);
-  write_branch_link(item, forward);
+  write_logical_branch(item, false, item, forward);
 }
 
 void write_inverse_branch(item_t *item, bool forward)
 {
   if (!item) return;
-  write_conditional_branch(inverse_condition(item->condition));
-  write_branch_link(item, forward);
+  write_logical_branch(item, true, item, forward);
 }
 
-void write_label(item_t *item, const char *label)
+// O rótulo é simplesmente o índice da próxima instrução; “build_blocks” transforma os destinos em blocos básicos
+void write_label(item_t *item)
 {
   if (!item) return;
-  if (label)
-    strncpy(item->label, label, SYMBOL_TABLE_MAX_LABEL_LENGTH);
-  else {
-    // Se o rótulo não for passado como parâmetro, a própria posição no arquivo de saída é usada como base para criar
-    // um rótulo válido
-    fpos_t position;
-    fgetpos(output_file, &position);
-    sprintf(item->label, "L_%lld", position);
-  }
-  write_line("%s:", item->label);
+  item->label = (int)current_ir()->length;
 }
 
 void fixup_links(item_t *item)
 {
   if (!item) return;
-  fpos_t position;
-  fgetpos(output_file, &position);
   link_t *link = item->links;
-  while (link) {
-    fsetpos(output_file, &link->position);
-    fprintf(output_file, BACKEND_EMPTY_LABEL);
-    fsetpos(output_file, &link->position);
-    fprintf(output_file, "%s", item->label);
-    link = link->next;
+  // Um desvio escrito para este rótulo torna o código seguinte alcançável outra vez
+  if (link)
+    reachable = true;
+  patch_links(link, item->label);
+  // As ligações pertencem à arena da compilação e são liberadas junto com ela
+  item->links = NULL;
+}
+
+static void write_store_value(item_t *dst_item, ir_operand_t value)
+{
+  if (dst_item->addressing == addressing_indirect)
+    emit_ir(ir_store, IR_NO_REGISTER, register_operand(dst_item->index), value);
+  else
+    emit_ir(ir_store, IR_NO_REGISTER, address_operand(dst_item->address), value);
+}
+
+// Uma comparação não tem valor em registrador: o resultado (1 ou 0) é guardado por um de dois caminhos, escolhido pelo
+// desvio da própria comparação
+void write_store(item_t *dst_item, item_t *src_item)
+{
+  if (!dst_item || !src_item) return;
+  if (src_item->addressing != addressing_condition) {
+    write_store_value(dst_item, item_operand(src_item));
+    return;
+  }
+  item_t false_item, end_item;
+  false_item.links = end_item.links = NULL;
+  write_logical_branch(src_item, true, &false_item, true);
+  write_store_value(dst_item, constant_operand(1));
+  write_branch_link(symbol_null, &end_item, true);
+  write_label(&false_item);
+  fixup_links(&false_item);
+  write_store_value(dst_item, constant_operand(0));
+  write_label(&end_item);
+  fixup_links(&end_item);
+}
+
+// O procedimento começa com a leitura dos seus parâmetros. Os passados por valor são guardados no registro de ativação
+// como as variáveis locais; os passados por referência ficam com o endereço da variável em um registrador
+void open_procedure(entry_t *entry)
+{
+  if (procedure_count == procedure_capacity) {
+    unsigned int capacity = procedure_capacity ? procedure_capacity * 2 : 8;
+    procedure_t *larger = (procedure_t *)realloc(procedures, capacity * sizeof(procedure_t));
+    if (!larger) {
+      mark_not_enough_memory();
+      return;
+    }
+    procedures = larger;
+    procedure_capacity = capacity;
+  }
+  procedure_t *procedure = &procedures[procedure_count];
+  initialize_ir(&procedure->ir);
+  procedure->ir.frame_base = current_address;
+  procedure->parent = current_procedure;
+  procedure->reachable = reachable;
+  procedure->references = false;
+  procedure->called = false;
+  procedure->code = NULL;
+  procedure->length = 0;
+  if (entry)
+    entry->index = procedure_count;
+  current_procedure = procedure_count++;
+  reachable = true;
+}
+
+void write_parameters(entry_t *entry)
+{
+  if (!entry || current_procedure == BACKEND_MODULE) return;
+  entry_t *parameter = entry->parameters;
+  for (unsigned int index = 0; index < entry->parameter_count && index < MAX_PARAMETERS && parameter; index++) {
+    unsigned int value = write_value(ir_parameter, constant_operand((int)index), no_operand());
+    if (parameter->reference) {
+      parameter->index = value;
+      procedures[current_procedure].references = true;
+    }
+    else
+      emit_ir(ir_store, IR_NO_REGISTER, address_operand(parameter->address), register_operand(value));
+    parameter = parameter->next;
+  }
+}
+
+// As variáveis declaradas no procedimento vão de “frame_base” até o endereço corrente, que o analisador sintático
+// restaura em seguida
+void close_procedure()
+{
+  if (current_procedure == BACKEND_MODULE) return;
+  procedure_t *procedure = &procedures[current_procedure];
+  procedure->ir.frame_size = current_address - procedure->ir.frame_base;
+  reachable = procedure->reachable;
+  current_procedure = procedure->parent;
+}
+
+// Os parâmetros passados por valor são calculados na ordem do código fonte; os passados por referência guardam o
+// endereço da variável (direto ou em um registrador) até a chamada. Uma constante que não cabe em um operando também
+// é montada aqui, pois nada pode ser escrito entre os argumentos
+void write_actual_param(item_t *item, bool reference)
+{
+  if (!item || reference) return;
+#if VALUE_BITS > 32
+  if (item->addressing == addressing_immediate && (item->value < INT_MIN || item->value > INT_MAX))
+    write_load(item);
+#endif
+  if (item->addressing != addressing_immediate)
+    write_load(item);
+}
+
+// Os parâmetros são escritos todos juntos, imediatamente antes da chamada (ver “ir.h”)
+void write_call(entry_t *entry, item_t *params, unsigned int count)
+{
+  if (!entry || !params) return;
+  for (unsigned int index = 0; index < count && index < MAX_PARAMETERS; index++) {
+    ir_operand_t argument = register_operand(params[index].index);
+    if (params[index].addressing == addressing_immediate)
+      argument = constant_operand(params[index].value);
+    else if (params[index].addressing == addressing_direct)
+      argument = address_operand(params[index].address);
+    else if (params[index].addressing == addressing_unknown)
+      argument = constant_operand(0); // Argumento recusado pelo analisador sintático, que já apontou o erro
+    emit_ir(ir_argument, IR_NO_REGISTER, argument, constant_operand((int)index));
+  }
+  emit_ir(ir_call, IR_NO_REGISTER, constant_operand((int)entry->index), no_operand());
+}
+
+void print_operand(FILE *file, operand_t operand)
+{
+  switch (operand.kind) {
+    case operand_register: fprintf(file, "R%d", operand.value); break;
+    case operand_immediate:
+    case operand_address: fprintf(file, "%d", operand.value); break;
+    case operand_direct: fprintf(file, "[%.4X]", operand.value); break;
+    case operand_indirect: fprintf(file, "[R%d]", operand.value); break;
+    case operand_spill: fprintf(file, "S%d", operand.value); break;
+    case operand_frame: fprintf(file, "[FP+%d]", operand.value); break;
+    case operand_local: fprintf(file, "FP+%d", operand.value); break;
+    case operand_slot: fprintf(file, "S[FP+%d]", operand.value); break;
+    case operand_argument: fprintf(file, "A%d", operand.value); break;
+    case operand_label:
+      if (operand.value != BACKEND_NO_LABEL)
+        fprintf(file, "L_%d", operand.value);
+      else
+        fprintf(file, BACKEND_FORWARD_LABEL);
+      break;
+    default: break;
+  }
+}
+
+// Escreve todo o código de uma só vez e sequencialmente, o que permite usar “pipes” ou a saída padrão. Apenas as
+// instruções que são destino de algum desvio recebem rótulos
+void print_code(FILE *file)
+{
+  bool *targets = (bool *)calloc(program_counter + 1, sizeof(bool));
+  if (!targets) {
+    mark_not_enough_memory();
+    return;
+  }
+  for (unsigned int index = 0; index < program_counter; index++)
+    if (code[index].dst.kind == operand_label && code[index].dst.value >= 0 &&
+        (unsigned int)code[index].dst.value <= program_counter)
+      targets[code[index].dst.value] = true;
+  for (unsigned int index = 0; index <= program_counter; index++) {
+    if (targets[index])
+      fprintf(file, "L_%u:\n", index);
+    if (index == program_counter)
+      break;
+    instruction_t *instruction = &code[index];
+    fputs(mnemonics[instruction->opcode], file);
+    if (instruction->dst.kind != operand_none) {
+      fputc(' ', file);
+      print_operand(file, instruction->dst);
+    }
+    if (instruction->src.kind != operand_none) {
+      fputs(", ", file);
+      print_operand(file, instruction->src);
+    }
+    fputc('\n', file);
+  }
+  free(targets);
+}
+
+// Executa o módulo em memória e escreve o conteúdo final das variáveis globais
+void run_code(FILE *file, unsigned int spill_count)
+{
+  value_t *data = (value_t *)calloc(JIT_DATA_SIZE(spill_count), 1);
+  if (!data) {
+    mark_not_enough_memory();
+    return;
+  }
+  trap_t trap = 0;
+  if (!run_jit(code, program_counter, data, current_address, &trap)) {
+    free(data);
+    mark_at(error_fatal, position_zero, "The module could not be compiled and executed in memory.");
+    return;
+  }
+  // Assim como na máquina virtual, a área de dados é escrita mesmo depois de um erro de execução
+  if (trap == trap_index_out_of_range)
+    fprintf(file, "Index out of range.\n");
+  else if (trap == trap_stack_overflow)
+    fprintf(file, "Stack overflow.\n");
+  for (address_t address = 0; address < current_address; address++)
+    fprintf(file, "[%.4X] %lld\n", address, (long long)data[address]);
+  free(data);
+}
+
+// As otimizações trabalham com os desvios ainda apontando para instruções, antes da divisão em blocos
+bool optimize_unit(ir_t *ir)
+{
+  return number_values(ir) && eliminate_index_checks(ir) && reduce_strength(ir) && eliminate_dead_code(ir) &&
+    build_blocks(ir);
+}
+
+// Traduz o corpo do módulo ou um procedimento para as instruções da máquina alvo, com o seu registro de ativação. Os
+// registradores que não couberam na máquina ficam no registro de ativação dos procedimentos, por causa da recursão, e
+// em uma área própria no corpo do módulo
+bool generate_unit(ir_t *ir, bool procedure, unsigned int register_count, instruction_t **unit_code,
+                   unsigned int *length, unsigned int *spill_count)
+{
+  unsigned int virtual_count = 0;
+  if (!lower_ir(ir, unit_code, length, &virtual_count) ||
+      !allocate_registers(unit_code, length, virtual_count, register_count, spill_count) ||
+      !optimize_peephole(*unit_code, length))
+    return false;
+  if (procedure || ir->frame_size > 0)
+    return create_frame(unit_code, length, ir->frame_size, procedure ? *spill_count : 0, procedure);
+  return true;
+}
+
+// Os procedimentos pequenos e sem chamadas são expandidos nos pontos de chamada; os demais só precisam ser gerados se
+// forem alcançados a partir do corpo do módulo. Os que recebem parâmetros por referência podem acessar qualquer
+// variável global de forma indireta
+bool prepare_procedures()
+{
+  ir_t **units = (ir_t **)malloc(((size_t)procedure_count + 1) * sizeof(ir_t *));
+  unsigned int *pending = (unsigned int *)malloc(((size_t)procedure_count + 1) * sizeof(unsigned int));
+  bool valid = units && pending;
+  for (unsigned int index = 0; index < procedure_count && valid; index++)
+    units[index] = &procedures[index].ir;
+  for (unsigned int index = 0; index < procedure_count && valid; index++)
+    valid = inline_calls(&procedures[index].ir, units, procedure_count);
+  if (valid)
+    valid = inline_calls(&module_ir, units, procedure_count);
+  for (unsigned int index = 0; index < procedure_count && valid; index++)
+    if (procedures[index].references)
+      valid = write_indexed_range(&procedures[index].ir, 0, procedures[index].ir.frame_base);
+  unsigned int count = 0;
+  const ir_t *unit = &module_ir;
+  while (valid) {
+    for (unsigned int index = 0; index < unit->length; index++) {
+      unsigned int callee = (unsigned int)unit->instructions[index].a.value;
+      if (unit->instructions[index].opcode == ir_call && callee < procedure_count && !procedures[callee].called) {
+        procedures[callee].called = true;
+        pending[count++] = callee;
+      }
+    }
+    if (count == 0)
+      break;
+    unit = &procedures[pending[--count]].ir;
+  }
+  free(units);
+  free(pending);
+  return valid;
+}
+
+// O corpo do módulo vem primeiro e termina saltando sobre os procedimentos; os destinos de “CALL”, ainda números de
+// procedimentos, passam a ser as primeiras instruções deles
+bool link_procedures()
+{
+  unsigned int module_length = program_counter, total = module_length;
+  bool jump = module_length == 0 || code[module_length - 1].opcode != opcode_jump;
+  unsigned int *starts = (unsigned int *)malloc(((size_t)procedure_count + 1) * sizeof(unsigned int));
+  if (!starts)
+    return false;
+  total += jump;
+  for (unsigned int index = 0; index < procedure_count; index++)
+    if (procedures[index].called) {
+      starts[index] = total;
+      total += procedures[index].length;
+    }
+  if (total == module_length + jump) {
+    free(starts);
+    return true;
+  }
+  instruction_t *linked = (instruction_t *)malloc(((size_t)total + 1) * sizeof(instruction_t));
+  if (!linked) {
+    free(starts);
+    return false;
+  }
+  memcpy(linked, code, (size_t)module_length * sizeof(instruction_t));
+  for (unsigned int index = 0; index < module_length; index++)
+    if (linked[index].dst.kind == operand_label && linked[index].dst.value == (int)module_length)
+      linked[index].dst.value = (int)total;
+  if (jump) {
+    instruction_t *instruction = &linked[module_length];
+    instruction->opcode = opcode_jump;
+    instruction->dst.kind = operand_label;
+    instruction->dst.value = (int)total;
+    instruction->src.kind = operand_none;
+    instruction->src.value = 0;
+  }
+  for (unsigned int index = 0; index < procedure_count; index++) {
+    if (!procedures[index].called)
+      continue;
+    instruction_t *first = &linked[starts[index]];
+    memcpy(first, procedures[index].code, (size_t)procedures[index].length * sizeof(instruction_t));
+    for (unsigned int position = 0; position < procedures[index].length; position++)
+      if (first[position].dst.kind == operand_label)
+        first[position].dst.value += (int)starts[index];
+  }
+  for (unsigned int index = 0; index < total; index++)
+    if (linked[index].opcode == opcode_call) {
+      linked[index].dst.kind = operand_label;
+      linked[index].dst.value = (int)starts[linked[index].dst.value];
+    }
+  free(code);
+  free(starts);
+  code = linked;
+  program_counter = total;
+  return true;
+}
+
+void finalize_backend()
+{
+  // As variáveis locais expandidas no corpo do módulo ficam no seu registro de ativação, logo após as globais
+  module_ir.frame_base = current_address;
+  // Com erros, a representação intermediária pode conter itens inválidos: nada é otimizado, escrito ou executado
+  if (errors_count > 0)
+    output_file = NULL;
+  if (output_file && !prepare_procedures()) {
+    mark_not_enough_memory();
+    output_file = NULL;
+  }
+  bool framed = module_ir.frame_size > 0;
+  for (unsigned int index = 0; index < procedure_count && output_file; index++)
+    if (procedures[index].called) {
+      framed = true;
+      if (!optimize_unit(&procedures[index].ir)) {
+        mark_not_enough_memory();
+        output_file = NULL;
+      }
+    }
+  if (output_file && !optimize_unit(&module_ir)) {
+    mark_not_enough_memory();
+    output_file = NULL;
+  }
+  if (output_file && output_format == output_format_ir) {
+    print_ir(output_file, &module_ir);
+    for (unsigned int index = 0; index < procedure_count; index++)
+      if (procedures[index].called) {
+        fprintf(output_file, "P%u:\n", index);
+        print_ir(output_file, &procedures[index].ir);
+      }
+    output_file = NULL;
+  }
+  // Os códigos nativos usam apenas os registradores x86-64 livres (menos um, que aponta para o registro de ativação,
+  // quando há algum); os demais formatos, os da máquina alvo
+  unsigned int register_count = REGISTER_INDEX_COUNT, spill_count = 0, unit_spills = 0;
+  if (output_format == output_format_native || output_format == output_format_jit)
+    register_count = NATIVE_REGISTER_COUNT - framed;
+  for (unsigned int index = 0; index < procedure_count && output_file; index++)
+    if (procedures[index].called &&
+        !generate_unit(&procedures[index].ir, true, register_count, &procedures[index].code, &procedures[index].length,
+                       &unit_spills)) {
+      mark_not_enough_memory();
+      output_file = NULL;
+    }
+  if (output_file && (!generate_unit(&module_ir, false, register_count, &code, &program_counter, &spill_count) ||
+                      !link_procedures())) {
+    mark_not_enough_memory();
+    output_file = NULL;
+  }
+  if (output_file) {
+    if (output_format == output_format_object) {
+      // A área de dados contém todas as variáveis alocadas pela tabela de símbolos
+      if (!write_object(output_file, code, program_counter, current_address))
+        mark_at(error_fatal, position_zero, "The object file could not be written.");
+    }
+    else if (output_format == output_format_native) {
+      if (!write_native(output_file, code, program_counter, current_address, spill_count))
+        mark_at(error_fatal, position_zero, "The native code could not be generated.");
+    }
+    else if (output_format == output_format_jit)
+      run_code(output_file, spill_count);
+    else
+      print_code(output_file);
+  }
+  clear_ir(&module_ir);
+  for (unsigned int index = 0; index < procedure_count; index++) {
+    clear_ir(&procedures[index].ir);
+    free(procedures[index].code);
   }
-  clear_links(&item->links);
-  fsetpos(output_file, &position);
+  free(procedures);
+  procedures = NULL;
+  procedure_count = procedure_capacity = 0;
+  current_procedure = BACKEND_MODULE;
+  free(code);
+  code = NULL;
+  program_counter = 0;
 }
@@ -10,27 +10,179 @@
 #define Oberon_backend_h
 
 #include <stdio.h>
+#include <stdint.h>
 #include <limits.h>
+#include <stdbool.h>
+
+// Instruções da máquina alvo. A ordem dos desvios condicionais segue a ordem dos símbolos de comparação. A divisão
+// trunca o quociente e o resto tem o sinal do dividendo; o deslocamento aceita apenas uma quantidade imediata. “TRAP n”
+// interrompe a execução com o erro “n” (ver “trap_t”)
+//
+// Os procedimentos usam uma pilha de dados que começa no fim da área de dados e cresce em direção às variáveis globais.
+// “FP” aponta para o registro de ativação corrente: “ENTER n” o reserva (FP ← FP - n), interrompendo a execução quando
+// ele alcança as variáveis globais, e “RET n” o libera e retorna para a instrução seguinte ao “CALL” correspondente. Os
+// parâmetros são passados em “A0”, “A1”..., e o procedimento chamado preserva os registradores que usa
+typedef enum _opcode {
+  opcode_nop,
+  opcode_load,
+  opcode_store,
+  opcode_mov,
+  opcode_add,
+  opcode_sub,
+  opcode_mul,
+  opcode_div,
+  opcode_mod,
+  opcode_shl,
+  opcode_and,
+  opcode_or,
+  opcode_neg,
+  opcode_not,
+  opcode_cmp,
+  opcode_breq,
+  opcode_brne,
+  opcode_brls,
+  opcode_brle,
+  opcode_brgr,
+  opcode_brge,
+  opcode_jump,
+  opcode_trap,
+  opcode_call,
+  opcode_enter,
+  opcode_ret
+} opcode_t;
+
+// Erros de execução sinalizados por “TRAP”
+typedef enum _trap {
+  trap_index_out_of_range = 1,
+  trap_stack_overflow = 2
+} trap_t;
+
+typedef enum _operand_kind {
+  operand_none,
+  operand_register,  // Rn
+  operand_immediate, // n
+  operand_direct,    // [nnnn]
+  operand_indirect,  // [Rn]
+  operand_address,   // n, mas o valor é um endereço de dados (e precisa ser relocado)
+  operand_label,     // Índice da instrução de destino de um desvio
+  operand_spill,     // Sn, posição de memória de um registrador virtual que não coube nos registradores da máquina
+  operand_frame,     // [FP+n], posição do registro de ativação corrente
+  operand_local,     // FP+n, o endereço dessa posição como valor
+  operand_slot,      // S[FP+n], SLOT_SIZE posições do registro de ativação que guardam um registrador (ver “frames.h”)
+  operand_argument   // An, parâmetro passado ao procedimento chamado
+} operand_kind_t;
+
+typedef struct _operand {
+  operand_kind_t kind;
+  int value;
+} operand_t;
+
+// O código é gerado em memória e só é escrito no arquivo de saída ao final da compilação, por isso os desvios para
+// frente são resolvidos apenas alterando o operando da instrução já gerada
+typedef struct _instruction {
+  opcode_t opcode;
+  operand_t dst, src;
+} instruction_t;
+
+// Formatos de saída do compilador: texto (assembly da máquina alvo), arquivo objeto binário (ver “object.h”), assembly
+// x86-64 (ver “native.h”), execução imediata em memória, quando a saída recebe a área de dados final (ver “jit.h”), ou
+// o texto da representação intermediária (ver “ir.h”)
+typedef enum _output_format {
+  output_format_text,
+  output_format_object,
+  output_format_native,
+  output_format_jit,
+  output_format_ir
+} output_format_t;
+
+// Quantidade de registradores da máquina alvo. O gerador de código usa registradores virtuais ilimitados, que são
+// mapeados nestes pela alocação de registradores (ver “registers.h”)
+#define REGISTER_INDEX_COUNT 32
+
+// Quantidade máxima de parâmetros de um procedimento (e de registradores de parâmetros “An”)
+#define MAX_PARAMETERS 16
+
+// Destino de um desvio ainda não resolvido
+#define BACKEND_NO_LABEL -1
+
+// Estas definições determinam o tamanho em bytes dos tipos padrões de dados e endereços. A largura dos inteiros da
+// linguagem (8, 16, 32 ou 64 bits) é escolhida ao compilar o próprio compilador, com “-DVALUE_BITS=n”, e vale tanto
+// para o cálculo das constantes quanto para o código gerado. Cada posição de memória guarda um “value_t”, e os
+// endereços contam posições, não bytes
+#ifndef VALUE_BITS
+#define VALUE_BITS 32
+#endif
+
+#if VALUE_BITS == 8
+#define MAX_VALUE INT8_MAX
+#define MIN_VALUE INT8_MIN
+typedef int8_t value_t;
+#elif VALUE_BITS == 16
+#define MAX_VALUE INT16_MAX
+#define MIN_VALUE INT16_MIN
+typedef int16_t value_t;
+#elif VALUE_BITS == 32
+#define MAX_VALUE INT32_MAX
+#define MIN_VALUE INT32_MIN
+typedef int32_t value_t;
+#elif VALUE_BITS == 64
+#define MAX_VALUE INT64_MAX
+#define MIN_VALUE INT64_MIN
+typedef int64_t value_t;
+#else
+#error "VALUE_BITS must be 8, 16, 32 or 64."
+#endif
 
-//typedef enum _op {
-//  op_nop,
-//  op_add,
-//  op_sub,
-//  op_neg,
-//  op_mul,
-//  op_div,
-//  op_mod,
-//  op_and,
-//  op_or,
-//  op_not
-//} op_t;
-
-// Estas definições determinam o tamanho em bytes dos tipos padrões de dados e endereços
-#define MAX_VALUE SCHAR_MAX
-#define MIN_VALUE SCHAR_MIN
-typedef signed char value_t;
 #define MAX_ADDRESS USHRT_MAX
 #define MIN_ADDRESS 0
 typedef unsigned short address_t;
 
+// Os registradores da máquina alvo têm 32 bits, ou 64 quando “value_t” tem 64. Com “value_t” mais estreito, a escrita
+// na memória guarda apenas os bits menos significativos e a leitura estende o sinal (NARROW_VALUES)
+#if VALUE_BITS == 64
+#define WORD_BITS 64
+#define MAX_WORD INT64_MAX
+#define MIN_WORD INT64_MIN
+typedef int64_t word_t;
+typedef uint64_t unsigned_word_t;
+#else
+#define WORD_BITS 32
+#define MAX_WORD INT32_MAX
+#define MIN_WORD INT32_MIN
+typedef int32_t word_t;
+typedef uint32_t unsigned_word_t;
+#endif
+#define NARROW_VALUES (VALUE_BITS < WORD_BITS)
+
+// Posições de memória ocupadas por um registrador guardado no registro de ativação (“S[FP+n]”)
+#define SLOT_SIZE ((int)((sizeof(word_t) + sizeof(value_t) - 1) / sizeof(value_t)))
+
+// Operações em “long long” que detectam o transbordamento: retornam falso, sem alterar “result”, quando o resultado não
+// pode ser representado. O cálculo das constantes e as análises do gerador de código não podem depender do
+// comportamento indefinido do transbordamento com sinal
+static inline bool checked_add(long long a, long long b, long long *result)
+{
+  if ((b > 0 && a > LLONG_MAX - b) || (b < 0 && a < LLONG_MIN - b))
+    return false;
+  *result = a + b;
+  return true;
+}
+
+static inline bool checked_sub(long long a, long long b, long long *result)
+{
+  if ((b < 0 && a > LLONG_MAX + b) || (b > 0 && a < LLONG_MIN + b))
+    return false;
+  *result = a - b;
+  return true;
+}
+
+static inline bool checked_mul(long long a, long long b, long long *result)
+{
+  if (a != 0 && b != 0 && (a > 0 ? (b > 0 ? a > LLONG_MAX / b : b < LLONG_MIN / a) :
+                           (b > 0 ? a < LLONG_MIN / b : a < LLONG_MAX / b)))
+    return false;
+  *result = a * b;
+  return true;
+}
+
 #endif
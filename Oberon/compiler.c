@@ -0,0 +1,141 @@
+//
+//  compiler.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+// “flockfile” e “sysconf” vêm do POSIX, fora do C99
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <setjmp.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "compiler.h"
+#include "errors.h"
+#include "parser.h"
+
+void initialize_backend(FILE *file, output_format_t format, bool checks);
+void finalize_backend();
+
+// Módulos a compilar, compartilhados pelas linhas de execução; “next” é o próximo módulo ainda não tomado por nenhuma
+typedef struct _pool {
+  context_t *contexts;
+  unsigned int count;
+  unsigned int next;
+} pool_t;
+
+void report(const context_t *context, const char *message)
+{
+  flockfile(stdout);
+  if (context->label)
+    printf("%s: ", context->label);
+  printf("%s\n", message);
+  funlockfile(stdout);
+}
+
+bool compile_module(context_t *context)
+{
+  const options_t *options = context->options;
+  context->errors = 0;
+  context->opened = false;
+  errors_count = 0;
+  error_path = context->label;
+  FILE *input_file = strcmp(context->input_path, "-") == 0 ? stdin : fopen(context->input_path, "r");
+  if (!input_file) {
+    report(context, "Input file could not be opened.");
+    return false;
+  }
+  // A saída é escrita sequencialmente, de uma só vez, ao final da compilação
+  FILE *output_file = strcmp(context->output_path, "-") == 0 ? stdout :
+                      fopen(context->output_path, options->format == output_format_object ? "wb" : "w");
+  if (!output_file) {
+    report(context, "Output file could not be created.");
+    if (input_file != stdin)
+      fclose(input_file);
+    return false;
+  }
+  context->opened = true;
+  // Um erro fatal volta para cá: o estado da linha de execução é liberado e os demais módulos seguem normalmente
+  jmp_buf recovery;
+  volatile bool generating = false;
+  if (setjmp(recovery) == 0) {
+    error_recovery = &recovery;
+    if (!initialize_parser(input_file))
+      report(context, "Empty or damaged input file.");
+    else {
+      initialize_layout(options->layout, options->report, options->columns, options->column_count);
+      initialize_backend(output_file, options->format, options->checks);
+      generating = true;
+      parse();
+      finalize_layout(true);
+      finalize_backend();
+    }
+  }
+  else {
+    finalize_parser();
+    finalize_layout(false);
+    // Com erros, “finalize_backend” apenas libera o que foi gerado
+    if (generating)
+      finalize_backend();
+  }
+  error_recovery = NULL;
+  if (input_file != stdin)
+    fclose(input_file);
+  // A escrita vai para o buffer de “stdio”: uma falha (disco cheio, por exemplo) só aparece ao esvaziá-lo
+  bool written = fflush(output_file) == 0 && !ferror(output_file);
+  if (output_file != stdout && fclose(output_file) != 0)
+    written = false;
+  if (!written) {
+    report(context, "Output file could not be written.");
+    errors_count++;
+  }
+  context->errors = errors_count;
+  error_path = NULL;
+  return errors_count == 0;
+}
+
+// Os módulos são tomados um a um, então os grandes não atrasam os pequenos que vêm depois deles
+void *compile_pool(void *argument)
+{
+  pool_t *pool = (pool_t *)argument;
+  unsigned int index;
+  while ((index = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->count)
+    compile_module(&pool->contexts[index]);
+  return NULL;
+}
+
+bool compile_modules(context_t *contexts, unsigned int count)
+{
+  if (count == 0)
+    return true;
+  long processors = sysconf(_SC_NPROCESSORS_ONLN);
+  unsigned int thread_count = processors > 1 ? (unsigned int)processors : 1;
+  if (thread_count > count)
+    thread_count = count;
+  pool_t pool = { .contexts = contexts, .count = count, .next = 0 };
+  // A linha de execução principal também compila; se alguma das demais não puder ser criada, as que existem compilam
+  // os módulos restantes
+  pthread_t threads[thread_count];
+  pthread_attr_t attributes;
+  unsigned int created = 0;
+  if (pthread_attr_init(&attributes) == 0) {
+    pthread_attr_setstacksize(&attributes, COMPILER_STACK_SIZE);
+    while (created + 1 < thread_count && pthread_create(&threads[created], &attributes, compile_pool, &pool) == 0)
+      created++;
+    pthread_attr_destroy(&attributes);
+  }
+  compile_pool(&pool);
+  for (unsigned int index = 0; index < created; index++)
+    pthread_join(threads[index], NULL);
+  bool success = true;
+  for (unsigned int index = 0; index < count; index++)
+    if (!contexts[index].opened || contexts[index].errors > 0)
+      success = false;
+  return success;
+}
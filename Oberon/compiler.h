@@ -0,0 +1,50 @@
+//
+//  compiler.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_compiler_h
+#define Oberon_compiler_h
+
+#include <stdbool.h>
+
+#include "backend.h"
+#include "layout.h"
+
+// Pilha de cada linha de execução: a análise sintática é recursiva e o código executado com “-j” usa a mesma pilha
+#define COMPILER_STACK_SIZE (8 * 1024 * 1024)
+
+// Opções da linha de comando, comuns a todos os módulos
+typedef struct _options {
+  output_format_t format;
+  bool checks;
+  layout_mode_t layout;
+  bool report;
+  const char **columns;
+  unsigned int column_count;
+} options_t;
+
+// Contexto da compilação de um módulo. O estado do analisador léxico, do sintático, da tabela de símbolos, dos átomos,
+// da arena e do gerador de código pertence à linha de execução que compila o módulo (variáveis “__thread”), então cada
+// linha compila um módulo por vez, do início ao fim, sem compartilhar nada com as demais
+typedef struct _context {
+  const char *input_path;   // “-” indica a entrada padrão
+  const char *output_path;  // “-” indica a saída padrão
+  const char *label;        // Prefixo das mensagens ou NULL, quando há um só módulo
+  const options_t *options;
+  unsigned int errors;      // Quantidade de erros encontrados
+  bool opened;              // A entrada foi aberta e a saída, criada
+} context_t;
+
+// Compila um módulo na linha de execução corrente e retorna se os seus arquivos foram abertos, a saída foi escrita e não
+// houve erros
+bool compile_module(context_t *context);
+
+// Compila os módulos em paralelo, com uma linha de execução por processador (no máximo uma por módulo), cada uma
+// tomando o próximo módulo ainda não compilado. Retorna se todos foram abertos e compilados sem erros
+bool compile_modules(context_t *contexts, unsigned int count);
+
+#endif
@@ -0,0 +1,241 @@
+//
+//  dead.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <limits.h>
+#include <stdbool.h>
+
+#include "dead.h"
+#include "backend.h"
+
+#define DEAD_NONE UINT_MAX
+#define DEAD_MANY (UINT_MAX - 1)
+
+typedef struct _dead {
+  ir_t *ir;
+  unsigned int *uses;
+  unsigned int *definitions; // Índice da única definição de cada registrador, DEAD_NONE ou DEAD_MANY
+  unsigned int *pending;     // Registradores que ficaram sem usos
+  unsigned int pending_count;
+  bool changed;
+} dead_t;
+
+static inline void remove_instruction(dead_t *dead, ir_instruction_t *instruction)
+{
+  instruction->opcode = ir_nop;
+  dead->changed = true;
+}
+
+// Apenas instruções sem efeitos além do resultado podem sumir; a divisão por uma variável pode interromper o programa
+static inline bool is_removable(const ir_instruction_t *instruction)
+{
+  switch (instruction->opcode) {
+    case ir_move:
+    case ir_load:
+    case ir_add:
+    case ir_sub:
+    case ir_mul:
+    case ir_shl:
+    case ir_and:
+    case ir_or:
+    case ir_neg:
+    case ir_not:
+    case ir_parameter:
+      return true;
+    case ir_div:
+    case ir_mod:
+      return instruction->b.kind == ir_operand_constant && instruction->b.value != 0;
+    default:
+      return false;
+  }
+}
+
+// A instrução removida deixa de ler os seus operandos, que podem ficar sem usos
+void release_operands(dead_t *dead, const ir_instruction_t *instruction)
+{
+  ir_operand_t operands[2] = { instruction->a, instruction->b };
+  for (unsigned int position = 0; position < 2; position++)
+    if (operands[position].kind == ir_operand_register && --dead->uses[operands[position].value] == 0)
+      dead->pending[dead->pending_count++] = (unsigned int)operands[position].value;
+}
+
+// Marca como inalcançáveis (“ir_nop”) os blocos que nenhum caminho a partir da primeira instrução alcança. “leaders”
+// indica os inícios de blocos
+bool remove_unreachable(dead_t *dead, const bool *leaders)
+{
+  ir_t *ir = dead->ir;
+  unsigned int length = ir->length;
+  bool *reached = (bool *)calloc((size_t)length + 1, sizeof(bool));
+  unsigned int *stack = (unsigned int *)malloc(((size_t)length + 1) * sizeof(unsigned int));
+  if (!reached || !stack) {
+    free(reached);
+    free(stack);
+    return false;
+  }
+  unsigned int count = 0;
+  if (length > 0) {
+    reached[0] = true;
+    stack[count++] = 0;
+  }
+  while (count > 0) {
+    unsigned int index = stack[--count];
+    // Percorre o bloco até o desvio final ou o início do bloco seguinte
+    while (index < length && !is_ir_branch(ir->instructions[index].opcode) && !leaders[index + 1])
+      index++;
+    unsigned int successors[2] = { index + 1, DEAD_NONE };
+    if (index < length && is_ir_branch(ir->instructions[index].opcode)) {
+      successors[1] = ir->instructions[index].dst;
+      if (ir->instructions[index].opcode == ir_jump)
+        successors[0] = DEAD_NONE;
+    }
+    for (unsigned int successor = 0; successor < 2; successor++)
+      if (successors[successor] < length && !reached[successors[successor]]) {
+        reached[successors[successor]] = true;
+        stack[count++] = successors[successor];
+      }
+  }
+  bool live = false;
+  for (unsigned int index = 0; index < length; index++) {
+    if (leaders[index])
+      live = reached[index];
+    if (!live && ir->instructions[index].opcode != ir_nop)
+      remove_instruction(dead, &ir->instructions[index]);
+  }
+  // Um desvio para a instrução seguinte, depois de removido o código entre eles, não desvia nada; o rótulo do destino
+  // deixa de ser usado
+  for (unsigned int index = length; index-- > 0;) {
+    ir_instruction_t *instruction = &ir->instructions[index];
+    if (!is_ir_branch(instruction->opcode) || instruction->dst <= index)
+      continue;
+    unsigned int next = index + 1;
+    while (next < instruction->dst && ir->instructions[next].opcode == ir_nop)
+      next++;
+    if (next != instruction->dst)
+      continue;
+    // A comparação que servia apenas ao desvio removido também sai
+    unsigned int previous = index;
+    while (previous > 0 && ir->instructions[previous - 1].opcode == ir_nop)
+      previous--;
+    if (instruction->opcode == ir_branch && previous > 0 && ir->instructions[previous - 1].opcode == ir_compare &&
+        (next >= length || ir->instructions[next].opcode != ir_branch))
+      remove_instruction(dead, &ir->instructions[previous - 1]);
+    remove_instruction(dead, instruction);
+  }
+  free(reached);
+  free(stack);
+  return true;
+}
+
+// Instruções que podem interromper a execução: a área de dados continua visível depois do erro, por isso uma escrita
+// antes delas não pode ser descartada. Um procedimento chamado também pode ler a escrita
+static inline bool may_trap(const ir_instruction_t *instruction)
+{
+  return instruction->opcode == ir_check || instruction->opcode == ir_call ||
+    ((instruction->opcode == ir_div || instruction->opcode == ir_mod) && !is_removable(instruction));
+}
+
+// Percorre cada bloco de trás para a frente: “written[x]” guarda a posição da escrita seguinte em “x”, se não houver
+// leitura entre elas, “indirect” a da leitura indireta seguinte, que pode ler qualquer elemento de vetor, e “trap” a da
+// instrução seguinte que pode interromper a execução
+bool remove_dead_stores(dead_t *dead, const bool *leaders)
+{
+  ir_t *ir = dead->ir;
+  unsigned int *written = (unsigned int *)malloc(((size_t)MAX_ADDRESS + 1) * sizeof(unsigned int));
+  bool *indexed = create_indexed_map(ir, MAX_ADDRESS + 1);
+  if (!written || !indexed) {
+    free(written);
+    free(indexed);
+    return false;
+  }
+  for (unsigned int address = 0; address <= MAX_ADDRESS; address++)
+    written[address] = DEAD_NONE;
+  unsigned int end = ir->length, indirect = DEAD_NONE, trap = DEAD_NONE;
+  for (unsigned int index = ir->length; index-- > 0;) {
+    ir_instruction_t *instruction = &ir->instructions[index];
+    if (leaders[index + 1] || is_ir_branch(instruction->opcode)) {
+      end = index + 1;
+      indirect = trap = DEAD_NONE;
+    }
+    ir_operand_t a = instruction->a;
+    if (instruction->opcode == ir_load && a.kind == ir_operand_address)
+      written[a.value] = DEAD_NONE;
+    else if (instruction->opcode == ir_load)
+      indirect = index;
+    else if (may_trap(instruction))
+      trap = index;
+    else if (instruction->opcode == ir_store && a.kind == ir_operand_address) {
+      unsigned int next = written[a.value];
+      if (next > index && next < end && next < trap && (!indexed[a.value] || indirect > next)) {
+        release_operands(dead, instruction);
+        remove_instruction(dead, instruction);
+      }
+      else
+        written[a.value] = index;
+    }
+  }
+  free(written);
+  free(indexed);
+  return true;
+}
+
+bool eliminate_dead_code(ir_t *ir)
+{
+  dead_t dead;
+  unsigned int length = ir->length, count = ir->register_count;
+  dead.ir = ir;
+  dead.uses = (unsigned int *)calloc((size_t)count + 1, sizeof(unsigned int));
+  dead.definitions = (unsigned int *)malloc(((size_t)count + 1) * sizeof(unsigned int));
+  // Código inalcançável cria registradores sem instruções, por isso a pilha comporta todos eles, além de um registrador
+  // por escrita removida e dois por instrução removida
+  dead.pending = (unsigned int *)malloc(((size_t)count + (size_t)length * 3 + 1) * sizeof(unsigned int));
+  dead.pending_count = 0;
+  dead.changed = false;
+  bool *leaders = create_leader_map(ir);
+  bool valid = dead.uses && dead.definitions && dead.pending && leaders;
+  if (valid)
+    valid = remove_unreachable(&dead, leaders);
+  if (valid) {
+    for (unsigned int reg = 0; reg < count; reg++)
+      dead.definitions[reg] = DEAD_NONE;
+    for (unsigned int index = 0; index < length; index++) {
+      const ir_instruction_t *instruction = &ir->instructions[index];
+      if (instruction->opcode == ir_nop)
+        continue;
+      if (instruction->a.kind == ir_operand_register)
+        dead.uses[instruction->a.value]++;
+      if (instruction->b.kind == ir_operand_register)
+        dead.uses[instruction->b.value]++;
+      if (!is_ir_branch(instruction->opcode) && instruction->dst < count)
+        dead.definitions[instruction->dst] = dead.definitions[instruction->dst] == DEAD_NONE ? index : DEAD_MANY;
+    }
+    valid = remove_dead_stores(&dead, leaders);
+  }
+  if (valid) {
+    for (unsigned int reg = 0; reg < count; reg++)
+      if (dead.uses[reg] == 0 && dead.definitions[reg] < DEAD_MANY)
+        dead.pending[dead.pending_count++] = reg;
+    while (dead.pending_count > 0) {
+      unsigned int reg = dead.pending[--dead.pending_count];
+      if (dead.definitions[reg] >= DEAD_MANY)
+        continue;
+      ir_instruction_t *instruction = &ir->instructions[dead.definitions[reg]];
+      dead.definitions[reg] = DEAD_NONE;
+      if (!is_removable(instruction))
+        continue;
+      release_operands(&dead, instruction);
+      remove_instruction(&dead, instruction);
+    }
+    if (dead.changed)
+      valid = remove_nops(ir);
+  }
+  free(dead.uses);
+  free(dead.definitions);
+  free(dead.pending);
+  free(leaders);
+  return valid;
+}
@@ -0,0 +1,22 @@
+//
+//  dead.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_dead_h
+#define Oberon_dead_h
+
+#include <stdbool.h>
+
+#include "ir.h"
+
+// Eliminação de código morto sobre a representação intermediária ainda sem blocos: remove os blocos que nenhum
+// caminho a partir do início alcança, os desvios para a instrução seguinte (e, com eles, os seus rótulos), as escritas
+// em variáveis que o mesmo bloco sobrescreve antes de qualquer leitura e as instruções cujos resultados ninguém usa. As variáveis globais são o resultado do módulo, por isso a última
+// escrita de cada uma sempre é mantida
+bool eliminate_dead_code(ir_t *ir);
+
+#endif
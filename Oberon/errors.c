@@ -6,6 +6,9 @@
 //  Copyright (c) 2013 Alvaro Costa Neto. All rights reserved.
 //
 
+// “flockfile” vem do POSIX, fora do C99
+#define _DEFAULT_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -16,16 +19,30 @@
 
 #define ERRORS_BAD_CODE_TOLERANCE 50
 
-unsigned int errors_count = 0;
+__thread unsigned int errors_count = 0;
+__thread const char *error_path = NULL;
+__thread jmp_buf *error_recovery = NULL;
+
+static void abort_compilation()
+{
+	if (error_recovery)
+		longjmp(*error_recovery, 1);
+	exit(EXIT_FAILURE);
+}
 
 // Esta função aponta que um erro aconteceu usando a mensagem de parâmetro
 void mark_at(const error_t error, const position_t position, const char *message, ...)
 {
 	if (error > error_warning)
 		errors_count++;
+	// Com vários módulos compilados ao mesmo tempo, cada mensagem é escrita inteira e identifica o seu arquivo
+	flockfile(stdout);
+	if (error_path)
+		printf("%s: ", error_path);
 	if (errors_count > ERRORS_BAD_CODE_TOLERANCE) {
 		printf("%d errors? That's it. I quit!\n", ERRORS_BAD_CODE_TOLERANCE);
-		exit(EXIT_FAILURE);
+		funlockfile(stdout);
+		abort_compilation();
 	}
 	switch (error) {
 		case error_log:
@@ -51,8 +68,9 @@ void mark_at(const error_t error, const position_t position, const char *message
 	vprintf(message, args);
 	va_end(args);
 	printf("\n");
+	funlockfile(stdout);
 	if (error == error_fatal)
-		exit(EXIT_FAILURE);
+		abort_compilation();
 }
 
 // TODO: Evitar duplicação de código!
@@ -60,9 +78,13 @@ void mark(const error_t error, const char *message, ...)
 {
 	if (error > error_warning)
 		errors_count++;
+	flockfile(stdout);
+	if (error_path)
+		printf("%s: ", error_path);
 	if (errors_count > ERRORS_BAD_CODE_TOLERANCE) {
 		printf("%d errors? That's it. I quit!\n", ERRORS_BAD_CODE_TOLERANCE);
-		exit(EXIT_FAILURE);
+		funlockfile(stdout);
+		abort_compilation();
 	}
 	switch (error) {
 		case error_log:
@@ -88,8 +110,9 @@ void mark(const error_t error, const char *message, ...)
 	vprintf(message, args);
 	va_end(args);
 	printf("\n");
+	funlockfile(stdout);
 	if (error == error_fatal)
-		exit(EXIT_FAILURE);
+		abort_compilation();
 }
 
 void mark_missing(symbol_t symbol)
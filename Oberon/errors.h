@@ -9,6 +9,8 @@
 #ifndef Oberon_errors_h
 #define Oberon_errors_h
 
+#include <setjmp.h>
+
 #include "scanner.h"
 
 typedef enum _error {
@@ -22,6 +24,14 @@ typedef enum _error {
 	error_unknown
 } error_t;
 
+// Quantidade de erros da compilação em andamento e, com vários módulos, o arquivo a que as mensagens se referem
+extern __thread unsigned int errors_count;
+extern __thread const char *error_path;
+
+// Quando definido, um erro fatal (ou o excesso de erros) interrompe apenas a compilação corrente, que volta a este
+// ponto; caso contrário, encerra o programa
+extern __thread jmp_buf *error_recovery;
+
 void mark_at(const error_t error, const position_t position, const char *message, ...);
 void mark(const error_t error, const char *message, ...);
 void mark_missing(symbol_t symbol);
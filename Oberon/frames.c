@@ -0,0 +1,92 @@
+//
+//  frames.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "frames.h"
+
+static inline instruction_t frame_instruction(opcode_t opcode, operand_kind_t dst_kind, int dst,
+                                              operand_kind_t src_kind, int src)
+{
+  instruction_t instruction = { opcode, { dst_kind, dst }, { src_kind, src } };
+  return instruction;
+}
+
+static inline void mark_register(bool *used, operand_t operand)
+{
+  if ((operand.kind == operand_register || operand.kind == operand_indirect) && operand.value >= 0 &&
+      operand.value < REGISTER_INDEX_COUNT)
+    used[operand.value] = true;
+}
+
+bool create_frame(instruction_t **code, unsigned int *length, unsigned int frame_size, unsigned int spill_count,
+                  bool procedure)
+{
+  const instruction_t *body = *code;
+  unsigned int count = *length, saves[REGISTER_INDEX_COUNT], save_count = 0;
+  bool used[REGISTER_INDEX_COUNT] = { false };
+  if (procedure) {
+    for (unsigned int index = 0; index < count; index++) {
+      mark_register(used, body[index].dst);
+      mark_register(used, body[index].src);
+    }
+    for (unsigned int reg = 0; reg < REGISTER_INDEX_COUNT; reg++)
+      if (used[reg])
+        saves[save_count++] = reg;
+  }
+  else
+    spill_count = 0;
+  // Um registro vazio ainda ocupa uma posição, o que limita a profundidade da recursão pelo tamanho da pilha
+  unsigned int slots = spill_count + save_count, shift = 1 + save_count;
+  int size = (int)(slots * SLOT_SIZE + frame_size);
+  if (procedure && size == 0)
+    size = 1;
+  instruction_t *result = (instruction_t *)malloc(((size_t)count + save_count * 2 + 3) * sizeof(instruction_t));
+  if (!result)
+    return false;
+  unsigned int result_length = 0;
+  result[result_length++] = frame_instruction(opcode_enter, operand_immediate, size, operand_none, 0);
+  for (unsigned int save = 0; save < save_count; save++)
+    result[result_length++] = frame_instruction(opcode_store, operand_slot, (int)(spill_count + save) * SLOT_SIZE,
+                                                operand_register, (int)saves[save]);
+  // Os desvios para o fim do corpo passam a apontar para a restauração dos registradores
+  for (unsigned int index = 0; index < count; index++) {
+    instruction_t instruction = body[index];
+    operand_t *operands[] = { &instruction.dst, &instruction.src };
+    for (int side = 0; side < 2; side++)
+      switch (operands[side]->kind) {
+        case operand_spill:
+          if (procedure) {
+            operands[side]->kind = operand_slot;
+            operands[side]->value *= SLOT_SIZE;
+          }
+          break;
+        case operand_frame:
+        case operand_local:
+          operands[side]->value += (int)slots * SLOT_SIZE;
+          break;
+        case operand_label:
+          operands[side]->value += (int)shift;
+          break;
+        default:
+          break;
+      }
+    result[result_length++] = instruction;
+  }
+  if (procedure) {
+    for (unsigned int save = 0; save < save_count; save++)
+      result[result_length++] = frame_instruction(opcode_load, operand_register, (int)saves[save], operand_slot,
+                                                  (int)(spill_count + save) * SLOT_SIZE);
+    result[result_length++] = frame_instruction(opcode_ret, operand_immediate, size, operand_none, 0);
+  }
+  free(*code);
+  *code = result;
+  *length = result_length;
+  return true;
+}
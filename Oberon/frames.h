@@ -0,0 +1,25 @@
+//
+//  frames.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_frames_h
+#define Oberon_frames_h
+
+#include <stdbool.h>
+
+#include "backend.h"
+
+// Monta o registro de ativação de um procedimento (já com os registradores da máquina alocados): “ENTER” no início,
+// a cópia dos registradores usados, que o procedimento precisa preservar, e, no fim, a restauração deles e “RET”. O
+// registro começa pelos grupos de SLOT_SIZE células (“S[FP+n]”) dos registradores que não couberam na máquina e das
+// cópias, seguidos das “frame_size” posições das variáveis locais. No corpo do módulo (“procedure” falso), apenas
+// “ENTER” reserva o espaço das variáveis locais dos procedimentos expandidos, e as posições dos registradores continuam
+// fora
+bool create_frame(instruction_t **code, unsigned int *length, unsigned int frame_size, unsigned int spill_count,
+                  bool procedure);
+
+#endif
@@ -0,0 +1,173 @@
+//
+//  inlining.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <limits.h>
+#include <stdbool.h>
+
+#include "inlining.h"
+#include "backend.h"
+
+// Situação de cada procedimento: ainda não avaliado, não expansível ou o endereço das suas variáveis locais em “ir”
+#define INLINING_UNKNOWN UINT_MAX
+#define INLINING_REJECTED (UINT_MAX - 1)
+
+typedef struct _inlining {
+  ir_t *ir;
+  ir_t *const *procedures;
+  unsigned int procedure_count;
+  unsigned int *bases;
+} inlining_t;
+
+static inline bool is_leaf(const ir_t *ir)
+{
+  for (unsigned int index = 0; index < ir->length; index++)
+    if (ir->instructions[index].opcode == ir_call)
+      return false;
+  return true;
+}
+
+// Procedimento expandido pela chamada (na primeira vez, as suas variáveis locais ganham espaço no fim do registro de
+// ativação) ou nulo se ela for mantida. Instâncias diferentes nunca estão ativas ao mesmo tempo e dividem o espaço
+const ir_t *inlined_callee(inlining_t *inlining, const ir_instruction_t *instruction)
+{
+  unsigned int callee = (unsigned int)instruction->a.value;
+  if (instruction->opcode != ir_call || callee >= inlining->procedure_count)
+    return NULL;
+  ir_t *ir = inlining->ir;
+  const ir_t *procedure = inlining->procedures[callee];
+  if (inlining->bases[callee] == INLINING_UNKNOWN) {
+    inlining->bases[callee] = INLINING_REJECTED;
+    if (procedure == ir || procedure->length > INLINING_MAX_LENGTH || !is_leaf(procedure) ||
+        (size_t)ir->frame_base + ir->frame_size + procedure->frame_size > (size_t)MAX_ADDRESS + 1)
+      return NULL;
+    unsigned int base = ir->frame_base + ir->frame_size;
+    ir->frame_size += procedure->frame_size;
+    // Os vetores locais acessados com índices variáveis continuam sendo trechos da área de dados, agora em “ir”
+    for (unsigned int range = 0; range < procedure->indexed_count; range++) {
+      unsigned int first = procedure->indexed[range].first;
+      if (is_frame_address(procedure, (int)first))
+        first = first - procedure->frame_base + base;
+      if (!write_indexed_range(ir, first, procedure->indexed[range].length))
+        return NULL;
+    }
+    inlining->bases[callee] = base;
+  }
+  return inlining->bases[callee] == INLINING_REJECTED ? NULL : procedure;
+}
+
+// Operando do procedimento expandido: os registradores dos parâmetros dão lugar aos operandos da chamada, os demais
+// são renumerados e as variáveis locais passam para o registro de ativação de quem chama
+static inline ir_operand_t relocated(ir_operand_t operand, const ir_t *procedure, unsigned int base,
+                                     const ir_operand_t *substitutes)
+{
+  if (operand.kind == ir_operand_register)
+    return substitutes[operand.value];
+  if (operand.kind == ir_operand_address && is_frame_address(procedure, operand.value))
+    operand.value = operand.value - (int)procedure->frame_base + (int)base;
+  return operand;
+}
+
+// Copia o procedimento para “code” no lugar da chamada. Os “ir_argument” que a precedem já foram copiados e viram “NOP”
+bool expand_call(inlining_t *inlining, const ir_t *procedure, unsigned int base, ir_instruction_t *code,
+                 unsigned int start, const ir_instruction_t *arguments, unsigned int argument_count,
+                 ir_instruction_t *copies)
+{
+  ir_t *ir = inlining->ir;
+  ir_operand_t *substitutes = (ir_operand_t *)malloc(((size_t)procedure->register_count + 1) * sizeof(ir_operand_t));
+  if (!substitutes)
+    return false;
+  unsigned int offset = ir->register_count;
+  ir->register_count += procedure->register_count;
+  for (unsigned int reg = 0; reg < procedure->register_count; reg++)
+    substitutes[reg] = ir_operand(ir_operand_register, (int)(reg + offset));
+  // Um parâmetro sem argumento (a quantidade já foi apontada como erro) vale zero
+  for (unsigned int index = 0; index < procedure->length; index++) {
+    const ir_instruction_t *instruction = &procedure->instructions[index];
+    if (instruction->opcode != ir_parameter || instruction->dst >= procedure->register_count)
+      continue;
+    substitutes[instruction->dst] = ir_operand(ir_operand_constant, 0);
+    for (unsigned int argument = 0; argument < argument_count; argument++)
+      if (arguments[argument].b.value == instruction->a.value)
+        substitutes[instruction->dst] = arguments[argument].a;
+  }
+  for (unsigned int index = 0; index < argument_count; index++)
+    copies[index].opcode = ir_nop;
+  for (unsigned int index = 0; index < procedure->length; index++) {
+    ir_instruction_t *instruction = &code[start + index];
+    *instruction = procedure->instructions[index];
+    if (instruction->opcode == ir_parameter) {
+      instruction->opcode = ir_nop;
+      continue;
+    }
+    instruction->a = relocated(instruction->a, procedure, base, substitutes);
+    instruction->b = relocated(instruction->b, procedure, base, substitutes);
+    if (is_ir_branch(instruction->opcode))
+      instruction->dst += start;
+    else if (instruction->dst < procedure->register_count)
+      instruction->dst += offset;
+  }
+  free(substitutes);
+  return true;
+}
+
+bool inline_calls(ir_t *ir, ir_t *const *procedures, unsigned int procedure_count)
+{
+  if (procedure_count == 0)
+    return true;
+  inlining_t inlining = { ir, procedures, procedure_count, NULL };
+  unsigned int length = ir->length;
+  inlining.bases = (unsigned int *)malloc((size_t)procedure_count * sizeof(unsigned int));
+  unsigned int *map = (unsigned int *)malloc(((size_t)length + 1) * sizeof(unsigned int));
+  if (!inlining.bases || !map) {
+    free(inlining.bases);
+    free(map);
+    return false;
+  }
+  for (unsigned int index = 0; index < procedure_count; index++)
+    inlining.bases[index] = INLINING_UNKNOWN;
+  // Primeiro as posições: cada chamada expandida ocupa o tamanho do procedimento
+  size_t count = 0;
+  bool expanded = false;
+  for (unsigned int index = 0; index < length; index++) {
+    map[index] = (unsigned int)count;
+    const ir_t *procedure = inlined_callee(&inlining, &ir->instructions[index]);
+    count += procedure ? procedure->length : 1;
+    expanded = expanded || procedure;
+  }
+  map[length] = (unsigned int)count;
+  ir_instruction_t *code = expanded ? (ir_instruction_t *)malloc((count + 1) * sizeof(ir_instruction_t)) : NULL;
+  bool valid = !expanded || code;
+  for (unsigned int index = 0; index < length && expanded && valid; index++) {
+    const ir_instruction_t *instruction = &ir->instructions[index];
+    const ir_t *procedure = inlined_callee(&inlining, instruction);
+    if (!procedure) {
+      code[map[index]] = *instruction;
+      if (is_ir_branch(instruction->opcode) && instruction->dst <= length)
+        code[map[index]].dst = map[instruction->dst];
+      continue;
+    }
+    unsigned int first = index;
+    while (first > 0 && index - first < MAX_PARAMETERS && ir->instructions[first - 1].opcode == ir_argument)
+      first--;
+    valid = expand_call(&inlining, procedure, inlining.bases[instruction->a.value], code, map[index],
+                        &ir->instructions[first], index - first, &code[map[first]]);
+  }
+  if (expanded && valid) {
+    free(ir->instructions);
+    ir->instructions = code;
+    ir->length = (unsigned int)count;
+    ir->capacity = (unsigned int)count + 1;
+    valid = remove_nops(ir);
+  }
+  else
+    free(code);
+  free(inlining.bases);
+  free(map);
+  return valid;
+}
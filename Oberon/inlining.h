@@ -0,0 +1,24 @@
+//
+//  inlining.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_inlining_h
+#define Oberon_inlining_h
+
+#include <stdbool.h>
+
+#include "ir.h"
+
+// Representações intermediárias de até INLINING_MAX_LENGTH instruções e sem chamadas podem ser expandidas
+#define INLINING_MAX_LENGTH 40
+
+// Expande, na representação intermediária ainda sem blocos, as chamadas a procedimentos pequenos que não chamam outros
+// procedimentos (“procedures” é indexado pelo número do procedimento). Os parâmetros do procedimento expandido são
+// substituídos pelos da chamada e as suas variáveis locais passam para o fim do registro de ativação de “ir”
+bool inline_calls(ir_t *ir, ir_t *const *procedures, unsigned int procedure_count);
+
+#endif
@@ -0,0 +1,252 @@
+//
+//  ir.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "ir.h"
+#include "errors.h"
+
+#define IR_INITIAL_CAPACITY 1024
+
+const char *ir_mnemonics[] = {
+  "NOP", "MOVE", "LOAD", "STORE", "ADD", "SUB", "MUL", "DIV", "MOD", "SHL", "AND", "OR", "NEG", "NOT", "CMP", "BRANCH",
+  "JUMP", "CHECK", "PARAM", "ARG", "CALL"
+};
+
+void initialize_ir(ir_t *ir)
+{
+  ir->instructions = NULL;
+  ir->length = 0;
+  ir->capacity = 0;
+  ir->blocks = NULL;
+  ir->block_count = 0;
+  ir->register_count = 0;
+  ir->indexed = NULL;
+  ir->indexed_count = 0;
+  ir->indexed_capacity = 0;
+  ir->frame_base = 0;
+  ir->frame_size = 0;
+}
+
+void clear_ir(ir_t *ir)
+{
+  free(ir->instructions);
+  free(ir->blocks);
+  free(ir->indexed);
+  initialize_ir(ir);
+}
+
+unsigned int create_register(ir_t *ir)
+{
+  return ir->register_count++;
+}
+
+// Acrescenta uma instrução ao final do vetor, dobrando a capacidade quando necessário
+ir_instruction_t *write_ir(ir_t *ir, ir_opcode_t opcode, unsigned int dst, ir_operand_t a, ir_operand_t b)
+{
+  if (ir->length == ir->capacity) {
+    unsigned int capacity = ir->capacity ? ir->capacity * 2 : IR_INITIAL_CAPACITY;
+    ir_instruction_t *larger = (ir_instruction_t *)realloc(ir->instructions, capacity * sizeof(ir_instruction_t));
+    if (!larger) {
+      mark_not_enough_memory();
+      return NULL;
+    }
+    ir->instructions = larger;
+    ir->capacity = capacity;
+  }
+  ir_instruction_t *instruction = &ir->instructions[ir->length++];
+  instruction->opcode = (unsigned char)opcode;
+  instruction->condition = symbol_null;
+  instruction->dst = dst;
+  instruction->a = a;
+  instruction->b = b;
+  return instruction;
+}
+
+// Um mesmo vetor costuma ser indexado muitas vezes, por isso apenas os trechos distintos são guardados
+bool write_indexed_range(ir_t *ir, unsigned int first, unsigned int length)
+{
+  for (unsigned int index = ir->indexed_count; index > 0; index--)
+    if (ir->indexed[index - 1].first == first && ir->indexed[index - 1].length == length)
+      return true;
+  if (ir->indexed_count == ir->indexed_capacity) {
+    unsigned int capacity = ir->indexed_capacity ? ir->indexed_capacity * 2 : 16;
+    ir_range_t *larger = (ir_range_t *)realloc(ir->indexed, capacity * sizeof(ir_range_t));
+    if (!larger) {
+      mark_not_enough_memory();
+      return false;
+    }
+    ir->indexed = larger;
+    ir->indexed_capacity = capacity;
+  }
+  ir->indexed[ir->indexed_count].first = first;
+  ir->indexed[ir->indexed_count++].length = length;
+  return true;
+}
+
+// Marca, em um vetor de “size” posições (alocado com “calloc”), os endereços dos trechos acessados indiretamente
+bool *create_indexed_map(const ir_t *ir, unsigned int size)
+{
+  bool *indexed = (bool *)calloc(size, sizeof(bool));
+  if (!indexed)
+    return NULL;
+  for (unsigned int range = 0; range < ir->indexed_count; range++)
+    for (unsigned int address = ir->indexed[range].first;
+         address < ir->indexed[range].first + ir->indexed[range].length && address < size; address++)
+      indexed[address] = true;
+  return indexed;
+}
+
+// Marca os inícios de blocos básicos na representação ainda sem blocos: a primeira instrução, os destinos de desvios e
+// as instruções logo após desvios. O vetor (alocado com “calloc”) tem “length + 2” posições, e a posição “length”
+// (o fim do módulo) também é marcada
+bool *create_leader_map(const ir_t *ir)
+{
+  unsigned int length = ir->length;
+  bool *leaders = (bool *)calloc((size_t)length + 2, sizeof(bool));
+  if (!leaders)
+    return NULL;
+  leaders[0] = leaders[length] = true;
+  for (unsigned int index = 0; index < length; index++)
+    if (is_ir_branch(ir->instructions[index].opcode)) {
+      if (ir->instructions[index].dst <= length)
+        leaders[ir->instructions[index].dst] = true;
+      leaders[index + 1] = true;
+    }
+  return leaders;
+}
+
+// Remove as instruções anuladas pelas otimizações (“ir_nop”) e corrige os destinos dos desvios, que ainda são índices
+// de instruções: um desvio para uma instrução removida passa a apontar para a seguinte
+bool remove_nops(ir_t *ir)
+{
+  unsigned int length = ir->length, kept = 0;
+  unsigned int *map = (unsigned int *)malloc(((size_t)length + 1) * sizeof(unsigned int));
+  if (!map)
+    return false;
+  for (unsigned int index = 0; index < length; index++) {
+    map[index] = kept;
+    if (ir->instructions[index].opcode != ir_nop)
+      ir->instructions[kept++] = ir->instructions[index];
+  }
+  map[length] = kept;
+  for (unsigned int index = 0; index < kept; index++)
+    if (is_ir_branch(ir->instructions[index].opcode) && ir->instructions[index].dst <= length)
+      ir->instructions[index].dst = map[ir->instructions[index].dst];
+  ir->length = kept;
+  free(map);
+  return true;
+}
+
+// Durante a construção, os destinos dos desvios são índices de instruções; aqui eles passam a ser índices de blocos
+bool build_blocks(ir_t *ir)
+{
+  unsigned int length = ir->length;
+  unsigned int *block_of = (unsigned int *)calloc((size_t)length + 1, sizeof(unsigned int));
+  bool *leaders = (bool *)calloc((size_t)length + 1, sizeof(bool));
+  if (!block_of || !leaders) {
+    free(block_of);
+    free(leaders);
+    return false;
+  }
+  leaders[0] = true;
+  for (unsigned int index = 0; index < length; index++)
+    if (is_ir_branch(ir->instructions[index].opcode)) {
+      if (ir->instructions[index].dst <= length)
+        leaders[ir->instructions[index].dst] = true;
+      leaders[index + 1] = true;
+    }
+  unsigned int count = 0;
+  for (unsigned int index = 0; index < length; index++) {
+    if (leaders[index])
+      count++;
+    block_of[index] = count - 1;
+  }
+  block_of[length] = count;
+  free(ir->blocks);
+  ir->blocks = (ir_block_t *)malloc(((size_t)count + 1) * sizeof(ir_block_t));
+  ir->block_count = count;
+  if (!ir->blocks) {
+    free(block_of);
+    free(leaders);
+    return false;
+  }
+  for (unsigned int index = 0; index < length; index++) {
+    ir_block_t *block = &ir->blocks[block_of[index]];
+    if (leaders[index]) {
+      block->first = index;
+      block->length = 0;
+    }
+    block->length++;
+  }
+  for (unsigned int block = 0; block < count; block++) {
+    ir_instruction_t *last = &ir->instructions[ir->blocks[block].first + ir->blocks[block].length - 1];
+    ir->blocks[block].successors[0] = last->opcode == ir_jump ? IR_NO_BLOCK : block + 1;
+    ir->blocks[block].successors[1] = IR_NO_BLOCK;
+    if (is_ir_branch(last->opcode)) {
+      last->dst = last->dst <= length ? block_of[last->dst] : count;
+      ir->blocks[block].successors[1] = last->dst;
+    }
+  }
+  free(block_of);
+  free(leaders);
+  return true;
+}
+
+void print_ir_operand(FILE *file, ir_operand_t operand, bool memory)
+{
+  switch (operand.kind) {
+    case ir_operand_register: fprintf(file, memory ? "[v%d]" : "v%d", operand.value); break;
+    case ir_operand_constant: fprintf(file, "%d", operand.value); break;
+    case ir_operand_address: fprintf(file, memory ? "[%.4X]" : "@%.4X", operand.value); break;
+    default: break;
+  }
+}
+
+// Escreve a representação intermediária em texto, bloco a bloco (após “build_blocks”)
+void print_ir(FILE *file, const ir_t *ir)
+{
+  for (unsigned int block = 0; block < ir->block_count; block++) {
+    fprintf(file, "B%u:\n", block);
+    for (unsigned int index = ir->blocks[block].first; index < ir->blocks[block].first + ir->blocks[block].length; index++) {
+      const ir_instruction_t *instruction = &ir->instructions[index];
+      fputc('\t', file);
+      if (is_ir_branch(instruction->opcode)) {
+        fputs(ir_mnemonics[instruction->opcode], file);
+        if (instruction->opcode == ir_branch)
+          fprintf(file, " %s", id_for_symbol((symbol_t)instruction->condition));
+        fprintf(file, " B%u\n", instruction->dst);
+        continue;
+      }
+      if (instruction->dst != IR_NO_REGISTER)
+        fprintf(file, "v%u = ", instruction->dst);
+      fputs(ir_mnemonics[instruction->opcode], file);
+      if (instruction->opcode == ir_call) {
+        fprintf(file, " P%d\n", instruction->a.value);
+        continue;
+      }
+      if (instruction->a.kind != ir_operand_none) {
+        fputc(' ', file);
+        print_ir_operand(file, instruction->a, instruction->opcode == ir_load || instruction->opcode == ir_store);
+      }
+      if (instruction->b.kind != ir_operand_none) {
+        fputs(", ", file);
+        print_ir_operand(file, instruction->b, false);
+      }
+      // Uma verificação que perdeu um dos limites mostra apenas o que restou
+      if (instruction->opcode == ir_check && instruction->condition == IR_CHECK_LOWER)
+        fputs(" (lower)", file);
+      else if (instruction->opcode == ir_check && instruction->condition == IR_CHECK_UPPER)
+        fputs(" (upper)", file);
+      fputc('\n', file);
+    }
+  }
+  fprintf(file, "B%u:\n", ir->block_count);
+}
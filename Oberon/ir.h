@@ -0,0 +1,127 @@
+//
+//  ir.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_ir_h
+#define Oberon_ir_h
+
+#include <stdio.h>
+#include <limits.h>
+#include <stdbool.h>
+
+#include "scanner.h"
+
+// Representação intermediária de três endereços. O gerador de código (“backend.c”) a constrói durante a análise
+// sintática e, ao final, ela é dividida em blocos básicos e traduzida para as instruções da máquina alvo (ver
+// “lowering.h”). Cada valor calculado recebe um registrador virtual novo; constantes e endereços de dados aparecem
+// diretamente como operandos. O corpo do módulo e cada procedimento têm a sua própria representação; as variáveis
+// locais recebem endereços logo após as globais e só no fim passam a ser posições do registro de ativação
+typedef enum _ir_opcode {
+  ir_nop,
+  ir_move,    // dst ← a
+  ir_load,    // dst ← memória[a]
+  ir_store,   // memória[a] ← b
+  ir_add,     // dst ← a + b
+  ir_sub,     // dst ← a - b
+  ir_mul,     // dst ← a * b
+  ir_div,     // dst ← a div b
+  ir_mod,     // dst ← a mod b
+  ir_shl,     // dst ← a deslocado b bits para a esquerda (b é sempre uma constante)
+  ir_and,     // dst ← a & b
+  ir_or,      // dst ← a or b
+  ir_neg,     // dst ← -a
+  ir_not,     // dst ← ~a
+  ir_compare, // compara a e b para o desvio seguinte
+  ir_branch,  // desvia para o bloco “dst” se a última comparação satisfizer “condition”
+  ir_jump,    // desvia para o bloco “dst”
+  ir_check,    // interrompe a execução se “a” estiver fora de [0, b); “condition” indica os limites verificados
+  ir_parameter, // dst ← parâmetro “a” recebido pelo procedimento (sempre no início do procedimento)
+  ir_argument,  // “a” é o parâmetro “b” da chamada seguinte
+  ir_call       // chama o procedimento “a”, cujos parâmetros são os “ir_argument” imediatamente anteriores
+} ir_opcode_t;
+
+// Limites verificados por “ir_check”; a análise de faixas remove os que sempre valem
+#define IR_CHECK_LOWER 1
+#define IR_CHECK_UPPER 2
+
+typedef enum _ir_operand_kind {
+  ir_operand_none,
+  ir_operand_register, // Registrador virtual
+  ir_operand_constant,
+  ir_operand_address   // Endereço de dados; em “ir_load” e “ir_store”, a própria posição de memória
+} ir_operand_kind_t;
+
+typedef struct _ir_operand {
+  ir_operand_kind_t kind;
+  int value;
+} ir_operand_t;
+
+// As instruções ficam em um único vetor, sem ponteiros, e os blocos apenas delimitam trechos dele
+typedef struct _ir_instruction {
+  unsigned char opcode;    // ir_opcode_t
+  unsigned char condition; // symbol_t da comparação em “ir_branch”; limites verificados em “ir_check”
+  unsigned int dst;        // Registrador virtual de destino ou, nos desvios, o destino
+  ir_operand_t a, b;
+} ir_instruction_t;
+
+// Um bloco básico começa em um destino de desvio (ou logo após um desvio) e termina no próximo desvio. “successors”
+// guarda o bloco seguinte no código e o destino do desvio final; IR_NO_BLOCK indica a ausência de um deles. O índice
+// “block_count” representa o fim do módulo
+typedef struct _ir_block {
+  unsigned int first, length;
+  unsigned int successors[2];
+} ir_block_t;
+
+// Trecho da área de dados (um vetor) que é acessado com índices variáveis e, portanto, por “ir_load” e “ir_store”
+// indiretos
+typedef struct _ir_range {
+  unsigned int first, length;
+} ir_range_t;
+
+typedef struct _ir {
+  ir_instruction_t *instructions;
+  unsigned int length, capacity;
+  ir_block_t *blocks;
+  unsigned int block_count;
+  unsigned int register_count; // Quantidade de registradores virtuais usados
+  ir_range_t *indexed;         // Trechos distintos acessados indiretamente
+  unsigned int indexed_count, indexed_capacity;
+  unsigned int frame_base;     // Os endereços de “frame_base” a “frame_base + frame_size” são do registro de ativação
+  unsigned int frame_size;
+} ir_t;
+
+#define IR_NO_REGISTER UINT_MAX
+#define IR_NO_BLOCK UINT_MAX
+
+static inline ir_operand_t ir_operand(ir_operand_kind_t kind, int value)
+{
+  ir_operand_t operand = { kind, value };
+  return operand;
+}
+
+static inline bool is_ir_branch(unsigned char opcode)
+{
+  return opcode == ir_branch || opcode == ir_jump;
+}
+
+static inline bool is_frame_address(const ir_t *ir, int address)
+{
+  return address >= (int)ir->frame_base && address < (int)(ir->frame_base + ir->frame_size);
+}
+
+void initialize_ir(ir_t *ir);
+void clear_ir(ir_t *ir);
+unsigned int create_register(ir_t *ir);
+ir_instruction_t *write_ir(ir_t *ir, ir_opcode_t opcode, unsigned int dst, ir_operand_t a, ir_operand_t b);
+bool write_indexed_range(ir_t *ir, unsigned int first, unsigned int length);
+bool *create_indexed_map(const ir_t *ir, unsigned int size);
+bool *create_leader_map(const ir_t *ir);
+bool remove_nops(ir_t *ir);
+bool build_blocks(ir_t *ir);
+void print_ir(FILE *file, const ir_t *ir);
+
+#endif
@@ -0,0 +1,505 @@
+//
+//  jit.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+// “MAP_ANONYMOUS” é uma extensão do sistema, fora do POSIX
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "jit.h"
+#include "native.h"
+
+#ifdef JIT_AVAILABLE
+#include <sys/mman.h>
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+// Maior quantidade de bytes de código x86-64 gerada para uma única instrução (com folga)
+#define JIT_MAX_INSTRUCTION_SIZE 32
+#define JIT_PROLOGUE_SIZE 64
+
+// Mesmo mapeamento de “native.c”, agora com os números dos registradores x86-64:
+//
+//   R0 a R10    ebx (3), ecx (1), esi (6), edi (7), r8d a r10d (8 a 10) e r12d a r15d (12 a 15)
+//   S0, S1...   memória, logo após a área de dados
+//   eax, edx    temporários; r11d guarda divisores constantes
+//   rbp         endereço da área de dados (recebido em “rdi”)
+//   A0, A1, A2  eax, edx e r11d; os demais parâmetros ficam em memória, logo após a área de dados
+//   FP          r15d, quando há registros de ativação (“[rbp + r15 * escala + deslocamento]”)
+//
+// Como as posições dos registradores em memória ficam junto com os dados, todo acesso à memória é feito em relação a
+// “rbp”. Com “word_t” de 64 bits, as operações sobre registradores levam o prefixo REX.W; os endereços contam
+// posições de “value_t” e são multiplicados pela escala do byte SIB (ou, nos endereços fixos, já no deslocamento)
+static const unsigned char hardware_registers[NATIVE_REGISTER_COUNT] = { 3, 1, 6, 7, 8, 9, 10, 12, 13, 14, 15 };
+
+#define RAX 0
+#define RDX 2
+#define R11 11
+#define R15 15
+
+#define JIT_ARGUMENT_REGISTERS 3
+static const unsigned char argument_registers[JIT_ARGUMENT_REGISTERS] = { RAX, RDX, R11 };
+
+// Indicadores somados ao código da operação: prefixo REX.W (operandos de 64 bits) ou 0x66 (operandos de 16 bits)
+#define JIT_WIDE 0x10000
+#define JIT_SHORT 0x20000
+#if WORD_BITS == 64
+#define JIT_WORD(opcode) ((opcode) | JIT_WIDE)
+#else
+#define JIT_WORD(opcode) (opcode)
+#endif
+
+// Leitura com extensão do sinal e escrita de um “value_t”; “log2” do seu tamanho é a escala dos índices
+#if VALUE_BITS == 8
+#define JIT_LOAD_VALUE JIT_WORD(0x0FBE)
+#define JIT_STORE_VALUE 0x88
+#define JIT_SCALE 0
+#elif VALUE_BITS == 16
+#define JIT_LOAD_VALUE JIT_WORD(0x0FBF)
+#define JIT_STORE_VALUE (0x89 | JIT_SHORT)
+#define JIT_SCALE 1
+#elif VALUE_BITS == 32
+#define JIT_LOAD_VALUE 0x8B
+#define JIT_STORE_VALUE 0x89
+#define JIT_SCALE 2
+#else
+#define JIT_LOAD_VALUE (0x8B | JIT_WIDE)
+#define JIT_STORE_VALUE (0x89 | JIT_WIDE)
+#define JIT_SCALE 3
+#endif
+
+// Códigos das operações “r/m32, r32”; a forma “r32, r/m32” é sempre o código seguinte mais dois
+#define JIT_ADD 0x01
+#define JIT_OR 0x09
+#define JIT_AND 0x21
+#define JIT_SUB 0x29
+#define JIT_CMP 0x39
+#define JIT_MOV 0x89
+
+// Operando “r/m”: um registrador, a posição “[rbp + deslocamento]”, a posição “[rbp + rax * escala]” ou a posição
+// “[rbp + r15 * escala + deslocamento]” (“framed”). Os deslocamentos já estão em bytes
+typedef struct _jit_operand {
+  bool is_register;
+  bool indexed;
+  bool framed;
+  unsigned char reg;
+  int displacement;
+} jit_operand_t;
+
+__thread unsigned char *jit_code = NULL;
+__thread size_t jit_size = 0;
+
+// Deslocamentos dos desvios a corrigir e o índice da instrução de destino de cada um
+typedef struct _jit_fixup {
+  size_t position;
+  unsigned int target;
+} jit_fixup_t;
+
+static inline void emit_byte(unsigned char byte)
+{
+  jit_code[jit_size++] = byte;
+}
+
+static inline void emit_u32(uint32_t value)
+{
+  emit_byte(value & 0xFF);
+  emit_byte((value >> 8) & 0xFF);
+  emit_byte((value >> 16) & 0xFF);
+  emit_byte(value >> 24);
+}
+
+static inline jit_operand_t hardware_operand(unsigned char reg)
+{
+  jit_operand_t operand = { true, false, false, reg, 0 };
+  return operand;
+}
+
+static inline jit_operand_t memory_operand(int displacement)
+{
+  jit_operand_t operand = { false, false, false, 0, displacement };
+  return operand;
+}
+
+static inline jit_operand_t indexed_operand()
+{
+  jit_operand_t operand = { false, true, false, 0, 0 };
+  return operand;
+}
+
+static inline jit_operand_t frame_operand(int displacement)
+{
+  jit_operand_t operand = { false, false, true, 0, displacement * (int)sizeof(value_t) };
+  return operand;
+}
+
+static inline jit_operand_t data_operand(int address)
+{
+  return memory_operand(address * (int)sizeof(value_t));
+}
+
+static inline jit_operand_t virtual_operand(int index)
+{
+  return hardware_operand(hardware_registers[index]);
+}
+
+static inline jit_operand_t spill_operand(int slot)
+{
+  return memory_operand(JIT_SPILL_OFFSET + slot * (int)sizeof(word_t));
+}
+
+static inline jit_operand_t argument_operand(int index)
+{
+  if (index < JIT_ARGUMENT_REGISTERS)
+    return hardware_operand(argument_registers[index]);
+  return memory_operand(JIT_ARGUMENT_OFFSET + (index - JIT_ARGUMENT_REGISTERS) * (int)sizeof(word_t));
+}
+
+// A alocação de registradores garante que só R0 a R10 apareçam no código
+static inline bool is_native_register(operand_t operand)
+{
+  return (operand.kind != operand_register && operand.kind != operand_indirect && operand.kind != operand_argument) ||
+    (operand.value >= 0 && operand.value < (operand.kind == operand_argument ? MAX_PARAMETERS : NATIVE_REGISTER_COUNT));
+}
+
+// Emite os prefixos 0x66 e REX (quando necessários), o código da operação (de um ou dois bytes), o byte ModRM e,
+// conforme o operando, o byte SIB e o deslocamento. Com “byte_register”, o registrador do campo “reg” é de 8 bits e os
+// de índice 4 a 7 exigem o prefixo REX para que “sil” e “dil” sejam usados em vez de “ah” e “bh”
+void emit_modrm(unsigned int opcode, unsigned char reg, jit_operand_t rm, bool byte_register)
+{
+  if (opcode & JIT_SHORT)
+    emit_byte(0x66);
+  unsigned char rex = 0x40;
+  if (opcode & JIT_WIDE)
+    rex |= 0x08;
+  opcode &= 0xFFFF;
+  if (reg & 8)
+    rex |= 0x04;
+  if (rm.is_register && (rm.reg & 8))
+    rex |= 0x01;
+  if (rm.framed)
+    rex |= 0x02;
+  if (rex != 0x40 || (byte_register && reg >= 4 && reg < 8))
+    emit_byte(rex);
+  if (opcode > 0xFF)
+    emit_byte(opcode >> 8);
+  emit_byte(opcode & 0xFF);
+  if (rm.is_register)
+    emit_byte(0xC0 | (reg & 7) << 3 | (rm.reg & 7));
+  else if (rm.indexed) {
+    emit_byte(0x44 | (reg & 7) << 3);
+    emit_byte(JIT_SCALE << 6 | 0x05);
+    emit_byte(0);
+  }
+  else if (rm.framed) {
+    emit_byte(0x84 | (reg & 7) << 3);
+    emit_byte(JIT_SCALE << 6 | 0x3D);
+    emit_u32((uint32_t)rm.displacement);
+  }
+  else {
+    emit_byte(0x85 | (reg & 7) << 3);
+    emit_u32((uint32_t)rm.displacement);
+  }
+}
+
+// Com “word_t” de 64 bits, a forma “r/m64, imm32” estende o sinal da constante
+void emit_move_immediate(jit_operand_t rm, int value)
+{
+  if (rm.is_register && WORD_BITS == 32) {
+    if (rm.reg & 8)
+      emit_byte(0x41);
+    emit_byte(0xB8 + (rm.reg & 7));
+  }
+  else
+    emit_modrm(JIT_WORD(0xC7), 0, rm, false);
+  emit_u32((uint32_t)value);
+}
+
+// Operação aritmética “r/m32, imm32”; “digit” é a extensão do código da operação no campo “reg”
+void emit_immediate(unsigned char digit, jit_operand_t rm, int value)
+{
+  emit_modrm(JIT_WORD(0x81), digit, rm, false);
+  emit_u32((uint32_t)value);
+}
+
+// Coloca em “rax” o endereço (reduzido a 16 bits) guardado no registrador
+void emit_address(int index)
+{
+  emit_modrm(0x0FB7, RAX, virtual_operand(index), false);
+}
+
+void emit_binary(unsigned char opcode, unsigned char digit, operand_t dst, operand_t src)
+{
+  if (src.kind != operand_register) {
+    if (opcode == JIT_MOV)
+      emit_move_immediate(virtual_operand(dst.value), src.value);
+    else
+      emit_immediate(digit, virtual_operand(dst.value), src.value);
+  }
+  else
+    emit_modrm(JIT_WORD(opcode), hardware_registers[src.value], virtual_operand(dst.value), false);
+}
+
+// Parâmetros: “MOV An, R” (ou imediato) antes da chamada e “MOV R, An” no início do procedimento
+void emit_argument(operand_t dst, operand_t src)
+{
+  if (src.kind == operand_argument)
+    emit_modrm(JIT_WORD(0x8B), hardware_registers[dst.value], argument_operand(src.value), false);
+  else if (src.kind == operand_register)
+    emit_modrm(JIT_WORD(0x89), hardware_registers[src.value], argument_operand(dst.value), false);
+  else
+    emit_move_immediate(argument_operand(dst.value), src.value);
+}
+
+static inline void add_fixup(jit_fixup_t *fixups, size_t *fixup_count, unsigned int target)
+{
+  fixups[*fixup_count].position = jit_size;
+  fixups[*fixup_count].target = target;
+  (*fixup_count)++;
+  emit_u32(0);
+}
+
+// Códigos das condições para “jcc”, na ordem de “opcode_breq” a “opcode_brge”
+static const unsigned char conditions[] = { 0x84, 0x85, 0x8C, 0x8E, 0x8F, 0x8D };
+
+bool emit_instruction(const instruction_t *instruction, unsigned int length, unsigned int data_size,
+                      jit_fixup_t *fixups, size_t *fixup_count)
+{
+  operand_t dst = instruction->dst, src = instruction->src;
+  if (!is_native_register(dst) || !is_native_register(src))
+    return false;
+  switch (instruction->opcode) {
+    case opcode_nop:
+      emit_byte(0x90);
+      break;
+    case opcode_load:
+      if (src.kind == operand_immediate || src.kind == operand_address)
+        emit_move_immediate(virtual_operand(dst.value), src.value);
+      else if (src.kind == operand_spill)
+        emit_modrm(JIT_WORD(0x8B), hardware_registers[dst.value], spill_operand(src.value), false);
+      else if (src.kind == operand_frame)
+        emit_modrm(JIT_LOAD_VALUE, hardware_registers[dst.value], frame_operand(src.value), false);
+      else if (src.kind == operand_slot)
+        emit_modrm(JIT_WORD(0x8B), hardware_registers[dst.value], frame_operand(src.value), false);
+      else if (src.kind == operand_local) {
+        // mov reg, r15d; add reg, deslocamento
+        emit_modrm(JIT_WORD(0x89), R15, virtual_operand(dst.value), false);
+        emit_immediate(0, virtual_operand(dst.value), src.value);
+      }
+      else if (src.kind == operand_direct)
+        emit_modrm(JIT_LOAD_VALUE, hardware_registers[dst.value], data_operand(src.value), false);
+      else {
+        emit_address(src.value);
+        emit_modrm(JIT_LOAD_VALUE, hardware_registers[dst.value], indexed_operand(), false);
+      }
+      break;
+    case opcode_store:
+      if (dst.kind == operand_spill)
+        emit_modrm(JIT_WORD(0x89), hardware_registers[src.value], spill_operand(dst.value), false);
+      else if (dst.kind == operand_direct)
+        emit_modrm(JIT_STORE_VALUE, hardware_registers[src.value], data_operand(dst.value), true);
+      else if (dst.kind == operand_frame)
+        emit_modrm(JIT_STORE_VALUE, hardware_registers[src.value], frame_operand(dst.value), true);
+      else if (dst.kind == operand_slot)
+        emit_modrm(JIT_WORD(0x89), hardware_registers[src.value], frame_operand(dst.value), false);
+      else {
+        emit_address(dst.value);
+        emit_modrm(JIT_STORE_VALUE, hardware_registers[src.value], indexed_operand(), true);
+      }
+      break;
+    case opcode_mov:
+      if (dst.kind == operand_argument || src.kind == operand_argument)
+        emit_argument(dst, src);
+      else
+        emit_binary(JIT_MOV, 0, dst, src);
+      break;
+    case opcode_add: emit_binary(JIT_ADD, 0, dst, src); break;
+    case opcode_or: emit_binary(JIT_OR, 1, dst, src); break;
+    case opcode_and: emit_binary(JIT_AND, 4, dst, src); break;
+    case opcode_sub: emit_binary(JIT_SUB, 5, dst, src); break;
+    case opcode_cmp: emit_binary(JIT_CMP, 7, dst, src); break;
+    case opcode_mul:
+      if (src.kind == operand_register)
+        emit_modrm(JIT_WORD(0x0FAF), hardware_registers[dst.value], virtual_operand(src.value), false);
+      else {
+        emit_modrm(JIT_WORD(0x69), hardware_registers[dst.value], virtual_operand(dst.value), false);
+        emit_u32((uint32_t)src.value);
+      }
+      break;
+    case opcode_div:
+    case opcode_mod:
+      // cdq (cqo com REX.W) estende o sinal de “eax” para “edx”
+      emit_modrm(JIT_WORD(0x8B), RAX, virtual_operand(dst.value), false);
+      if (WORD_BITS == 64)
+        emit_byte(0x48);
+      emit_byte(0x99);
+      if (src.kind == operand_register)
+        emit_modrm(JIT_WORD(0xF7), 7, virtual_operand(src.value), false);
+      else {
+        emit_move_immediate(hardware_operand(R11), src.value);
+        emit_modrm(JIT_WORD(0xF7), 7, hardware_operand(R11), false);
+      }
+      emit_modrm(JIT_WORD(0x89), instruction->opcode == opcode_div ? RAX : RDX, virtual_operand(dst.value), false);
+      break;
+    case opcode_shl:
+      if (src.kind != operand_immediate)
+        return false;
+      emit_modrm(JIT_WORD(0xC1), 4, virtual_operand(dst.value), false);
+      emit_byte((unsigned char)(src.value & (WORD_BITS - 1)));
+      break;
+    case opcode_neg:
+    case opcode_not:
+      emit_modrm(JIT_WORD(0xF7), instruction->opcode == opcode_neg ? 3 : 2, virtual_operand(dst.value), false);
+      break;
+    case opcode_trap:
+      // mov eax, código; jmp para o epílogo, logo após a instrução que zera “eax” no fim normal do módulo
+      if (dst.kind != operand_immediate)
+        return false;
+      emit_byte(0xB8);
+      emit_u32((uint32_t)dst.value);
+      emit_byte(0xE9);
+      add_fixup(fixups, fixup_count, length + 1);
+      break;
+    case opcode_enter:
+      // sub r15d, tamanho; cmp r15d, “data_size”; jl para a rotina de estouro da pilha, após o epílogo
+      if (dst.kind != operand_immediate)
+        return false;
+      emit_immediate(5, hardware_operand(R15), dst.value);
+      emit_immediate(7, hardware_operand(R15), (int)data_size);
+      emit_byte(0x0F);
+      emit_byte(0x8C);
+      add_fixup(fixups, fixup_count, length + 2);
+      break;
+    case opcode_ret:
+      if (dst.kind != operand_immediate)
+        return false;
+      emit_immediate(0, hardware_operand(R15), dst.value);
+      emit_byte(0xC3);
+      break;
+    case opcode_call:
+      if (dst.kind != operand_label || dst.value < 0 || (unsigned int)dst.value > length)
+        return false;
+      emit_byte(0xE8);
+      add_fixup(fixups, fixup_count, (unsigned int)dst.value);
+      break;
+    default:
+      if (dst.kind != operand_label || dst.value < 0 || (unsigned int)dst.value > length)
+        return false;
+      if (instruction->opcode == opcode_jump)
+        emit_byte(0xE9);
+      else {
+        emit_byte(0x0F);
+        emit_byte(conditions[instruction->opcode - opcode_breq]);
+      }
+      add_fixup(fixups, fixup_count, (unsigned int)dst.value);
+      break;
+  }
+  return true;
+}
+
+// Traduz todo o código para o vetor “jit_code”; “offsets” recebe a posição de cada instrução, do epílogo, do ponto do
+// epílogo usado por “TRAP” e da rotina de estouro da pilha. A função gerada retorna o código do erro de execução ou
+// zero
+bool translate(const instruction_t *code, unsigned int length, unsigned int data_size, size_t *offsets)
+{
+  jit_fixup_t *fixups = (jit_fixup_t *)malloc(((size_t)length + 1) * sizeof(jit_fixup_t));
+  if (!fixups)
+    return false;
+  size_t fixup_count = 0;
+  // push rbx, rbp, r12, r13, r14 e r15; mov rbp, rdi
+  static const unsigned char prologue[] = { 0x53, 0x55, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57, 0x48, 0x89, 0xFD };
+  memcpy(jit_code, prologue, sizeof(prologue));
+  jit_size = sizeof(prologue);
+  // mov [rbp + JIT_STACK_OFFSET], rsp
+  emit_byte(0x48);
+  emit_byte(0x89);
+  emit_byte(0xA5);
+  emit_u32(JIT_STACK_OFFSET);
+  bool framed = false;
+  for (unsigned int index = 0; index < length; index++)
+    framed = framed || code[index].opcode == opcode_enter;
+  // A pilha de dados começa no fim da área de dados
+  if (framed)
+    emit_move_immediate(hardware_operand(R15), MAX_ADDRESS + 1);
+  bool valid = true;
+  for (unsigned int index = 0; index < length && valid; index++) {
+    offsets[index] = jit_size;
+    valid = emit_instruction(&code[index], length, data_size, fixups, &fixup_count);
+  }
+  offsets[length] = jit_size;
+  // xor eax, eax
+  emit_byte(0x31);
+  emit_byte(0xC0);
+  offsets[length + 1] = jit_size;
+  // mov rsp, [rbp + JIT_STACK_OFFSET]: descarta os endereços de retorno quando “TRAP” ocorre num procedimento
+  emit_byte(0x48);
+  emit_byte(0x8B);
+  emit_byte(0xA5);
+  emit_u32(JIT_STACK_OFFSET);
+  // pop r15, r14, r13, r12, rbp e rbx; ret
+  static const unsigned char epilogue[] = { 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5D, 0x5B, 0xC3 };
+  memcpy(jit_code + jit_size, epilogue, sizeof(epilogue));
+  jit_size += sizeof(epilogue);
+  // mov eax, trap_stack_overflow; jmp para o epílogo
+  offsets[length + 2] = jit_size;
+  emit_byte(0xB8);
+  emit_u32(trap_stack_overflow);
+  emit_byte(0xE9);
+  emit_u32((uint32_t)(int32_t)(offsets[length + 1] - (jit_size + 4)));
+  // Os deslocamentos dos desvios são relativos ao fim da própria instrução, ou seja, ao fim do campo de 32 bits
+  for (size_t index = 0; index < fixup_count && valid; index++) {
+    int32_t relative = (int32_t)(offsets[fixups[index].target] - (fixups[index].position + 4));
+    size_t saved = jit_size;
+    jit_size = fixups[index].position;
+    emit_u32((uint32_t)relative);
+    jit_size = saved;
+  }
+  free(fixups);
+  return valid;
+}
+
+bool run_jit(const instruction_t *code, unsigned int length, value_t *data, unsigned int data_size, trap_t *trap)
+{
+  size_t capacity = JIT_PROLOGUE_SIZE * 2 + (size_t)length * JIT_MAX_INSTRUCTION_SIZE;
+  size_t *offsets = (size_t *)malloc(((size_t)length + 3) * sizeof(size_t));
+  jit_code = (unsigned char *)malloc(capacity);
+  bool valid = offsets && jit_code && translate(code, length, data_size, offsets);
+  free(offsets);
+  // A memória executável nunca é gravável ao mesmo tempo (W^X): o código é copiado e só então a proteção é trocada
+  void *executable = MAP_FAILED;
+  if (valid) {
+    executable = mmap(NULL, jit_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    valid = executable != MAP_FAILED;
+  }
+  if (valid) {
+    memcpy(executable, jit_code, jit_size);
+    valid = mprotect(executable, jit_size, PROT_READ | PROT_EXEC) == 0;
+  }
+  free(jit_code);
+  jit_code = NULL;
+  if (valid) {
+    int (*module_body)(value_t *) = (int (*)(value_t *))executable;
+    *trap = (trap_t)module_body(data);
+  }
+  if (executable != MAP_FAILED)
+    munmap(executable, jit_size);
+  return valid;
+}
+
+#else
+
+bool run_jit(const instruction_t *code, unsigned int length, value_t *data, unsigned int data_size, trap_t *trap)
+{
+  return false;
+}
+
+#endif
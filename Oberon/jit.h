@@ -0,0 +1,35 @@
+//
+//  jit.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_jit_h
+#define Oberon_jit_h
+
+#include <stdbool.h>
+
+#include "backend.h"
+
+#if defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__))
+#define JIT_AVAILABLE
+#endif
+
+// A área de dados cobre todo o espaço de “address_t” e é seguida pelos parâmetros que não couberam em registradores,
+// pelo ponteiro da pilha salvo na entrada (para que “TRAP” possa sair de dentro de um procedimento) e pelas posições de
+// memória dos registradores que não couberam nos registradores da máquina (um “word_t” cada, ver “registers.h”). Os
+// deslocamentos são em bytes
+#define JIT_ARGUMENT_OFFSET ((MAX_ADDRESS + 1) * (int)sizeof(value_t))
+#define JIT_STACK_OFFSET (JIT_ARGUMENT_OFFSET + MAX_PARAMETERS * (int)sizeof(word_t))
+#define JIT_SPILL_OFFSET (JIT_STACK_OFFSET + 8)
+#define JIT_DATA_SIZE(spill_count) (JIT_SPILL_OFFSET + (spill_count) * sizeof(word_t))
+
+// Traduz o código (já alocado com NATIVE_REGISTER_COUNT registradores) para x86-64 diretamente em memória executável e
+// executa o módulo sobre “data” (com pelo menos JIT_DATA_SIZE(spill_count) bytes). A pilha de dados dos procedimentos
+// não pode descer abaixo de “data_size”. “trap” recebe o erro sinalizado por “TRAP” ou zero. Retorna falso se a
+// plataforma não for suportada ou se o código não puder ser traduzido
+bool run_jit(const instruction_t *code, unsigned int length, value_t *data, unsigned int data_size, trap_t *trap);
+
+#endif
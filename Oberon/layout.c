@@ -0,0 +1,199 @@
+//
+//  layout.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "layout.h"
+#include "errors.h"
+
+__thread layout_mode_t layout_mode = layout_aligned;
+__thread bool layout_report = false;
+__thread const char **column_names = NULL;
+__thread unsigned int column_name_count = 0;
+__thread bool *column_matched = NULL;  // Nomes de “column_names” já encontrados em alguma declaração
+
+void initialize_layout(layout_mode_t mode, bool report, const char **columns, unsigned int column_count)
+{
+  layout_mode = mode;
+  layout_report = report;
+  column_names = columns;
+  column_name_count = column_count;
+  column_matched = NULL;
+  if (column_count > 0 && !(column_matched = (bool *)calloc(column_count, sizeof(bool))))
+    mark_not_enough_memory();
+}
+
+void finalize_layout(bool complete)
+{
+  if (complete && column_matched)
+    for (unsigned int index = 0; index < column_name_count; index++)
+      if (!column_matched[index])
+        mark_at(error_warning, position_zero, "\"%s\" does not name any type, variable or field and was not laid out "
+                "as columns.", column_names[index]);
+  free(column_matched);
+  column_matched = NULL;
+}
+
+// Os alinhamentos são sempre potências de 2
+static inline unsigned long long align_up(unsigned long long value, unsigned int alignment)
+{
+  return (value + alignment - 1) & ~(unsigned long long)(alignment - 1);
+}
+
+static inline unsigned int power_of_two_above(unsigned long long value)
+{
+  unsigned int power = 1;
+  while (power < value)
+    power *= 2;
+  return power;
+}
+
+void layout_array(type_t *type, value_t length, type_t *base, position_t position)
+{
+  if (!type) return;
+  type->length = length;
+  type->base = base;
+  if (!base) return;
+  // Com “value_t” largo, o comprimento sozinho já pode exceder a memória; o tamanho é limitado para não transbordar
+  unsigned long long cells = (unsigned long long)length;
+  if (cells > MAX_ADDRESS + 1 || cells * base->size > MAX_ADDRESS + 1)
+    mark_at(error_parser, position, "Type is too large.");
+  else
+    type->size = (unsigned int)(length * base->size);
+  type->alignment = base->alignment;
+}
+
+// Ordenação por inserção, estável, em ordem decrescente de alinhamento: os registros têm poucos campos
+void sort_fields(entry_t **fields, unsigned int count)
+{
+  for (unsigned int index = 1; index < count; index++) {
+    entry_t *field = fields[index];
+    unsigned int position = index;
+    while (position > 0 && fields[position - 1]->type->alignment < field->type->alignment) {
+      fields[position] = fields[position - 1];
+      position--;
+    }
+    fields[position] = field;
+  }
+}
+
+void report_record(const type_t *type, entry_t **fields, unsigned int count, unsigned long long used,
+                   position_t position)
+{
+  mark_at(error_info, position, "Record of size %u, aligned to %u (%llu cells of padding).", type->size,
+          type->alignment, type->size - used);
+  for (unsigned int index = 0; index < count; index++)
+    mark_at(error_info, fields[index]->position, "Field \"%s\" at offset %u, size %u.",
+            id_for_atom(fields[index]->id), fields[index]->address, fields[index]->type->size);
+}
+
+void layout_record(type_t *type, position_t position)
+{
+  if (!type || !type->fields) return;
+  unsigned int count = 0;
+  for (entry_t *e = type->fields->first; e && e->type; e = e->next)
+    count++;
+  entry_t **fields = (entry_t **)malloc((count + 1) * sizeof(entry_t *));
+  if (!fields) {
+    mark_not_enough_memory();
+    return;
+  }
+  count = 0;
+  for (entry_t *e = type->fields->first; e && e->type; e = e->next)
+    fields[count++] = e;
+  if (layout_mode == layout_reordered)
+    sort_fields(fields, count);
+  // “used” soma apenas os tamanhos dos campos; a diferença para o tamanho final é o preenchimento
+  unsigned long long offset = 0, used = 0;
+  unsigned int alignment = 1;
+  for (unsigned int index = 0; index < count; index++) {
+    const type_t *field_type = fields[index]->type;
+    if (layout_mode != layout_packed) {
+      offset = align_up(offset, field_type->alignment);
+      if (field_type->alignment > alignment)
+        alignment = field_type->alignment;
+    }
+    fields[index]->address = (address_t)offset;
+    offset += field_type->size;
+    used += field_type->size;
+  }
+  if (layout_mode != layout_packed && offset <= LAYOUT_LINE_CELLS && power_of_two_above(offset) > alignment)
+    alignment = power_of_two_above(offset);
+  unsigned long long size = align_up(offset, alignment);
+  if (size > MAX_ADDRESS + 1) {
+    mark_at(error_parser, position, "Type is too large.");
+    size = used = 0;
+  }
+  type->size = (unsigned int)size;
+  type->alignment = alignment;
+  if (layout_report)
+    report_record(type, fields, count, used, position);
+  free(fields);
+}
+
+address_t align_variable(address_t address, const type_t *type, bool global)
+{
+  if (!type || !global || layout_mode == layout_packed)
+    return address;
+  return (address_t)align_up(address, type->alignment);
+}
+
+bool is_column_name(atom_t id)
+{
+  bool found = false;
+  for (unsigned int index = 0; index < column_name_count; index++)
+    if (strcmp(column_names[index], id_for_atom(id)) == 0) {
+      // O mesmo nome pode ter sido dado mais de uma vez
+      if (column_matched)
+        column_matched[index] = true;
+      found = true;
+    }
+  return found;
+}
+
+type_t *declared_type(atom_t id, type_t *type, position_t position)
+{
+  if (!type || type->columns || !is_column_name(id))
+    return type;
+  const type_t *record = type->base;
+  if (type->form != form_array || type->columns || !record || record->form != form_record || !record->fields) {
+    mark_at(error_parser, position, "\"%s\" is not an array of records and cannot be laid out as columns.",
+            id_for_atom(id));
+    return type;
+  }
+  unsigned int count = 0;
+  for (entry_t *e = record->fields->first; e; e = e->next) {
+    if (!e->type || e->type->form != form_atomic) {
+      mark_at(error_parser, position, "The fields of \"%s\" must be atomic to be laid out as columns.",
+              id_for_atom(id));
+      return type;
+    }
+    count++;
+  }
+  type_t *columns = create_type(form_array, type->length, (unsigned int)(count * type->length), NULL, type->base);
+  if (!columns)
+    return type;
+  columns->columns = true;
+  columns->alignment = layout_mode == layout_packed ? 1 : LAYOUT_LINE_CELLS;
+  if (layout_report)
+    mark_at(error_info, position, "\"%s\" laid out as %u columns of %lld cells.", id_for_atom(id), count,
+            (long long)type->length);
+  return columns;
+}
+
+// Os campos atômicos têm deslocamentos distintos, então a coluna de um campo é a quantidade de campos antes dele
+address_t column_offset(const type_t *record, const entry_t *field, value_t length)
+{
+  unsigned int column = 0;
+  for (entry_t *e = record->fields->first; e; e = e->next)
+    if (e->address < field->address)
+      column++;
+  return (address_t)(column * length);
+}
@@ -0,0 +1,70 @@
+//
+//  layout.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_layout_h
+#define Oberon_layout_h
+
+#include <stdbool.h>
+
+#include "backend.h"
+#include "symbol_table.h"
+
+// Tamanho de uma linha de cache, em bytes, e quantas posições de memória (“value_t”) ela contém
+#define LAYOUT_LINE_SIZE 64
+#define LAYOUT_LINE_CELLS ((unsigned int)(LAYOUT_LINE_SIZE / sizeof(value_t)))
+
+// Disposição dos dados na memória. Cada posição guarda um inteiro, então o alinhamento natural de um tipo atômico é
+// sempre uma posição; o que importa é o alinhamento dos agregados:
+//
+//   layout_aligned     um registro que cabe em uma linha de cache é alinhado (e completado) até a menor potência de 2
+//                      que o contém, para que nunca fique dividido entre duas linhas e para que o índice dos vetores
+//                      de registros seja um deslocamento de bits. Os demais herdam o maior alinhamento dos campos
+//   layout_reordered   como “layout_aligned”, mas os campos são dispostos em ordem decrescente de alinhamento (na
+//                      ordem da declaração quando empatam), o que minimiza o preenchimento entre eles
+//   layout_packed      campos e variáveis em sequência, sem preenchimento
+//
+// Vetores herdam o alinhamento dos elementos. As variáveis globais começam em endereços múltiplos do alinhamento do
+// seu tipo; as locais e os parâmetros ficam em sequência, pois a posição do registro de ativação só é conhecida durante
+// a execução.
+//
+// Um vetor de registros com campos atômicos pode ser disposto como estrutura de vetores (“columns” em “type_t”): cada
+// campo ocupa uma coluna de “length” posições seguidas, na ordem dos deslocamentos do registro, e o campo “f” do
+// elemento “i” fica em “coluna(f) * length + i”. Assim, um laço que percorre apenas “a[i].x” lê posições contíguas. Os
+// elementos de um vetor assim não formam registros na memória e não podem ser passados por referência. Essa disposição
+// vale para os tipos, variáveis e campos cujos nomes forem escolhidos; o vetor recebe um tipo próprio, incompatível com
+// o declarado, e fica alinhado a uma linha de cache (exceto com “layout_packed”)
+typedef enum _layout_mode {
+  layout_aligned,
+  layout_reordered,
+  layout_packed
+} layout_mode_t;
+
+// Com “report”, a disposição de cada registro é mostrada (como informação) ao ser calculada. “columns” lista os nomes
+// dispostos como estrutura de vetores e precisa existir até o fim da compilação
+void initialize_layout(layout_mode_t mode, bool report, const char **columns, unsigned int column_count);
+
+// Libera o estado da disposição. Com “complete” (o módulo foi analisado até o fim), cada nome de “columns” que nenhuma
+// declaração usou é apontado como aviso
+void finalize_layout(bool complete);
+
+// Calculam o tamanho e o alinhamento do vetor e do registro (e os deslocamentos dos campos) a partir dos tipos já
+// conhecidos. Um tipo que não cabe na memória é apontado como erro e fica com tamanho zero
+void layout_array(type_t *type, value_t length, type_t *base, position_t position);
+void layout_record(type_t *type, position_t position);
+
+// Endereço em que uma variável global do tipo dado deve começar, a partir do primeiro endereço livre
+address_t align_variable(address_t address, const type_t *type, bool global);
+
+// Tipo da declaração chamada “id”: uma cópia de “type” disposta como estrutura de vetores, se o nome foi escolhido, ou
+// o próprio “type”. Um tipo escolhido que não pode ser disposto assim é apontado como erro
+type_t *declared_type(atom_t id, type_t *type, position_t position);
+
+// Deslocamento da coluna de “field” em uma estrutura de vetores de “length” elementos do registro “record”
+address_t column_offset(const type_t *record, const entry_t *field, value_t length);
+
+#endif
@@ -0,0 +1,289 @@
+//
+//  lowering.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "lowering.h"
+
+// Estado da tradução: o vetor de saída, o registrador da máquina (ainda virtual) de cada registrador da representação
+// intermediária e as contagens usadas para decidir quando o destino pode reaproveitar o registrador do operando
+typedef struct _lowering {
+  const ir_t *ir;
+  instruction_t *code;
+  unsigned int length;
+  unsigned int register_count;
+  unsigned int *map;
+  unsigned int *uses, *definitions, *blocks;
+  unsigned int trap_label; // Rótulo da rotina de erro compartilhada pelas verificações de índices
+  bool trapped;            // Alguma verificação desvia para a rotina de erro
+} lowering_t;
+
+static inline operand_t create_operand(operand_kind_t kind, int value)
+{
+  operand_t operand = { kind, value };
+  return operand;
+}
+
+static inline void emit(lowering_t *lowering, opcode_t opcode, operand_t dst, operand_t src)
+{
+  instruction_t *instruction = &lowering->code[lowering->length++];
+  instruction->opcode = opcode;
+  instruction->dst = dst;
+  instruction->src = src;
+}
+
+static inline operand_t lowered_register(lowering_t *lowering, unsigned int index)
+{
+  return create_operand(operand_register, (int)lowering->map[index]);
+}
+
+// Operando de origem de uma instrução de dois endereços. Os endereços do registro de ativação são relativos a “FP”
+operand_t lowered_operand(lowering_t *lowering, ir_operand_t operand)
+{
+  switch (operand.kind) {
+    case ir_operand_register: return lowered_register(lowering, (unsigned int)operand.value);
+    case ir_operand_constant: return create_operand(operand_immediate, operand.value);
+    case ir_operand_address:
+      if (is_frame_address(lowering->ir, operand.value))
+        return create_operand(operand_local, operand.value - (int)lowering->ir->frame_base);
+      return create_operand(operand_address, operand.value);
+    default: return create_operand(operand_none, 0);
+  }
+}
+
+// Posição de memória lida ou escrita diretamente
+static inline operand_t lowered_memory(lowering_t *lowering, int address)
+{
+  if (is_frame_address(lowering->ir, address))
+    return create_operand(operand_frame, address - (int)lowering->ir->frame_base);
+  return create_operand(operand_direct, address);
+}
+
+opcode_t branch_opcode(symbol_t condition)
+{
+  switch (condition) {
+    case symbol_equal: return opcode_breq;
+    case symbol_not_equal: return opcode_brne;
+    case symbol_less: return opcode_brls;
+    case symbol_less_equal: return opcode_brle;
+    case symbol_greater: return opcode_brgr;
+    case symbol_greater_equal: return opcode_brge;
+    default: return opcode_jump;
+  }
+}
+
+static inline bool is_commutative(unsigned char opcode)
+{
+  return opcode == ir_add || opcode == ir_mul || opcode == ir_and || opcode == ir_or;
+}
+
+// O destino pode ocupar o registrador do operando quando este é definido uma única vez no mesmo bloco e esta é a sua
+// última leitura, o que evita a cópia exigida pelas instruções de dois endereços. “uses” conta as leituras que ainda
+// não foram traduzidas
+static inline bool is_reusable(lowering_t *lowering, ir_operand_t operand, unsigned int block)
+{
+  if (operand.kind != ir_operand_register)
+    return false;
+  unsigned int index = (unsigned int)operand.value;
+  return lowering->uses[index] == 1 && lowering->definitions[index] == 1 && lowering->blocks[index] == block;
+}
+
+// Coloca “a” no registrador de destino, reaproveitando o registrador de “a” quando possível. Registradores definidos
+// mais de uma vez (os da redução de força) podem já estar no registrador de destino
+void lower_destination(lowering_t *lowering, unsigned int dst, ir_operand_t a, unsigned int block)
+{
+  if (is_reusable(lowering, a, block))
+    lowering->map[dst] = lowering->map[a.value];
+  else if (a.kind == ir_operand_register && lowering->map[a.value] == lowering->map[dst])
+    return;
+  else if (a.kind == ir_operand_register)
+    emit(lowering, opcode_mov, lowered_register(lowering, dst), lowered_operand(lowering, a));
+  else
+    emit(lowering, opcode_load, lowered_register(lowering, dst), lowered_operand(lowering, a));
+}
+
+// Garante que o operando esteja em um registrador, carregando constantes em um registrador novo
+operand_t lower_to_register(lowering_t *lowering, ir_operand_t operand)
+{
+  if (operand.kind == ir_operand_register)
+    return lowered_operand(lowering, operand);
+  operand_t temporary = create_operand(operand_register, (int)lowering->register_count++);
+  emit(lowering, opcode_load, temporary, lowered_operand(lowering, operand));
+  return temporary;
+}
+
+// Apenas “LOAD” calcula o endereço de uma posição do registro de ativação (“FP+n”); nas demais instruções ele precisa
+// estar em um registrador
+operand_t lowered_source(lowering_t *lowering, ir_operand_t operand)
+{
+  operand_t source = lowered_operand(lowering, operand);
+  if (source.kind != operand_local)
+    return source;
+  return lower_to_register(lowering, operand);
+}
+
+void lower_instruction(lowering_t *lowering, const ir_instruction_t *instruction, unsigned int block)
+{
+  static const opcode_t opcodes[] = {
+    opcode_nop, opcode_mov, opcode_load, opcode_store, opcode_add, opcode_sub, opcode_mul, opcode_div, opcode_mod,
+    opcode_shl, opcode_and, opcode_or, opcode_neg, opcode_not, opcode_cmp
+  };
+  ir_operand_t a = instruction->a, b = instruction->b;
+  unsigned int dst = instruction->dst;
+  switch (instruction->opcode) {
+    case ir_nop:
+      break;
+    case ir_move:
+      lower_destination(lowering, dst, a, block);
+      break;
+    case ir_load:
+      if (a.kind == ir_operand_address)
+        emit(lowering, opcode_load, lowered_register(lowering, dst), lowered_memory(lowering, a.value));
+      else {
+        operand_t address = create_operand(operand_indirect, (int)lowering->map[a.value]);
+        if (is_reusable(lowering, a, block))
+          lowering->map[dst] = lowering->map[a.value];
+        emit(lowering, opcode_load, lowered_register(lowering, dst), address);
+      }
+      break;
+    case ir_store: {
+      operand_t value = lower_to_register(lowering, b);
+      if (a.kind == ir_operand_address)
+        emit(lowering, opcode_store, lowered_memory(lowering, a.value), value);
+      else
+        emit(lowering, opcode_store, create_operand(operand_indirect, (int)lowering->map[a.value]), value);
+      break;
+    }
+    case ir_neg:
+    case ir_not:
+      lower_destination(lowering, dst, a, block);
+      emit(lowering, opcodes[instruction->opcode], lowered_register(lowering, dst), create_operand(operand_none, 0));
+      break;
+    case ir_compare:
+      emit(lowering, opcode_cmp, lower_to_register(lowering, a), lowered_source(lowering, b));
+      break;
+    case ir_check: {
+      // Como não há comparação sem sinal, cada limite tem a sua comparação e o seu desvio para a rotina de erro
+      operand_t index = lower_to_register(lowering, a);
+      operand_t trap = create_operand(operand_label, (int)lowering->trap_label);
+      if (instruction->condition & IR_CHECK_LOWER) {
+        emit(lowering, opcode_cmp, index, create_operand(operand_immediate, 0));
+        emit(lowering, opcode_brls, trap, create_operand(operand_none, 0));
+      }
+      if (instruction->condition & IR_CHECK_UPPER) {
+        emit(lowering, opcode_cmp, index, lowered_source(lowering, b));
+        emit(lowering, opcode_brge, trap, create_operand(operand_none, 0));
+      }
+      lowering->trapped = true;
+      break;
+    }
+    case ir_parameter:
+      emit(lowering, opcode_mov, lowered_register(lowering, dst), create_operand(operand_argument, a.value));
+      break;
+    case ir_argument:
+      emit(lowering, opcode_mov, create_operand(operand_argument, b.value), lowered_source(lowering, a));
+      break;
+    case ir_call:
+      // O destino é o número do procedimento até que o código de todos eles seja ligado (ver “finalize_backend”)
+      emit(lowering, opcode_call, create_operand(operand_immediate, a.value), create_operand(operand_none, 0));
+      break;
+    case ir_branch:
+    case ir_jump: {
+      // O destino é um bloco; “lower_ir” o troca pelo índice da instrução depois que todos os blocos forem traduzidos
+      opcode_t opcode = instruction->opcode == ir_jump ? opcode_jump : branch_opcode((symbol_t)instruction->condition);
+      emit(lowering, opcode, create_operand(operand_label, (int)dst), create_operand(operand_none, 0));
+      break;
+    }
+    default:
+      // Nas operações comutativas, a constante passa para a direita e vira o imediato da instrução; entre dois
+      // registradores, fica à esquerda o que pode ser reaproveitado
+      if (is_commutative(instruction->opcode) && b.kind == ir_operand_register &&
+          (a.kind != ir_operand_register || (!is_reusable(lowering, a, block) && is_reusable(lowering, b, block)))) {
+        ir_operand_t swap = a;
+        a = b;
+        b = swap;
+      }
+      lower_destination(lowering, dst, a, block);
+      emit(lowering, opcodes[instruction->opcode], lowered_register(lowering, dst), lowered_source(lowering, b));
+      break;
+  }
+}
+
+bool lower_ir(const ir_t *ir, instruction_t **code, unsigned int *length, unsigned int *register_count)
+{
+  lowering_t lowering;
+  size_t count = (size_t)ir->register_count + 1, checks = 0;
+  for (unsigned int index = 0; index < ir->length; index++)
+    checks += ir->instructions[index].opcode == ir_check;
+  // Cada instrução gera no máximo três da máquina alvo (uma delas calcula um endereço do registro de ativação), e cada
+  // verificação, cinco; a rotina de erro ocupa duas
+  lowering.code = (instruction_t *)malloc(((size_t)ir->length * 3 + checks * 3 + 3) * sizeof(instruction_t));
+  lowering.ir = ir;
+  lowering.length = 0;
+  lowering.register_count = ir->register_count;
+  lowering.trap_label = ir->block_count + 1;
+  lowering.trapped = false;
+  lowering.map = (unsigned int *)malloc(count * sizeof(unsigned int));
+  lowering.uses = (unsigned int *)calloc(count, sizeof(unsigned int));
+  lowering.definitions = (unsigned int *)calloc(count, sizeof(unsigned int));
+  lowering.blocks = (unsigned int *)calloc(count, sizeof(unsigned int));
+  unsigned int *starts = (unsigned int *)malloc(((size_t)ir->block_count + 2) * sizeof(unsigned int));
+  bool valid = lowering.code && lowering.map && lowering.uses && lowering.definitions && lowering.blocks && starts;
+  if (valid) {
+    for (unsigned int index = 0; index < ir->register_count; index++)
+      lowering.map[index] = index;
+    for (unsigned int block = 0; block < ir->block_count; block++)
+      for (unsigned int index = 0; index < ir->blocks[block].length; index++) {
+        const ir_instruction_t *instruction = &ir->instructions[ir->blocks[block].first + index];
+        if (instruction->a.kind == ir_operand_register)
+          lowering.uses[instruction->a.value]++;
+        if (instruction->b.kind == ir_operand_register)
+          lowering.uses[instruction->b.value]++;
+        if (!is_ir_branch(instruction->opcode) && instruction->dst != IR_NO_REGISTER) {
+          lowering.definitions[instruction->dst]++;
+          lowering.blocks[instruction->dst] = block;
+        }
+      }
+    for (unsigned int block = 0; block < ir->block_count; block++) {
+      starts[block] = lowering.length;
+      for (unsigned int index = 0; index < ir->blocks[block].length; index++) {
+        const ir_instruction_t *instruction = &ir->instructions[ir->blocks[block].first + index];
+        lower_instruction(&lowering, instruction, block);
+        if (instruction->a.kind == ir_operand_register)
+          lowering.uses[instruction->a.value]--;
+        if (instruction->b.kind == ir_operand_register)
+          lowering.uses[instruction->b.value]--;
+      }
+    }
+    // A rotina de erro fica depois do último bloco, e o fluxo normal salta sobre ela até o fim do módulo
+    if (lowering.trapped) {
+      if (lowering.length == 0 || lowering.code[lowering.length - 1].opcode != opcode_jump)
+        emit(&lowering, opcode_jump, create_operand(operand_label, (int)ir->block_count),
+             create_operand(operand_none, 0));
+      starts[ir->block_count + 1] = lowering.length;
+      emit(&lowering, opcode_trap, create_operand(operand_immediate, trap_index_out_of_range),
+           create_operand(operand_none, 0));
+    }
+    starts[ir->block_count] = lowering.length;
+    for (unsigned int index = 0; index < lowering.length; index++)
+      if (lowering.code[index].dst.kind == operand_label)
+        lowering.code[index].dst.value = (int)starts[lowering.code[index].dst.value];
+    *code = lowering.code;
+    *length = lowering.length;
+    *register_count = lowering.register_count;
+  }
+  else
+    free(lowering.code);
+  free(lowering.map);
+  free(lowering.uses);
+  free(lowering.definitions);
+  free(lowering.blocks);
+  free(starts);
+  return valid;
+}
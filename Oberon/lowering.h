@@ -0,0 +1,22 @@
+//
+//  lowering.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_lowering_h
+#define Oberon_lowering_h
+
+#include <stdbool.h>
+
+#include "backend.h"
+#include "ir.h"
+
+// Traduz a representação intermediária (já dividida em blocos) para as instruções de dois endereços da máquina alvo,
+// ainda com registradores virtuais. “code” recebe um vetor alocado com “malloc”; “register_count” recebe a quantidade
+// de registradores virtuais usados, que é a entrada da alocação de registradores (ver “registers.h”)
+bool lower_ir(const ir_t *ir, instruction_t **code, unsigned int *length, unsigned int *register_count);
+
+#endif
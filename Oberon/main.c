@@ -9,34 +9,110 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 
-#include "backend.h"
-#include "scanner.h"
-#include "parser.h"
+#include "compiler.h"
 
 #define OUTPUT_EXTENSION ".asm"
+#define DEFAULT_INPUT_PATH "/Users/Alvaro/Dropbox/Programming/Projects/Oberon/Oberon/Input.txt"
+#define DEFAULT_OUTPUT_PATH "/Users/Alvaro/Dropbox/Programming/Projects/Oberon/Oberon/Output.txt"
 
-void initialize_backend(FILE *file);
+// Extensão das saídas de cada formato com “-m”, na ordem de “output_format_t”
+static const char *extensions[] = { OUTPUT_EXTENSION, ".obj", ".s", ".out", ".ir" };
+
+// Troca a extensão do caminho de entrada (ou acrescenta uma, se não houver) pela do formato de saída
+char *derive_output_path(const char *input_path, output_format_t format)
+{
+	const char *name = strrchr(input_path, '/');
+	const char *dot = strrchr(name ? name : input_path, '.');
+	size_t length = dot && dot != name + 1 && dot != input_path ? (size_t)(dot - input_path) : strlen(input_path);
+	char *path = (char *)malloc(length + strlen(extensions[format]) + 1);
+	if (path) {
+		memcpy(path, input_path, length);
+		strcpy(path + length, extensions[format]);
+	}
+	return path;
+}
 
 int main(int argc, const char *argv[])
 {
-	FILE *input_file = fopen("/Users/Alvaro/Dropbox/Programming/Projects/Oberon/Oberon/Input.txt", "r");
-	if (!input_file) {
-		printf("Input file could not be opened.\n");
-		return EXIT_FAILURE;
+	// Uso: Oberon [-c] [-p | -r] [-l] [-s nome]... [-b | -n | -j | -i] [entrada [saída]], onde “-” indica a entrada ou
+	// a saída padrão, “-b” gera um arquivo objeto binário e “-n” gera assembly x86-64 para o GNU as em vez do texto da
+	// máquina alvo. Com “-j” o módulo é traduzido para x86-64 em memória e executado imediatamente; a saída (por padrão,
+	// a saída padrão) recebe a área de dados ao final da execução. “-i” escreve a representação intermediária, dividida
+	// em blocos básicos. “-c” verifica durante a execução os índices de vetores que a compilação não prova estarem dentro
+	// dos limites. “-p” dispõe registros e variáveis sem preenchimento, “-r” reordena os campos dos registros para
+	// reduzi-lo e “-l” mostra a disposição de cada registro. “-s” dispõe o vetor de registros declarado com o nome dado
+	// (tipo, variável ou campo) como estrutura de vetores, com uma coluna por campo (ver “layout.h”)
+	//
+	// Com “-m”, todos os argumentos que não são opções são entradas, compiladas em paralelo (ver “compiler.h”); a saída
+	// de cada uma fica ao lado dela, com a extensão do formato (“.asm”, “.obj”, “.s”, “.out” ou “.ir”)
+	options_t options = {
+		.format = output_format_text, .checks = false, .layout = layout_aligned, .report = false, .column_count = 0
+	};
+	const char *columns[argc];
+	options.columns = columns;
+	const char *paths[argc];
+	unsigned int path_count = 0;
+	bool modules = false;
+	for (int index = 1; index < argc; index++) {
+		if (strcmp(argv[index], "-b") == 0)
+			options.format = output_format_object;
+		else if (strcmp(argv[index], "-n") == 0)
+			options.format = output_format_native;
+		else if (strcmp(argv[index], "-j") == 0)
+			options.format = output_format_jit;
+		else if (strcmp(argv[index], "-i") == 0)
+			options.format = output_format_ir;
+		else if (strcmp(argv[index], "-c") == 0)
+			options.checks = true;
+		else if (strcmp(argv[index], "-p") == 0)
+			options.layout = layout_packed;
+		else if (strcmp(argv[index], "-r") == 0)
+			options.layout = layout_reordered;
+		else if (strcmp(argv[index], "-l") == 0)
+			options.report = true;
+		else if (strcmp(argv[index], "-m") == 0)
+			modules = true;
+		else if (strcmp(argv[index], "-s") == 0) {
+			if (++index == argc) {
+				printf("Missing name for \"-s\".\n");
+				return EXIT_FAILURE;
+			}
+			columns[options.column_count++] = argv[index];
+		}
+		else
+			paths[path_count++] = argv[index];
+	}
+	if (!modules) {
+		context_t context = {
+			.input_path = path_count > 0 ? paths[0] : DEFAULT_INPUT_PATH,
+			.output_path = path_count > 1 ? paths[1] : DEFAULT_OUTPUT_PATH,
+			.label = NULL,
+			.options = &options
+		};
+		if (options.format == output_format_jit && path_count < 2)
+			context.output_path = "-";
+		return compile_module(&context) ? EXIT_SUCCESS : EXIT_FAILURE;
 	}
-	FILE *output_file = fopen("/Users/Alvaro/Dropbox/Programming/Projects/Oberon/Oberon/Output.txt", "w+");
-	if (!output_file) {
-		printf("Output file could not be created.\n");
+	context_t *contexts = (context_t *)calloc(path_count + 1, sizeof(context_t));
+	if (!contexts) {
+		printf("Not enough memory.\n");
 		return EXIT_FAILURE;
 	}
-	if (!initialize_parser(input_file))
-		printf("Empty or damaged input file.\n");
-	else {
-		initialize_backend(output_file);
-		parse();
+	bool success = true;
+	for (unsigned int index = 0; index < path_count && success; index++) {
+		contexts[index].input_path = contexts[index].label = paths[index];
+		contexts[index].output_path = derive_output_path(paths[index], options.format);
+		contexts[index].options = &options;
+		success = contexts[index].output_path != NULL;
 	}
-	fclose(input_file);
-	fclose(output_file);
-	return EXIT_SUCCESS;
+	if (!success)
+		printf("Not enough memory.\n");
+	else
+		success = compile_modules(contexts, path_count);
+	for (unsigned int index = 0; index < path_count; index++)
+		free((char *)contexts[index].output_path);
+	free(contexts);
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
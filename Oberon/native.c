@@ -0,0 +1,334 @@
+//
+//  native.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "native.h"
+#include "vector.h"
+
+// Gerador de código x86-64 (sintaxe AT&T do GNU as). As instruções da máquina alvo são traduzidas uma a uma:
+//
+//   R0 a R10    ebx, ecx, esi, edi, r8d, r9d, r10d, r12d, r13d, r14d e r15d (rbx a r15 com “word_t” de 64 bits)
+//   S0, S1...   “oberon_spill”, em memória (um “word_t” cada)
+//   eax, edx    temporários (e operandos implícitos da divisão)
+//   r11d        temporário para divisões por constantes
+//   rbp         endereço de “oberon_data”
+//   A0, A1, A2  eax, edx e r11d, que ficam livres entre a passagem dos parâmetros e a chamada
+//   A3...       “oberon_arguments”, em memória (um “word_t” cada)
+//   FP          r15d, quando há registros de ativação (R10 deixa de ser usado); a pilha de dados fica no fim de
+//               “oberon_data” e as chamadas usam a pilha do próprio x86-64
+//
+// Os valores ocupam um “word_t” nos registradores e um “value_t” na memória, assim como na máquina virtual: a leitura
+// estende o sinal e a escrita guarda apenas os bits menos significativos. Os endereços contam posições de “value_t”, e
+// os acessos os multiplicam por NATIVE_SCALE. Endereços calculados em registradores são reduzidos a 16 bits (o
+// tamanho de “address_t”) antes de cada acesso. Os laços simples sobre vetores ganham uma versão vetorial antes do seu
+// rótulo (ver “vector.h”)
+
+// Nomes dos registradores com 1, 2, 4 e 8 bytes
+static const char *registers[4][NATIVE_REGISTER_COUNT] = {
+  { "bl", "cl", "sil", "dil", "r8b", "r9b", "r10b", "r12b", "r13b", "r14b", "r15b" },
+  { "bx", "cx", "si", "di", "r8w", "r9w", "r10w", "r12w", "r13w", "r14w", "r15w" },
+  { "ebx", "ecx", "esi", "edi", "r8d", "r9d", "r10d", "r12d", "r13d", "r14d", "r15d" },
+  { "rbx", "rcx", "rsi", "rdi", "r8", "r9", "r10", "r12", "r13", "r14", "r15" }
+};
+#define registers_16 registers[1]
+
+// Sufixo das operações sobre “word_t”, registradores que o guardam e temporários de mesma largura
+#if WORD_BITS == 64
+#define NATIVE_WORD "q"
+#define registers_word registers[3]
+static const char *temporaries[] = { "rax", "rdx", "r11" };
+#else
+#define NATIVE_WORD "l"
+#define registers_word registers[2]
+static const char *temporaries[] = { "eax", "edx", "r11d" };
+#endif
+
+// Leitura com extensão do sinal e escrita de um “value_t”, com os registradores da largura escrita
+#define NATIVE_SCALE ((int)sizeof(value_t))
+#if VALUE_BITS == 8
+#define NATIVE_LOAD_VALUE "movsb" NATIVE_WORD
+#define NATIVE_STORE_VALUE "movb"
+#define registers_value registers[0]
+#elif VALUE_BITS == 16
+#define NATIVE_LOAD_VALUE "movsw" NATIVE_WORD
+#define NATIVE_STORE_VALUE "movw"
+#define registers_value registers[1]
+#elif VALUE_BITS == 32
+#define NATIVE_LOAD_VALUE "movl"
+#define NATIVE_STORE_VALUE "movl"
+#define registers_value registers[2]
+#else
+#define NATIVE_LOAD_VALUE "movq"
+#define NATIVE_STORE_VALUE "movq"
+#define registers_value registers[3]
+#endif
+
+// Os desvios seguem a ordem de “opcode_breq” a “opcode_jump”
+static const char *jumps[] = { "je", "jne", "jl", "jle", "jg", "jge", "jmp" };
+
+// Parâmetros que ficam em registradores (os próprios temporários); os demais ficam em “oberon_arguments”
+#define NATIVE_ARGUMENT_REGISTERS 3
+
+static inline void print_native_argument(FILE *file, int index)
+{
+  if (index < NATIVE_ARGUMENT_REGISTERS)
+    fprintf(file, "%%%s", temporaries[index]);
+  else
+    fprintf(file, NATIVE_SYMBOL_PREFIX "oberon_arguments+%d(%%rip)",
+            (index - NATIVE_ARGUMENT_REGISTERS) * (int)sizeof(word_t));
+}
+
+static inline void print_native_register(FILE *file, int index)
+{
+  fprintf(file, "%%%s", registers_word[index]);
+}
+
+// Operando de origem das operações aritméticas: registrador ou imediato
+void print_native_source(FILE *file, operand_t operand)
+{
+  if (operand.kind == operand_register)
+    print_native_register(file, operand.value);
+  else
+    fprintf(file, "$%d", operand.value);
+}
+
+// Coloca em “rax” o endereço (reduzido a 16 bits) guardado no registrador
+void write_native_address(FILE *file, int index)
+{
+  fprintf(file, "\tmovzwl %%%s, %%eax\n", registers_16[index]);
+}
+
+void write_native_binary(FILE *file, const char *mnemonic, operand_t dst, operand_t src)
+{
+  fprintf(file, "\t%s ", mnemonic);
+  print_native_source(file, src);
+  fprintf(file, ", ");
+  print_native_register(file, dst.value);
+  fprintf(file, "\n");
+}
+
+// A alocação de registradores garante que só R0 a R10 apareçam no código
+static inline bool is_native_register(operand_t operand)
+{
+  return (operand.kind != operand_register && operand.kind != operand_indirect && operand.kind != operand_argument) ||
+    (operand.value >= 0 && operand.value < (operand.kind == operand_argument ? MAX_PARAMETERS : NATIVE_REGISTER_COUNT));
+}
+
+// Parâmetros: “MOV An, R” (ou imediato) antes da chamada e “MOV R, An” no início do procedimento
+void write_native_argument(FILE *file, operand_t dst, operand_t src)
+{
+  fprintf(file, "\tmov" NATIVE_WORD " ");
+  if (src.kind == operand_argument)
+    print_native_argument(file, src.value);
+  else
+    print_native_source(file, src);
+  fprintf(file, ", ");
+  if (dst.kind == operand_argument)
+    print_native_argument(file, dst.value);
+  else
+    print_native_register(file, dst.value);
+  fprintf(file, "\n");
+}
+
+bool write_native_instruction(FILE *file, const instruction_t *instruction, unsigned int length,
+                              unsigned int data_size)
+{
+  operand_t dst = instruction->dst, src = instruction->src;
+  if (!is_native_register(dst) || !is_native_register(src))
+    return false;
+  switch (instruction->opcode) {
+    case opcode_nop:
+      fprintf(file, "\tnop\n");
+      break;
+    case opcode_load:
+      if (src.kind == operand_immediate || src.kind == operand_address) {
+        write_native_binary(file, "mov" NATIVE_WORD, dst, src);
+        break;
+      }
+      if (src.kind == operand_spill)
+        fprintf(file, "\tmov" NATIVE_WORD " " NATIVE_SYMBOL_PREFIX "oberon_spill+%d(%%rip), ",
+                src.value * (int)sizeof(word_t));
+      else if (src.kind == operand_frame)
+        fprintf(file, "\t" NATIVE_LOAD_VALUE " %d(%%rbp,%%r15,%d), ", src.value * NATIVE_SCALE, NATIVE_SCALE);
+      else if (src.kind == operand_slot)
+        fprintf(file, "\tmov" NATIVE_WORD " %d(%%rbp,%%r15,%d), ", src.value * NATIVE_SCALE, NATIVE_SCALE);
+      else if (src.kind == operand_local)
+        fprintf(file, "\tlea" NATIVE_WORD " %d(%%r15), ", src.value);
+      else if (src.kind == operand_direct)
+        fprintf(file, "\t" NATIVE_LOAD_VALUE " " NATIVE_SYMBOL_PREFIX "oberon_data+%d(%%rip), ",
+                src.value * NATIVE_SCALE);
+      else {
+        write_native_address(file, src.value);
+        fprintf(file, "\t" NATIVE_LOAD_VALUE " (%%rbp,%%rax,%d), ", NATIVE_SCALE);
+      }
+      fprintf(file, "%%%s\n", registers_word[dst.value]);
+      break;
+    case opcode_store:
+      if (dst.kind == operand_spill)
+        fprintf(file, "\tmov" NATIVE_WORD " %%%s, " NATIVE_SYMBOL_PREFIX "oberon_spill+%d(%%rip)\n",
+                registers_word[src.value], dst.value * (int)sizeof(word_t));
+      else if (dst.kind == operand_direct)
+        fprintf(file, "\t" NATIVE_STORE_VALUE " %%%s, " NATIVE_SYMBOL_PREFIX "oberon_data+%d(%%rip)\n",
+                registers_value[src.value], dst.value * NATIVE_SCALE);
+      else if (dst.kind == operand_frame)
+        fprintf(file, "\t" NATIVE_STORE_VALUE " %%%s, %d(%%rbp,%%r15,%d)\n", registers_value[src.value],
+                dst.value * NATIVE_SCALE, NATIVE_SCALE);
+      else if (dst.kind == operand_slot)
+        fprintf(file, "\tmov" NATIVE_WORD " %%%s, %d(%%rbp,%%r15,%d)\n", registers_word[src.value],
+                dst.value * NATIVE_SCALE, NATIVE_SCALE);
+      else {
+        write_native_address(file, dst.value);
+        fprintf(file, "\t" NATIVE_STORE_VALUE " %%%s, (%%rbp,%%rax,%d)\n", registers_value[src.value], NATIVE_SCALE);
+      }
+      break;
+    case opcode_mov:
+      if (dst.kind == operand_argument || src.kind == operand_argument)
+        write_native_argument(file, dst, src);
+      else
+        write_native_binary(file, "mov" NATIVE_WORD, dst, src);
+      break;
+    case opcode_add: write_native_binary(file, "add" NATIVE_WORD, dst, src); break;
+    case opcode_sub: write_native_binary(file, "sub" NATIVE_WORD, dst, src); break;
+    case opcode_and: write_native_binary(file, "and" NATIVE_WORD, dst, src); break;
+    case opcode_or: write_native_binary(file, "or" NATIVE_WORD, dst, src); break;
+    case opcode_cmp: write_native_binary(file, "cmp" NATIVE_WORD, dst, src); break;
+    case opcode_mul:
+      if (src.kind == operand_register)
+        write_native_binary(file, "imul" NATIVE_WORD, dst, src);
+      else
+        fprintf(file, "\timul" NATIVE_WORD " $%d, %%%s, %%%s\n", src.value, registers_word[dst.value],
+                registers_word[dst.value]);
+      break;
+    case opcode_div:
+    case opcode_mod:
+      // O dividendo fica em “edx:eax”, o quociente em “eax” e o resto em “edx”; assim como na máquina virtual, o
+      // quociente é truncado
+      fprintf(file, "\tmov" NATIVE_WORD " ");
+      print_native_register(file, dst.value);
+      fprintf(file, ", %%%s\n\t%s\n", temporaries[0], WORD_BITS == 64 ? "cqto" : "cltd");
+      if (src.kind == operand_register) {
+        fprintf(file, "\tidiv" NATIVE_WORD " ");
+        print_native_register(file, src.value);
+        fprintf(file, "\n");
+      }
+      else
+        fprintf(file, "\tmov" NATIVE_WORD " $%d, %%%s\n\tidiv" NATIVE_WORD " %%%s\n", src.value, temporaries[2],
+                temporaries[2]);
+      fprintf(file, "\tmov" NATIVE_WORD " %%%s, ", temporaries[instruction->opcode == opcode_div ? 0 : 1]);
+      print_native_register(file, dst.value);
+      fprintf(file, "\n");
+      break;
+    case opcode_shl:
+      if (src.kind != operand_immediate)
+        return false;
+      fprintf(file, "\tshl" NATIVE_WORD " $%d, ", src.value & (WORD_BITS - 1));
+      print_native_register(file, dst.value);
+      fprintf(file, "\n");
+      break;
+    case opcode_neg:
+    case opcode_not:
+      fprintf(file, "\t%s ", instruction->opcode == opcode_neg ? "neg" NATIVE_WORD : "not" NATIVE_WORD);
+      print_native_register(file, dst.value);
+      fprintf(file, "\n");
+      break;
+    case opcode_trap:
+      // “oberon_trap” não retorna, por isso a pilha pode ser alinhada sem ser restaurada depois
+      if (dst.kind != operand_immediate)
+        return false;
+      fprintf(file, "\tmovl $%d, %%edi\n\tandq $-16, %%rsp\n\tcall " NATIVE_SYMBOL_PREFIX "oberon_trap\n", dst.value);
+      break;
+    case opcode_enter:
+      // A pilha de dados não pode alcançar as variáveis globais
+      if (dst.kind != operand_immediate)
+        return false;
+      fprintf(file, "\tsubl $%d, %%r15d\n\tcmpl $%u, %%r15d\n\tjl .Lstack_overflow\n", dst.value, data_size);
+      break;
+    case opcode_ret:
+      if (dst.kind != operand_immediate)
+        return false;
+      fprintf(file, "\taddl $%d, %%r15d\n\tret\n", dst.value);
+      break;
+    case opcode_call:
+      if (dst.kind != operand_label || dst.value < 0 || (unsigned int)dst.value > length)
+        return false;
+      fprintf(file, "\tcall .L%d\n", dst.value);
+      break;
+    default:
+      if (dst.kind != operand_label || dst.value < 0 || (unsigned int)dst.value > length)
+        return false;
+      fprintf(file, "\t%s .L%d\n", jumps[instruction->opcode - opcode_breq], dst.value);
+      break;
+  }
+  return true;
+}
+
+bool write_native(FILE *file, const instruction_t *code, unsigned int length, unsigned int data_size,
+                  unsigned int spill_count)
+{
+  bool *targets = (bool *)calloc(length + 1, sizeof(bool));
+  if (!targets)
+    return false;
+  bool framed = false;
+  int argument_count = 0;
+  for (unsigned int index = 0; index < length; index++) {
+    if (code[index].dst.kind == operand_label && code[index].dst.value >= 0 &&
+        (unsigned int)code[index].dst.value <= length)
+      targets[code[index].dst.value] = true;
+    framed = framed || code[index].opcode == opcode_enter;
+    if (code[index].dst.kind == operand_argument && code[index].dst.value >= argument_count)
+      argument_count = code[index].dst.value + 1;
+  }
+  fprintf(file, "\t.text\n\t.globl " NATIVE_SYMBOL_PREFIX "oberon_main\n\t.p2align 4\n");
+  fprintf(file, NATIVE_SYMBOL_PREFIX "oberon_main:\n");
+  fprintf(file, "\tpushq %%rbx\n\tpushq %%rbp\n\tpushq %%r12\n\tpushq %%r13\n\tpushq %%r14\n\tpushq %%r15\n");
+  fprintf(file, "\tleaq " NATIVE_SYMBOL_PREFIX "oberon_data(%%rip), %%rbp\n");
+  if (framed)
+    fprintf(file, "\tmovl $%d, %%r15d\n", MAX_ADDRESS + 1);
+  bool valid = true, vectorized = false;
+  for (unsigned int index = 0; index <= length && valid; index++) {
+    if (index < length && targets[index] && write_vector_loop(file, code, length, index, registers_word))
+      vectorized = true;
+    if (targets[index])
+      fprintf(file, ".L%u:\n", index);
+    if (index < length)
+      valid = write_native_instruction(file, &code[index], length, data_size);
+  }
+  free(targets);
+  fprintf(file, "\tpopq %%r15\n\tpopq %%r14\n\tpopq %%r13\n\tpopq %%r12\n\tpopq %%rbp\n\tpopq %%rbx\n\tret\n");
+  if (framed)
+    fprintf(file, ".Lstack_overflow:\n\tmovl $%d, %%edi\n\tandq $-16, %%rsp\n\tcall " NATIVE_SYMBOL_PREFIX
+            "oberon_trap\n", trap_stack_overflow);
+  fprintf(file, "\n\t.data\n\t.globl " NATIVE_SYMBOL_PREFIX "oberon_data_size\n\t.p2align 2\n");
+  fprintf(file, NATIVE_SYMBOL_PREFIX "oberon_data_size:\n\t.long %u\n", data_size);
+  fprintf(file, "\t.globl " NATIVE_SYMBOL_PREFIX "oberon_value_bits\n" NATIVE_SYMBOL_PREFIX "oberon_value_bits:\n"
+          "\t.long %d\n", VALUE_BITS);
+  if (vectorized)
+    write_vector_data(file);
+#if defined(__APPLE__)
+  fprintf(file, "\t.globl _oberon_data\n\t.zerofill __DATA,__bss,_oberon_data,%d,4\n",
+          (MAX_ADDRESS + 1) * NATIVE_SCALE);
+  if (spill_count)
+    fprintf(file, "\t.zerofill __DATA,__bss,_oberon_spill,%u,4\n", spill_count * (unsigned int)sizeof(word_t));
+  if (argument_count > NATIVE_ARGUMENT_REGISTERS)
+    fprintf(file, "\t.zerofill __DATA,__bss,_oberon_arguments,%d,4\n",
+            (argument_count - NATIVE_ARGUMENT_REGISTERS) * (int)sizeof(word_t));
+#else
+  fprintf(file, "\n\t.bss\n\t.globl oberon_data\n\t.p2align 4\noberon_data:\n\t.zero %d\n",
+          (MAX_ADDRESS + 1) * NATIVE_SCALE);
+  if (spill_count)
+    fprintf(file, "\t.p2align 4\noberon_spill:\n\t.zero %u\n", spill_count * (unsigned int)sizeof(word_t));
+  if (argument_count > NATIVE_ARGUMENT_REGISTERS)
+    fprintf(file, "\t.p2align 4\noberon_arguments:\n\t.zero %d\n",
+            (argument_count - NATIVE_ARGUMENT_REGISTERS) * (int)sizeof(word_t));
+  fprintf(file, "\t.section .note.GNU-stack,\"\",@progbits\n");
+#endif
+  return valid;
+}
@@ -0,0 +1,36 @@
+//
+//  native.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_native_h
+#define Oberon_native_h
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "backend.h"
+
+// Prefixo dos símbolos globais no montador da plataforma (Mach-O exige “_”, ELF não)
+#if defined(__APPLE__)
+#define NATIVE_SYMBOL_PREFIX "_"
+#else
+#define NATIVE_SYMBOL_PREFIX ""
+#endif
+
+// Quantidade de registradores x86-64 disponíveis para a alocação de registradores (ver “registers.h”)
+#define NATIVE_REGISTER_COUNT 11
+
+// O código gerado define a função “oberon_main”, a área de dados “oberon_data” (que cobre todo o espaço de “address_t”)
+// e as constantes “oberon_data_size”, com o tamanho usado pelas variáveis, e “oberon_value_bits”, com VALUE_BITS, que o
+// suporte de execução confere. A função “main” fica no suporte de execução (“Runtime/runtime.c”), assim como
+// “oberon_trap”, chamada por “TRAP” com o código do erro. O código já deve ter passado pela alocação com
+// NATIVE_REGISTER_COUNT registradores e usar “spill_count” posições de memória (apenas NATIVE_REGISTER_COUNT - 1
+// quando há registros de ativação, pois o último registrador passa a ser o FP)
+bool write_native(FILE *file, const instruction_t *code, unsigned int length, unsigned int data_size,
+                  unsigned int spill_count);
+
+#endif
@@ -0,0 +1,170 @@
+//
+//  object.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "object.h"
+
+static inline void put_u16(unsigned char *bytes, uint16_t value)
+{
+  bytes[0] = value & 0xFF;
+  bytes[1] = value >> 8;
+}
+
+static inline void put_u32(unsigned char *bytes, uint32_t value)
+{
+  bytes[0] = value & 0xFF;
+  bytes[1] = (value >> 8) & 0xFF;
+  bytes[2] = (value >> 16) & 0xFF;
+  bytes[3] = value >> 24;
+}
+
+static inline uint16_t get_u16(const unsigned char *bytes)
+{
+  return (uint16_t)(bytes[0] | bytes[1] << 8);
+}
+
+static inline uint32_t get_u32(const unsigned char *bytes)
+{
+  return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+static inline bool uses_register(operand_kind_t kind)
+{
+  return kind == operand_register || kind == operand_indirect || kind == operand_argument;
+}
+
+static inline bool uses_constant(operand_kind_t kind)
+{
+  return kind == operand_immediate || kind == operand_direct || kind == operand_address || kind == operand_label ||
+    kind == operand_spill || kind == operand_frame || kind == operand_local || kind == operand_slot;
+}
+
+bool encode_instruction(const instruction_t *instruction, unsigned char *bytes)
+{
+  const operand_t *dst = &instruction->dst, *src = &instruction->src;
+  if (uses_constant(dst->kind) && uses_constant(src->kind))
+    return false;
+  bytes[0] = (unsigned char)instruction->opcode;
+  bytes[1] = (unsigned char)(dst->kind << 4 | src->kind);
+  bytes[2] = uses_register(dst->kind) ? (unsigned char)dst->value : 0;
+  bytes[3] = uses_register(src->kind) ? (unsigned char)src->value : 0;
+  int constant = uses_constant(dst->kind) ? dst->value : (uses_constant(src->kind) ? src->value : 0);
+  put_u32(bytes + 4, (uint32_t)constant);
+  return true;
+}
+
+bool decode_instruction(const unsigned char *bytes, instruction_t *instruction)
+{
+  if (bytes[0] > opcode_ret || (bytes[1] >> 4) > operand_argument || (bytes[1] & 0x0F) > operand_argument)
+    return false;
+  instruction->opcode = (opcode_t)bytes[0];
+  instruction->dst.kind = (operand_kind_t)(bytes[1] >> 4);
+  instruction->src.kind = (operand_kind_t)(bytes[1] & 0x0F);
+  int constant = (int32_t)get_u32(bytes + 4);
+  instruction->dst.value = uses_register(instruction->dst.kind) ? bytes[2] : constant;
+  instruction->src.value = uses_register(instruction->src.kind) ? bytes[3] : constant;
+  return true;
+}
+
+// Todo o arquivo é montado em memória e escrito com uma única chamada a “fwrite”
+bool write_object(FILE *file, const instruction_t *code, uint32_t code_length, uint32_t data_size)
+{
+  uint32_t relocation_count = 0;
+  for (uint32_t index = 0; index < code_length; index++) {
+    operand_kind_t dst = code[index].dst.kind, src = code[index].src.kind;
+    if (dst == operand_direct || dst == operand_address || dst == operand_label ||
+        src == operand_direct || src == operand_address || src == operand_label)
+      relocation_count++;
+  }
+  size_t size = OBJECT_HEADER_SIZE + (size_t)code_length * OBJECT_INSTRUCTION_SIZE +
+    (size_t)relocation_count * OBJECT_RELOCATION_SIZE;
+  unsigned char *bytes = (unsigned char *)malloc(size);
+  if (!bytes)
+    return false;
+  put_u32(bytes, OBJECT_MAGIC);
+  put_u16(bytes + 4, OBJECT_VERSION);
+  put_u16(bytes + 6, OBJECT_INSTRUCTION_SIZE);
+  put_u32(bytes + 8, code_length);
+  put_u32(bytes + 12, data_size);
+  put_u32(bytes + 16, relocation_count);
+  put_u32(bytes + 20, 0);
+  put_u32(bytes + 24, VALUE_BITS);
+  unsigned char *word = bytes + OBJECT_HEADER_SIZE;
+  unsigned char *relocation = word + (size_t)code_length * OBJECT_INSTRUCTION_SIZE;
+  for (uint32_t index = 0; index < code_length; index++, word += OBJECT_INSTRUCTION_SIZE) {
+    if (!encode_instruction(&code[index], word)) {
+      free(bytes);
+      return false;
+    }
+    operand_kind_t dst = code[index].dst.kind, src = code[index].src.kind;
+    if (dst == operand_label || src == operand_label) {
+      put_u32(relocation, index);
+      put_u32(relocation + 4, relocation_code);
+      relocation += OBJECT_RELOCATION_SIZE;
+    } else if (dst == operand_direct || dst == operand_address || src == operand_direct || src == operand_address) {
+      put_u32(relocation, index);
+      put_u32(relocation + 4, relocation_data);
+      relocation += OBJECT_RELOCATION_SIZE;
+    }
+  }
+  bool written = fwrite(bytes, 1, size, file) == size;
+  free(bytes);
+  return written;
+}
+
+bool read_object(FILE *file, object_t *object)
+{
+  unsigned char header[OBJECT_HEADER_SIZE];
+  if (!file || !object || fread(header, 1, OBJECT_HEADER_SIZE, file) != OBJECT_HEADER_SIZE)
+    return false;
+  if (get_u32(header) != OBJECT_MAGIC || get_u16(header + 4) != OBJECT_VERSION ||
+      get_u16(header + 6) != OBJECT_INSTRUCTION_SIZE || get_u32(header + 24) != VALUE_BITS)
+    return false;
+  object->code_length = get_u32(header + 8);
+  object->data_size = get_u32(header + 12);
+  object->relocation_count = get_u32(header + 16);
+  object->entry = get_u32(header + 20);
+  object->code = (instruction_t *)malloc(((size_t)object->code_length + 1) * sizeof(instruction_t));
+  object->relocations = (relocation_t *)malloc(((size_t)object->relocation_count + 1) * sizeof(relocation_t));
+  size_t size = (size_t)object->code_length * OBJECT_INSTRUCTION_SIZE +
+    (size_t)object->relocation_count * OBJECT_RELOCATION_SIZE;
+  unsigned char *bytes = (unsigned char *)malloc(size + 1);
+  if (!object->code || !object->relocations || !bytes || fread(bytes, 1, size, file) != size) {
+    free(bytes);
+    clear_object(object);
+    return false;
+  }
+  const unsigned char *word = bytes;
+  for (uint32_t index = 0; index < object->code_length; index++, word += OBJECT_INSTRUCTION_SIZE)
+    if (!decode_instruction(word, &object->code[index])) {
+      free(bytes);
+      clear_object(object);
+      return false;
+    }
+  for (uint32_t index = 0; index < object->relocation_count; index++, word += OBJECT_RELOCATION_SIZE) {
+    object->relocations[index].position = get_u32(word);
+    object->relocations[index].kind = (relocation_kind_t)get_u32(word + 4);
+  }
+  free(bytes);
+  return true;
+}
+
+void clear_object(object_t *object)
+{
+  if (!object)
+    return;
+  free(object->code);
+  free(object->relocations);
+  object->code = NULL;
+  object->relocations = NULL;
+  object->code_length = 0;
+  object->relocation_count = 0;
+}
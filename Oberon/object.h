@@ -0,0 +1,64 @@
+//
+//  object.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_object_h
+#define Oberon_object_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "backend.h"
+
+// Formato do arquivo objeto (todos os inteiros em “little-endian”):
+//
+//   cabeçalho    “magic”, versão, tamanho de cada instrução, quantidade de instruções, tamanho da área de dados,
+//                quantidade de relocações, índice da instrução inicial e largura de “value_t” em bits
+//                (OBJECT_HEADER_SIZE bytes); um objeto só é lido por uma máquina com a mesma largura
+//   código       uma palavra de OBJECT_INSTRUCTION_SIZE bytes por instrução
+//   relocações   pares (índice da instrução, tipo da relocação) de 32 bits cada
+//
+// Cada instrução ocupa sempre 8 bytes: código da operação, tipos dos operandos (destino nos 4 bits mais altos, origem
+// nos 4 mais baixos), registrador do destino, registrador da origem e uma constante de 32 bits com sinal. Operandos do
+// tipo registrador (inclusive os de parâmetros) usam os campos de registrador; imediatos, endereços, rótulos, posições
+// do registro de ativação e posições de memória dos registradores que não couberam na máquina usam a constante.
+// Nenhuma instrução gerada pelo compilador possui mais de um operando que precise da constante
+#define OBJECT_MAGIC 0x304E424F // “OBN0”
+#define OBJECT_VERSION 5
+#define OBJECT_HEADER_SIZE 28
+#define OBJECT_INSTRUCTION_SIZE 8
+#define OBJECT_RELOCATION_SIZE 8
+
+// Relocações de dados somam o endereço base da área de dados à constante; relocações de código somam o endereço base
+// do código ao índice da instrução de destino
+typedef enum _relocation_kind {
+  relocation_data,
+  relocation_code
+} relocation_kind_t;
+
+typedef struct _relocation {
+  uint32_t position;
+  relocation_kind_t kind;
+} relocation_t;
+
+typedef struct _object {
+  instruction_t *code;
+  uint32_t code_length;
+  uint32_t data_size;
+  uint32_t entry;
+  relocation_t *relocations;
+  uint32_t relocation_count;
+} object_t;
+
+bool encode_instruction(const instruction_t *instruction, unsigned char *bytes);
+bool decode_instruction(const unsigned char *bytes, instruction_t *instruction);
+bool write_object(FILE *file, const instruction_t *code, uint32_t code_length, uint32_t data_size);
+bool read_object(FILE *file, object_t *object);
+void clear_object(object_t *object);
+
+#endif
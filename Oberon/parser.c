@@ -7,306 +7,169 @@
 //
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
+#include "arena.h"
 #include "backend.h"
 #include "errors.h"
+#include "layout.h"
 #include "scanner.h"
 #include "symbol_table.h"
 #include "parser.h"
 
-bool should_log;
+__thread bool should_log;
 
 // Funções de geração de código
 void write_index_offset(item_t *item, item_t *index_item);
 void write_field_offset(item_t *item, address_t offset);
 void write_unary_op(symbol_t symbol, item_t *item);
+void write_short_circuit(symbol_t symbol, item_t *item);
 void write_binary_op(symbol_t symbol, item_t *item, item_t *rhs_item);
 void write_comparison(symbol_t symbol, item_t *item, item_t *rhs_item);
 void write_branch(item_t *item, bool forward);
 void write_inverse_branch(item_t *item, bool forward);
-void write_label(item_t *item, const char *label);
+void write_label(item_t *item);
 void write_store(item_t *dst_item, item_t *src_item);
 void fixup_links(item_t *item);
-
-bool is_first(const char *non_terminal, symbol_t symbol)
-{
-  if (strcmp(non_terminal, "selector") == 0)
-    return symbol == symbol_period ||
-           symbol == symbol_open_bracket ||
-           symbol == symbol_null;
-  else if (strcmp(non_terminal, "factor") == 0)
-    return symbol == symbol_open_paren ||
-           symbol == symbol_not ||
-           symbol == symbol_number ||
-           symbol == symbol_id;
-  else if (strcmp(non_terminal, "term") == 0)
-    return symbol == symbol_open_paren ||
-           symbol == symbol_not ||
-           symbol == symbol_number ||
-           symbol == symbol_id;
-  else if (strcmp(non_terminal, "simple_expr") == 0)
-    return symbol == symbol_plus ||
-           symbol == symbol_minus ||
-           symbol == symbol_open_paren ||
-           symbol == symbol_not ||
-           symbol == symbol_number ||
-           symbol == symbol_id;
-  else if (strcmp(non_terminal, "expr") == 0)
-    return symbol == symbol_plus ||
-           symbol == symbol_minus ||
-           symbol == symbol_open_paren ||
-           symbol == symbol_not ||
-           symbol == symbol_number ||
-           symbol == symbol_id;
-  else if (strcmp(non_terminal, "assignment") == 0)
-    return symbol == symbol_becomes;
-  else if (strcmp(non_terminal, "actual_params") == 0)
-    return symbol == symbol_open_paren;
-  else if (strcmp(non_terminal, "proc_call") == 0)
-    return symbol == symbol_open_paren ||
-           symbol == symbol_null;
-  else if (strcmp(non_terminal, "if_stmt") == 0)
-    return symbol == symbol_if;
-  else if (strcmp(non_terminal, "while_stmt") == 0)
-    return symbol == symbol_while;
-  else if (strcmp(non_terminal, "repeat_stmt") == 0)
-    return symbol == symbol_repeat;
-  else if (strcmp(non_terminal, "stmt") == 0)
-    return symbol == symbol_id ||
-           symbol == symbol_if ||
-           symbol == symbol_while ||
-           symbol == symbol_repeat ||
-           symbol == symbol_null;
-  else if (strcmp(non_terminal, "stmt_sequence") == 0)
-    return symbol == symbol_id ||
-           symbol == symbol_if ||
-           symbol == symbol_while ||
-           symbol == symbol_repeat ||
-           symbol == symbol_null;
-  else if (strcmp(non_terminal, "id_list") == 0)
-    return symbol == symbol_id;
-  else if (strcmp(non_terminal, "array_type") == 0)
-    return symbol == symbol_array;
-  else if (strcmp(non_terminal, "field_list") == 0)
-    return symbol == symbol_id ||
-           symbol == symbol_null;
-  else if (strcmp(non_terminal, "record_type") == 0)
-    return symbol == symbol_record;
-  else if (strcmp(non_terminal, "type") == 0)
-    return symbol == symbol_id ||
-           symbol == symbol_array ||
-           symbol == symbol_record;
-  else if (strcmp(non_terminal, "formal_params_section") == 0)
-    return symbol == symbol_id ||
-           symbol == symbol_var;
-  else if (strcmp(non_terminal, "formal_params") == 0)
-    return symbol == symbol_open_paren;
-  else if (strcmp(non_terminal, "proc_head") == 0)
-    return symbol == symbol_proc;
-  else if (strcmp(non_terminal, "proc_body") == 0)
-    return symbol == symbol_end ||
-           symbol == symbol_const ||
-           symbol == symbol_type ||
-           symbol == symbol_var ||
-           symbol == symbol_proc ||
-           symbol == symbol_begin;
-  else if (strcmp(non_terminal, "proc_decl") == 0)
-    return symbol == symbol_proc;
-  else if (strcmp(non_terminal, "const_decl") == 0)
-    return symbol == symbol_const;
-  else if (strcmp(non_terminal, "type_decl") == 0)
-    return symbol == symbol_type;
-  else if (strcmp(non_terminal, "var_decl") == 0)
-    return symbol == symbol_var;
-  else if (strcmp(non_terminal, "declarations") == 0)
-    return symbol == symbol_const ||
-           symbol == symbol_type ||
-           symbol == symbol_var ||
-           symbol == symbol_proc ||
-           symbol == symbol_begin;
-  else if (strcmp(non_terminal, "module") == 0)
-    return symbol == symbol_module;
-  return false;
-}
-
-bool is_follow(const char *non_terminal, symbol_t symbol)
-{
-  if (strcmp(non_terminal, "selector") == 0)
-    return symbol == symbol_times ||
-           symbol == symbol_div ||
-           symbol == symbol_mod ||
-           symbol == symbol_and ||
-           symbol == symbol_plus ||
-           symbol == symbol_minus ||
-           symbol == symbol_or ||
-           symbol == symbol_equal ||
-           symbol == symbol_not_equal ||
-           symbol == symbol_less ||
-           symbol == symbol_less_equal ||
-           symbol == symbol_greater ||
-           symbol == symbol_greater_equal ||
-           symbol == symbol_comma ||
-           symbol == symbol_close_paren ||
-           symbol == symbol_close_bracket ||
-           symbol == symbol_becomes ||
-           symbol == symbol_of ||
-           symbol == symbol_then ||
-           symbol == symbol_do ||
-           symbol == symbol_semicolon ||
-           symbol == symbol_end ||
-           symbol == symbol_else ||
-           symbol == symbol_elsif ||
-           symbol == symbol_until;
-  else if (strcmp(non_terminal, "factor") == 0)
-    return symbol == symbol_times ||
-           symbol == symbol_div ||
-           symbol == symbol_mod ||
-           symbol == symbol_and ||
-           symbol == symbol_plus ||
-           symbol == symbol_minus ||
-           symbol == symbol_or ||
-           symbol == symbol_equal ||
-           symbol == symbol_not_equal ||
-           symbol == symbol_less ||
-           symbol == symbol_less_equal ||
-           symbol == symbol_greater ||
-           symbol == symbol_greater_equal ||
-           symbol == symbol_comma ||
-           symbol == symbol_close_paren ||
-           symbol == symbol_close_bracket ||
-           symbol == symbol_becomes ||
-           symbol == symbol_of ||
-           symbol == symbol_then ||
-           symbol == symbol_do ||
-           symbol == symbol_semicolon ||
-           symbol == symbol_end ||
-           symbol == symbol_else ||
-           symbol == symbol_elsif ||
-           symbol == symbol_until;
-  else if (strcmp(non_terminal, "term") == 0)
-    return symbol == symbol_plus ||
-           symbol == symbol_minus ||
-           symbol == symbol_or ||
-           symbol == symbol_equal ||
-           symbol == symbol_not_equal ||
-           symbol == symbol_less ||
-           symbol == symbol_less_equal ||
-           symbol == symbol_greater ||
-           symbol == symbol_greater_equal ||
-           symbol == symbol_comma ||
-           symbol == symbol_close_paren ||
-           symbol == symbol_close_bracket ||
-           symbol == symbol_becomes ||
-           symbol == symbol_of ||
-           symbol == symbol_then ||
-           symbol == symbol_do ||
-           symbol == symbol_semicolon ||
-           symbol == symbol_end ||
-           symbol == symbol_else ||
-           symbol == symbol_elsif ||
-           symbol == symbol_until;
-  else if (strcmp(non_terminal, "simple_expr") == 0)
-    return symbol == symbol_plus ||
-           symbol == symbol_minus ||
-           symbol == symbol_or ||
-           symbol == symbol_equal ||
-           symbol == symbol_not_equal ||
-           symbol == symbol_less ||
-           symbol == symbol_less_equal ||
-           symbol == symbol_greater ||
-           symbol == symbol_greater_equal ||
-           symbol == symbol_comma ||
-           symbol == symbol_close_paren ||
-           symbol == symbol_close_bracket ||
-           symbol == symbol_becomes ||
-           symbol == symbol_of ||
-           symbol == symbol_then ||
-           symbol == symbol_do ||
-           symbol == symbol_semicolon ||
-           symbol == symbol_end ||
-           symbol == symbol_else ||
-           symbol == symbol_elsif ||
-           symbol == symbol_until;
-  else if (strcmp(non_terminal, "expr") == 0)
-    return symbol == symbol_comma ||
-           symbol == symbol_close_paren ||
-           symbol == symbol_close_bracket ||
-           symbol == symbol_becomes ||
-           symbol == symbol_of ||
-           symbol == symbol_then ||
-           symbol == symbol_do ||
-           symbol == symbol_semicolon ||
-           symbol == symbol_end ||
-           symbol == symbol_else ||
-           symbol == symbol_elsif ||
-           symbol == symbol_until;
-  else if (strcmp(non_terminal, "assignment") == 0)
-    return symbol == symbol_semicolon ||
-           symbol == symbol_end ||
-           symbol == symbol_else ||
-           symbol == symbol_elsif ||
-           symbol == symbol_until;
-  else if (strcmp(non_terminal, "actual_params") == 0)
-    return symbol == symbol_null;
-  else if (strcmp(non_terminal, "proc_call") == 0)
-    return symbol == symbol_semicolon ||
-           symbol == symbol_end ||
-           symbol == symbol_else ||
-           symbol == symbol_elsif ||
-           symbol == symbol_until;
-  else if (strcmp(non_terminal, "if_stmt") == 0)
-    return symbol == symbol_null;
-  else if (strcmp(non_terminal, "while_stmt") == 0)
-    return symbol == symbol_null;
-  else if (strcmp(non_terminal, "repeat_stmt") == 0)
-    return symbol == symbol_null;
-  else if (strcmp(non_terminal, "stmt") == 0)
-    return symbol == symbol_semicolon ||
-           symbol == symbol_end ||
-           symbol == symbol_else ||
-           symbol == symbol_elsif ||
-           symbol == symbol_until;
-  else if (strcmp(non_terminal, "stmt_sequence") == 0)
-    return symbol == symbol_end ||
-           symbol == symbol_else ||
-           symbol == symbol_elsif ||
-           symbol == symbol_until;
-  else if (strcmp(non_terminal, "id_list") == 0)
-    return symbol == symbol_null;
-  else if (strcmp(non_terminal, "array_type") == 0)
-    return symbol == symbol_null;
-  else if (strcmp(non_terminal, "field_list") == 0)
-    return symbol == symbol_semicolon ||
-           symbol == symbol_end;
-  else if (strcmp(non_terminal, "record_type") == 0)
-    return symbol == symbol_null;
-  else if (strcmp(non_terminal, "type") == 0)
-    return symbol == symbol_close_paren ||
-           symbol == symbol_semicolon;
-  else if (strcmp(non_terminal, "formal_params_section") == 0)
-    return symbol == symbol_close_paren ||
-           symbol == symbol_semicolon;
-  else if (strcmp(non_terminal, "formal_params") == 0)
-    return symbol == symbol_semicolon;
-  else if (strcmp(non_terminal, "proc_head") == 0)
-    return symbol == symbol_semicolon;
-  else if (strcmp(non_terminal, "proc_body") == 0)
-    return symbol == symbol_semicolon;
-  else if (strcmp(non_terminal, "proc_decl") == 0)
-    return symbol == symbol_semicolon;
-  else if (strcmp(non_terminal, "const_decl") == 0)
-    return symbol == symbol_null;
-  else if (strcmp(non_terminal, "type_decl") == 0)
-    return symbol == symbol_null;
-  else if (strcmp(non_terminal, "var_decl") == 0)
-    return symbol == symbol_null;
-  else if (strcmp(non_terminal, "declarations") == 0)
-    return symbol == symbol_end ||
-           symbol == symbol_begin;
-  else if (strcmp(non_terminal, "module") == 0)
-    return symbol == symbol_eof;
-  return false;
+void open_procedure(entry_t *entry);
+void close_procedure();
+void write_parameters(entry_t *entry);
+void write_actual_param(item_t *item, bool reference);
+void write_call(entry_t *entry, item_t *params, unsigned int count);
+
+// Não-terminais da gramática que possuem conjuntos first(K) e follow(K) definidos (ver “scanner.c”)
+typedef enum _non_terminal {
+  non_terminal_selector,
+  non_terminal_factor,
+  non_terminal_term,
+  non_terminal_simple_expr,
+  non_terminal_expr,
+  non_terminal_assignment,
+  non_terminal_actual_params,
+  non_terminal_proc_call,
+  non_terminal_if_stmt,
+  non_terminal_while_stmt,
+  non_terminal_repeat_stmt,
+  non_terminal_stmt,
+  non_terminal_stmt_sequence,
+  non_terminal_id_list,
+  non_terminal_array_type,
+  non_terminal_field_list,
+  non_terminal_record_type,
+  non_terminal_type,
+  non_terminal_formal_params_section,
+  non_terminal_formal_params,
+  non_terminal_proc_head,
+  non_terminal_proc_body,
+  non_terminal_proc_decl,
+  non_terminal_const_decl,
+  non_terminal_type_decl,
+  non_terminal_var_decl,
+  non_terminal_declarations,
+  non_terminal_module,
+  non_terminal_count
+} non_terminal_t;
+
+// Os conjuntos são mapas de bits indexados pelo próprio símbolo. Como “symbol_eof” vale 64, são necessárias duas
+// palavras: a primeira guarda os símbolos de 0 a 63 e a segunda os demais
+typedef struct _symbol_set {
+  uint64_t bits[2];
+} symbol_set_t;
+
+// Falha na compilação caso algum símbolo não caiba no conjunto
+typedef char symbol_set_fits_symbols[symbol_eof < 128 ? 1 : -1];
+
+#define S(symbol) (UINT64_C(1) << (symbol))
+
+#define SET_EXPR_START (S(symbol_open_paren) | S(symbol_not) | S(symbol_number) | S(symbol_id))
+#define SET_STMT_START (S(symbol_id) | S(symbol_if) | S(symbol_while) | S(symbol_repeat) | S(symbol_null))
+#define SET_STMT_END (S(symbol_semicolon) | S(symbol_end) | S(symbol_else) | S(symbol_elsif) | S(symbol_until))
+#define SET_EXPR_END (S(symbol_comma) | S(symbol_close_paren) | S(symbol_close_bracket) | S(symbol_becomes) | \
+                      S(symbol_of) | S(symbol_then) | S(symbol_do) | SET_STMT_END)
+#define SET_RELATION (S(symbol_equal) | S(symbol_not_equal) | S(symbol_less) | S(symbol_less_equal) | \
+                      S(symbol_greater) | S(symbol_greater_equal))
+#define SET_ADD_OPERATOR (S(symbol_plus) | S(symbol_minus) | S(symbol_or))
+#define SET_MUL_OPERATOR (S(symbol_times) | S(symbol_div) | S(symbol_mod) | S(symbol_and))
+#define SET_DECLARATIONS (S(symbol_const) | S(symbol_type) | S(symbol_var) | S(symbol_proc) | S(symbol_begin))
+
+const symbol_set_t first_sets[non_terminal_count] = {
+  [non_terminal_selector]              = { { S(symbol_period) | S(symbol_open_bracket) | S(symbol_null), 0 } },
+  [non_terminal_factor]                = { { SET_EXPR_START, 0 } },
+  [non_terminal_term]                  = { { SET_EXPR_START, 0 } },
+  [non_terminal_simple_expr]           = { { S(symbol_plus) | S(symbol_minus) | SET_EXPR_START, 0 } },
+  [non_terminal_expr]                  = { { S(symbol_plus) | S(symbol_minus) | SET_EXPR_START, 0 } },
+  [non_terminal_assignment]            = { { S(symbol_becomes), 0 } },
+  [non_terminal_actual_params]         = { { S(symbol_open_paren), 0 } },
+  [non_terminal_proc_call]             = { { S(symbol_open_paren) | S(symbol_null), 0 } },
+  [non_terminal_if_stmt]               = { { S(symbol_if), 0 } },
+  [non_terminal_while_stmt]            = { { S(symbol_while), 0 } },
+  [non_terminal_repeat_stmt]           = { { S(symbol_repeat), 0 } },
+  [non_terminal_stmt]                  = { { SET_STMT_START, 0 } },
+  [non_terminal_stmt_sequence]         = { { SET_STMT_START, 0 } },
+  [non_terminal_id_list]               = { { S(symbol_id), 0 } },
+  [non_terminal_array_type]            = { { S(symbol_array), 0 } },
+  [non_terminal_field_list]            = { { S(symbol_id) | S(symbol_null), 0 } },
+  [non_terminal_record_type]           = { { S(symbol_record), 0 } },
+  [non_terminal_type]                  = { { S(symbol_id) | S(symbol_array) | S(symbol_record), 0 } },
+  [non_terminal_formal_params_section] = { { S(symbol_id) | S(symbol_var), 0 } },
+  [non_terminal_formal_params]         = { { S(symbol_open_paren), 0 } },
+  [non_terminal_proc_head]             = { { S(symbol_proc), 0 } },
+  [non_terminal_proc_body]             = { { S(symbol_end) | SET_DECLARATIONS, 0 } },
+  [non_terminal_proc_decl]             = { { S(symbol_proc), 0 } },
+  [non_terminal_const_decl]            = { { S(symbol_const), 0 } },
+  [non_terminal_type_decl]             = { { S(symbol_type), 0 } },
+  [non_terminal_var_decl]              = { { S(symbol_var), 0 } },
+  [non_terminal_declarations]          = { { SET_DECLARATIONS, 0 } },
+  [non_terminal_module]                = { { S(symbol_module), 0 } }
+};
+
+const symbol_set_t follow_sets[non_terminal_count] = {
+  [non_terminal_selector]              = { { SET_MUL_OPERATOR | SET_ADD_OPERATOR | SET_RELATION | SET_EXPR_END, 0 } },
+  [non_terminal_factor]                = { { SET_MUL_OPERATOR | SET_ADD_OPERATOR | SET_RELATION | SET_EXPR_END, 0 } },
+  [non_terminal_term]                  = { { SET_ADD_OPERATOR | SET_RELATION | SET_EXPR_END, 0 } },
+  [non_terminal_simple_expr]           = { { SET_ADD_OPERATOR | SET_RELATION | SET_EXPR_END, 0 } },
+  [non_terminal_expr]                  = { { SET_EXPR_END, 0 } },
+  [non_terminal_assignment]            = { { SET_STMT_END, 0 } },
+  [non_terminal_actual_params]         = { { S(symbol_null), 0 } },
+  [non_terminal_proc_call]             = { { SET_STMT_END, 0 } },
+  [non_terminal_if_stmt]               = { { S(symbol_null), 0 } },
+  [non_terminal_while_stmt]            = { { S(symbol_null), 0 } },
+  [non_terminal_repeat_stmt]           = { { S(symbol_null), 0 } },
+  [non_terminal_stmt]                  = { { SET_STMT_END, 0 } },
+  [non_terminal_stmt_sequence]         = { { S(symbol_end) | S(symbol_else) | S(symbol_elsif) | S(symbol_until), 0 } },
+  [non_terminal_id_list]               = { { S(symbol_null), 0 } },
+  [non_terminal_array_type]            = { { S(symbol_null), 0 } },
+  [non_terminal_field_list]            = { { S(symbol_semicolon) | S(symbol_end), 0 } },
+  [non_terminal_record_type]           = { { S(symbol_null), 0 } },
+  [non_terminal_type]                  = { { S(symbol_close_paren) | S(symbol_semicolon), 0 } },
+  [non_terminal_formal_params_section] = { { S(symbol_close_paren) | S(symbol_semicolon), 0 } },
+  [non_terminal_formal_params]         = { { S(symbol_semicolon), 0 } },
+  [non_terminal_proc_head]             = { { S(symbol_semicolon), 0 } },
+  [non_terminal_proc_body]             = { { S(symbol_semicolon), 0 } },
+  [non_terminal_proc_decl]             = { { S(symbol_semicolon), 0 } },
+  [non_terminal_const_decl]            = { { S(symbol_null), 0 } },
+  [non_terminal_type_decl]             = { { S(symbol_null), 0 } },
+  [non_terminal_var_decl]              = { { S(symbol_null), 0 } },
+  [non_terminal_declarations]          = { { S(symbol_end) | S(symbol_begin), 0 } },
+  [non_terminal_module]                = { { 0, S(symbol_eof - 64) } }
+};
+
+#undef S
+
+static inline bool is_member(const symbol_set_t *set, symbol_t symbol)
+{
+  return (set->bits[symbol >> 6] >> (symbol & 63)) & 1;
+}
+
+static inline bool is_first(non_terminal_t non_terminal, symbol_t symbol)
+{
+  return is_member(&first_sets[non_terminal], symbol);
+}
+
+static inline bool is_follow(non_terminal_t non_terminal, symbol_t symbol)
+{
+  return is_member(&follow_sets[non_terminal], symbol);
 }
 
 bool scan()
@@ -324,7 +187,7 @@ bool verify(symbol_t symbol, bool mark_error, bool next)
 {
   if (current_token.lexem.symbol == symbol || symbol == symbol_null) {
     if (should_log)
-      mark(error_log, "\"%s\" found.", current_token.lexem.id);
+      mark(error_log, "\"%s\" found.", id_for_lexem(current_token.lexem));
     if (next)
       scan();
     return true;
@@ -358,11 +221,43 @@ static inline bool try_assert(symbol_t symbol)
 
 void expr(item_t *item);
 
+// Item de uma variável ou constante. O endereço de um parâmetro passado por referência fica em um registrador. Assim
+// como no Oberon-0, as variáveis locais dos procedimentos que envolvem o corrente não podem ser acessadas
+void entry_item(entry_t *entry, item_t *item)
+{
+  item->address = entry->address;
+  item->type = entry->type;
+  item->value = entry->value;
+  item->columns = 0;
+  if (entry->class == class_const)
+    item->addressing = addressing_immediate;
+  else if (entry->reference) {
+    item->addressing = addressing_indirect;
+    item->index = entry->index;
+  }
+  else
+    item->addressing = addressing_direct;
+  if (entry->class == class_var && entry->level > 0 && entry->level != current_level)
+    mark(error_parser, "\"%s\" belongs to an enclosing procedure and cannot be accessed.", id_for_atom(entry->id));
+}
+
+// Um item sem valor válido, deixado pelos erros: o gerador de código não o usa como registrador (ver “write_load”)
+void unknown_item(item_t *item)
+{
+  item->addressing = addressing_unknown;
+  item->type = NULL;
+  item->address = 0;
+  item->value = 0;
+  item->index = 0;
+  item->columns = 0;
+  item->true_links = item->false_links = NULL;
+}
+
 // selector = {"." id | "[" expr "]"}
 void selector(item_t *item, token_t entry_token)
 {
   position_t position = entry_token.position;
-  while (is_first("selector", current_token.lexem.symbol)) {
+  while (is_first(non_terminal_selector, current_token.lexem.symbol)) {
     if (try_consume(symbol_period)) {
       assert(symbol_id);
       // TODO: Remover as verificações para “item” quando possível
@@ -371,18 +266,21 @@ void selector(item_t *item, token_t entry_token)
       else {
         entry_t *field = find_entry(current_token.lexem.id, item->type->fields);
         if (!field) {
-          mark(error_parser, "\"%s\" is not a valid field.", current_token.lexem.id);
+          mark(error_parser, "\"%s\" is not a valid field.", id_for_atom(current_token.lexem.id));
           // TODO: Mudar o endereçamento ao invés de anular o tipo?
           item->type = NULL;
         }
         else {
           // Lembrando: o endereço (“address”) do campo corresponde ao seu deslocamento com base no endereço do registro
-          // em si e não ao seu endereço global atual
+          // em si e não ao seu endereço global atual. Em uma estrutura de vetores, o item aponta para o elemento na
+          // primeira coluna e o campo está a algumas colunas de distância
+          address_t offset = item->columns ? column_offset(item->type, field, item->columns) : field->address;
           if (item->addressing == addressing_indirect)
-            write_field_offset(item, field->address);
+            write_field_offset(item, offset);
           else
-            item->address = item->address + field->address;
+            item->address = item->address + offset;
           item->type = field->type;
+          item->columns = 0;
         }
       }
       position = current_token.position;
@@ -397,18 +295,20 @@ void selector(item_t *item, token_t entry_token)
         position_t index_pos = current_token.position;
         item_t index_item;
         expr(&index_item);
-        if (item->addressing != addressing_indirect && index_item.addressing == addressing_immediate) {
-          if (index_item.value < 0 || index_item.value > item->type->length - 1) {
-            mark_at(error_parser, index_pos, "Index is out of bounds.");
-            item->type = NULL;
-          }
-          else {
-            item->address = item->address + (index_item.value * item->type->base->size);
-            item->type = item->type->base;
-          }
+        // Índices constantes são verificados aqui mesmo quando o vetor é acessado indiretamente
+        if (index_item.addressing == addressing_immediate &&
+            (index_item.value < 0 || index_item.value > item->type->length - 1)) {
+          mark_at(error_parser, index_pos, "Index is out of bounds.");
+          item->type = NULL;
         }
         else {
-          write_index_offset(item, &index_item);
+          // Os elementos de uma estrutura de vetores estão a uma posição de distância na coluna
+          unsigned int size = item->type->columns ? 1 : item->type->base->size;
+          if (item->addressing != addressing_indirect && index_item.addressing == addressing_immediate)
+            item->address = item->address + (index_item.value * size);
+          else
+            write_index_offset(item, &index_item);
+          item->columns = item->type->columns ? item->type->length : 0;
           item->type = item->type->base;
         }
       }
@@ -424,27 +324,24 @@ void selector(item_t *item, token_t entry_token)
 // factor = id selector | number | "(" expr ")" | "~" factor
 void factor(item_t *item)
 {
+  // As cadeias de desvios de “&” e “OR” (ver “write_short_circuit”) começam vazias em cada fator
+  if (item)
+    item->true_links = item->false_links = NULL;
   if (try_assert(symbol_id)) {
     // TODO: Remover as verificações para “item” quando possível
     token_t entry_token = current_token;
     if (item)
-      item->addressing = addressing_unknown;
+      unknown_item(item);
     entry_t *entry = find_entry(current_token.lexem.id, symbol_table);
     if (!entry)
-      mark(error_parser, "\"%s\" hasn't been declared yet.", current_token.lexem.id);
+      mark(error_parser, "\"%s\" hasn't been declared yet.", id_for_atom(current_token.lexem.id));
     else {
       // Como a tabela de símbolos armazena tanto variáveis e constantes, quanto tipos e procedimentos, é possível que o
       // identificador encontrado não seja um fator válido (variável ou constante)
       if (entry->class != class_var && entry->class != class_const)
-        mark(error_parser, "\"%s\" is not a valid factor.", current_token.lexem.id);
-      else {
-        if (item) {
-          item->addressing = (addressing_t)entry->class;
-          item->address = entry->address;
-          item->type = entry->type;
-          item->value = entry->value;
-        }
-      }
+        mark(error_parser, "\"%s\" is not a valid factor.", id_for_atom(current_token.lexem.id));
+      else if (item)
+        entry_item(entry, item);
     }
     scan();
     selector(item, entry_token);
@@ -452,6 +349,7 @@ void factor(item_t *item)
   else if (try_assert(symbol_number)) {
     if (item) {
       item->addressing = addressing_immediate;
+      item->type = integer_type->type;
       item->value = current_token.value;
     }
     scan();
@@ -471,8 +369,10 @@ void factor(item_t *item)
   }
   else {
     mark(error_parser, "Missing factor.");
+    if (item)
+      unknown_item(item);
     // Sincroniza
-    while (!is_follow("factor", current_token.lexem.symbol) && scan());
+    while (!is_follow(non_terminal_factor, current_token.lexem.symbol) && scan());
   }
 }
 
@@ -483,7 +383,7 @@ void term(item_t *item)
   while (current_token.lexem.symbol >= symbol_times && current_token.lexem.symbol <= symbol_and) {
     symbol_t symbol = current_token.lexem.symbol;
     consume(symbol);
-    // TODO: Gerar a instrução de salto para o caminho falso para o operador lógico “&”
+    write_short_circuit(symbol, item);
     item_t rhs_item;
     factor(&rhs_item);
     write_binary_op(symbol, item, &rhs_item);
@@ -504,7 +404,7 @@ void simple_expr(item_t *item)
   while (current_token.lexem.symbol >= symbol_plus && current_token.lexem.symbol <= symbol_or) {
     symbol_t symbol = current_token.lexem.symbol;
     consume(symbol);
-    // TODO: Gerar a instrução de salto para o caminho verdadeiro para o operador lógico “or”
+    write_short_circuit(symbol, item);
     item_t rhs_item;
     term(&rhs_item);
     write_binary_op(symbol, item, &rhs_item);
@@ -525,29 +425,70 @@ void expr(item_t *item)
   }
 }
 
+// Confere o parâmetro com o formal correspondente: os passados por referência precisam ser variáveis do mesmo tipo e os
+// passados por valor, de tipos atômicos
+void actual_param(item_t *item, const entry_t *formal, position_t position)
+{
+  if (formal && formal->reference) {
+    if (item->addressing != addressing_direct && item->addressing != addressing_indirect) {
+      // Sem endereço, o argumento não pode ser escrito pelo procedimento (nem pela sua expansão no local da chamada)
+      mark_at(error_parser, position, "A variable is expected for the parameter \"%s\".", id_for_atom(formal->id));
+      unknown_item(item);
+      return;
+    }
+    else if (item->type && formal->type && item->type != formal->type)
+      mark_at(error_parser, position, "Incompatible type for the parameter \"%s\".", id_for_atom(formal->id));
+    else if (item->columns)
+      mark_at(error_parser, position, "An element laid out as columns cannot be passed as \"%s\".",
+              id_for_atom(formal->id));
+  }
+  else if (formal && item->type && item->type->form != form_atomic)
+    mark_at(error_parser, position, "Incompatible type for the parameter \"%s\".", id_for_atom(formal->id));
+  write_actual_param(item, formal && formal->reference);
+}
+
 // actual_params = "(" [expr {"," expr}] ")"
-void actual_params()
+// Retorna a quantidade de parâmetros, dos quais os MAX_PARAMETERS primeiros ficam em “params”
+unsigned int actual_params(entry_t *entry, item_t *params)
 {
   try_assert(symbol_open_paren);
   position_t open_pos = current_token.position;
   scan();
-  if (is_first("expr", current_token.lexem.symbol)) {
-    item_t item;
-    expr(&item);
-    while (try_consume(symbol_comma))
+  unsigned int count = 0;
+  entry_t *formal = entry && entry->class == class_proc ? entry->parameters : NULL;
+  if (is_first(non_terminal_expr, current_token.lexem.symbol)) {
+    do {
+      item_t item;
+      item.links = NULL;
+      position_t position = current_token.position;
       expr(&item);
+      actual_param(&item, formal, position);
+      if (count < MAX_PARAMETERS)
+        params[count] = item;
+      count++;
+      formal = formal && count < entry->parameter_count ? formal->next : NULL;
+    } while (try_consume(symbol_comma));
   }
   if (try_assert(symbol_close_paren))
     scan();
   else
     mark(error_parser, "Missing \")\" for (%d, %d).", open_pos.line, open_pos.column);
+  return count;
 }
 
 // proc_call = [actual_params]
 void proc_call(entry_t *entry)
 {
-  if (is_first("actual_params", current_token.lexem.symbol))
-    actual_params();
+  item_t params[MAX_PARAMETERS];
+  unsigned int count = 0;
+  if (is_first(non_terminal_actual_params, current_token.lexem.symbol))
+    count = actual_params(entry, params);
+  if (!entry || entry->class != class_proc)
+    return;
+  if (count != entry->parameter_count)
+    mark(error_parser, "\"%s\" expects %u parameter(s).", id_for_atom(entry->id), entry->parameter_count);
+  else
+    write_call(entry, params, count);
 }
 
 void stmt_sequence();
@@ -565,10 +506,10 @@ void if_stmt()
   // Este item serve como base para o salto para o final da estrutura condicional
   end_item.addressing = addressing_condition;
   end_item.condition = symbol_null;
-  end_item.links = NULL;
+  end_item.links = end_item.true_links = end_item.false_links = NULL;
   while (try_consume(symbol_elsif)) {
     write_branch(&end_item, true);
-    write_label(&expr_item, NULL);
+    write_label(&expr_item);
     fixup_links(&expr_item);
     expr(&expr_item);
     write_inverse_branch(&expr_item, true);
@@ -577,14 +518,14 @@ void if_stmt()
   }
   if (try_consume(symbol_else)) {
     write_branch(&end_item, true);
-    write_label(&expr_item, NULL);
+    write_label(&expr_item);
     fixup_links(&expr_item);
     stmt_sequence();
   }
-	write_label(&expr_item, NULL);
+	write_label(&expr_item);
 	fixup_links(&expr_item);
 	if (end_item.links) {
-		strcpy(end_item.label, expr_item.label);
+		end_item.label = expr_item.label;
 		fixup_links(&end_item);
 	}
   consume(symbol_end);
@@ -595,17 +536,18 @@ void while_stmt()
 {
 	item_t expr_item, back_item;
   try_consume(symbol_while);
+  // O salto de volta deve reavaliar a condição, por isso o rótulo vem antes da expressão
+  back_item.addressing = addressing_condition;
+  back_item.condition = symbol_null;
+  back_item.links = back_item.true_links = back_item.false_links = NULL;
+  write_label(&back_item);
   expr_item.links = NULL;
   expr(&expr_item);
   write_inverse_branch(&expr_item, true);
   consume(symbol_do);
-  back_item.addressing = addressing_condition;
-  back_item.condition = symbol_null;
-  back_item.links = NULL;
-  write_label(&back_item, NULL);
   stmt_sequence();
   write_branch(&back_item, false);
-  write_label(&expr_item, NULL);
+  write_label(&expr_item);
   fixup_links(&expr_item);
   consume(symbol_end);
 }
@@ -616,7 +558,7 @@ void repeat_stmt()
   try_consume(symbol_repeat);
   item_t expr_item;
   expr_item.links = NULL;
-  write_label(&expr_item, NULL);
+  write_label(&expr_item);
   stmt_sequence();
   consume(symbol_until);
   expr(&expr_item);
@@ -637,42 +579,42 @@ void stmt()
 {
   if (try_assert(symbol_id)) {
     item_t item;
-    item.addressing = addressing_unknown;
+    unknown_item(&item);
     token_t entry_token = current_token;
     entry_t *entry = find_entry(current_token.lexem.id, symbol_table);
     if (!entry)
-      mark(error_parser, "\"%s\" hasn't been declared yet.", current_token.lexem.id);
+      mark(error_parser, "\"%s\" hasn't been declared yet.", id_for_atom(current_token.lexem.id));
     else {
-      if (entry->class != class_var)
-        mark(error_parser, "\"%s\" is not a variable.", entry->id);
-      else {
-        item.addressing = addressing_register;
-        item.address = entry->address;
-        item.type = entry->type;
-      }
+      // Procedimentos também são aceitos aqui, pois agora fazem parte da tabela de símbolos
+      if (entry->class != class_var && entry->class != class_proc)
+        mark(error_parser, "\"%s\" is not a variable.", id_for_atom(entry->id));
+      else if (entry->class == class_var)
+        entry_item(entry, &item);
     }
     scan();
     selector(&item, entry_token);
-    if (is_first("assignment", current_token.lexem.symbol))
+    if (is_first(non_terminal_assignment, current_token.lexem.symbol))
       assignment(&item);
-    else if (is_first("proc_call", current_token.lexem.symbol) || is_follow("proc_call", current_token.lexem.symbol))
+    else if (entry && entry->class != class_proc)
+      mark(error_parser, "\"%s\" is not a procedure.", id_for_atom(entry->id));
+    else if (is_first(non_terminal_proc_call, current_token.lexem.symbol) || is_follow(non_terminal_proc_call, current_token.lexem.symbol))
       proc_call(entry);
     else {
       mark(error_parser, "Invalid statement.");
       // Sincroniza
-      while (!is_follow("stmt", current_token.lexem.symbol) && scan());
+      while (!is_follow(non_terminal_stmt, current_token.lexem.symbol) && scan());
     }
   }
-  else if (is_first("if_stmt", current_token.lexem.symbol))
+  else if (is_first(non_terminal_if_stmt, current_token.lexem.symbol))
     if_stmt();
-  else if (is_first("while_stmt", current_token.lexem.symbol))
+  else if (is_first(non_terminal_while_stmt, current_token.lexem.symbol))
     while_stmt();
-  else if (is_first("repeat_stmt", current_token.lexem.symbol))
+  else if (is_first(non_terminal_repeat_stmt, current_token.lexem.symbol))
     repeat_stmt();
-  if (!is_follow("stmt", current_token.lexem.symbol)) {
+  if (!is_follow(non_terminal_stmt, current_token.lexem.symbol)) {
     mark(error_parser, "Missing \";\" or \"end\".");
     // Sincroniza
-    while (!is_follow("stmt", current_token.lexem.symbol) && scan());
+    while (!is_follow(non_terminal_stmt, current_token.lexem.symbol) && scan());
   }
 }
 
@@ -689,10 +631,14 @@ entry_t *id_list()
 {
   try_assert(symbol_id);
   entry_t *new_entries = create_entry(current_token.lexem.id, current_token.position, class_var);
+  entry_t *last_entry = new_entries;
   scan();
   while (try_consume(symbol_comma)) {
     if (assert(symbol_id)) {
-      add_entry(create_entry(current_token.lexem.id, current_token.position, class_var), &new_entries);
+      entry_t *new_entry = create_entry(current_token.lexem.id, current_token.position, class_var);
+      if (last_entry && new_entry)
+        last_entry->next = new_entry;
+      last_entry = new_entry;
       scan();
     }
   }
@@ -707,35 +653,33 @@ type_t *array_type()
   type_t *new_type = NULL;
   try_consume(symbol_array);
   new_type = create_type(form_array, 0, 0, NULL, NULL);
-  //  expr();
   value_t length = 0;
-  if (assert(symbol_number)) {
-    length = current_token.value;
-    scan();
-  }
+  item_t item;
+  item.links = NULL;
+  position_t position = current_token.position;
+  expr(&item);
+  // Como os números são sempre positivos, um comprimento negativo só pode vir de uma expressão constante
+  if (item.addressing != addressing_immediate)
+    mark_at(error_parser, position, "Constant expression expected.");
+  else if (item.value < 0)
+    mark_at(error_parser, position, "Invalid array length.");
+  else
+    length = item.value;
   consume(symbol_of);
-  type_t *base_type = type();
-  unsigned int size = 0;
-  if (base_type)
-    size = length * base_type->size;
-  if (new_type) {
-    new_type->length = length;
-    new_type->size = size;
-    new_type->base = base_type;
-  }
+  layout_array(new_type, length, type(), position);
   return new_type;
 }
 
 // field_list = [id_list ":" type]
 entry_t *field_list()
 {
-  if (is_first("id_list", current_token.lexem.symbol)) {
+  if (is_first(non_terminal_id_list, current_token.lexem.symbol)) {
     entry_t *new_fields = id_list();
     consume(symbol_colon);
     type_t *base_type = type();
     entry_t *e = new_fields;
     while (e) {
-      e->type = base_type;
+      e->type = declared_type(e->id, base_type, e->position);
       e = e->next;
     }
     return new_fields;
@@ -747,30 +691,19 @@ entry_t *field_list()
 type_t *record_type()
 {
   type_t *new_type = NULL;
+  position_t position = current_token.position;
   try_consume(symbol_record);
   new_type = create_type(form_record, 0, 0, NULL, NULL);
-  entry_t *fields = field_list();
-  while (try_consume(symbol_semicolon)) {
-    entry_t *more_fields = field_list();
-    if (fields && more_fields)
-      add_entry(more_fields, &fields);
-  }
-  // Efetua o cálculo do tamanho do tipo registro e dos deslocamentos de cada campo
-  unsigned int size = 0;
-  address_t offset = 0;
-  if (fields) {
-    entry_t *e = fields;
-    while (e && e->type) {
-      e->address = offset;
-      offset += e->type->size;
-      size += e->type->size;
-      e = e->next;
-    }
-  }
+  // Os campos formam um escopo próprio, sem escopo externo, pois só podem ser acessados através do registro
+  scope_t *fields = create_scope(NULL);
+  add_entry(field_list(), fields);
+  while (try_consume(symbol_semicolon))
+    add_entry(field_list(), fields);
   consume(symbol_end);
+  // Efetua o cálculo do tamanho do tipo registro e dos deslocamentos de cada campo
   if (new_type) {
-    new_type->size = size;
     new_type->fields = fields;
+    layout_record(new_type, position);
   }
   return new_type;
 }
@@ -785,16 +718,16 @@ type_t *type()
       scan();
       return entry->type;
     } else {
-      mark(error_parser, "Unknown type \"%s\".", current_token.lexem.id);
+      mark(error_parser, "Unknown type \"%s\".", id_for_atom(current_token.lexem.id));
       scan();
       return NULL;
     }
-  } else if (is_first("array_type", current_token.lexem.symbol)) {
+  } else if (is_first(non_terminal_array_type, current_token.lexem.symbol)) {
     type_t *new_type = array_type();
     if (!new_type)
       mark(error_parser, "Invalid array type.");
     return new_type;
-  } else if (is_first("record_type", current_token.lexem.symbol)) {
+  } else if (is_first(non_terminal_record_type, current_token.lexem.symbol)) {
     type_t *new_type = record_type();
     if (!new_type)
       mark(error_parser, "Invalid record type.");
@@ -802,50 +735,76 @@ type_t *type()
   }
   // Sincroniza
   mark(error_parser, "Missing type.");
-  while (!is_follow("type", current_token.lexem.symbol) && current_token.lexem.symbol != symbol_eof)
+  while (!is_follow(non_terminal_type, current_token.lexem.symbol) && current_token.lexem.symbol != symbol_eof)
     scan();
   return NULL;
 }
 
 // formal_params_section = ["var"] id_list ":" type
+// Os parâmetros passados por valor ocupam posições do registro de ativação, como as variáveis locais. Assim como no
+// Oberon-0, vetores e registros só podem ser passados por referência
 entry_t *formal_params_section()
 {
-  if (try_consume(symbol_var));
-  // TODO: Implementar a passagem de parâmetro por referência
+  bool reference = try_consume(symbol_var);
   entry_t *new_params = id_list();
   if (!consume(symbol_colon))
     mark_missing(symbol_colon);
+  position_t position = current_token.position;
   type_t *base_type = type();
+  if (!reference && base_type && base_type->form != form_atomic)
+    mark_at(error_parser, position, "Arrays and records must be passed by reference (\"var\").");
   entry_t *e = new_params;
   while (e) {
     e->type = base_type;
+    e->reference = reference;
+    if (!reference && base_type) {
+      e->address = current_address;
+      current_address += base_type->size;
+    }
     e = e->next;
   }
   return new_params;
 }
 
 // formal_params = "(" [formal_params_section {";" formal_params_section}] ")"
-entry_t *formal_params()
+// Os parâmetros são adicionados ao escopo corrente, que é o escopo do procedimento
+void formal_params()
 {
-  entry_t *params = NULL;
   try_consume(symbol_open_paren);
-  if (is_first("formal_params_section", current_token.lexem.symbol)) {
-    params = formal_params_section();
+  if (is_first(non_terminal_formal_params_section, current_token.lexem.symbol)) {
+    add_entry(formal_params_section(), symbol_table);
     while (try_consume(symbol_semicolon))
-      add_entry(formal_params_section(), &params);
+      add_entry(formal_params_section(), symbol_table);
   }
   consume(symbol_close_paren);
-  return params;
 }
 
 // proc_head = "procedure" id [formal_params]
-void proc_head()
+// O escopo do procedimento é aberto aqui e fechado em “proc_decl”, após o corpo do procedimento. Os parâmetros são as
+// primeiras entradas do escopo
+entry_t *proc_head()
 {
   try_consume(symbol_proc);
-  consume(symbol_id);
-  // TODO: Implementar parâmetros para a entrada do procedimento na tabela de símbolos
-  if (is_first("formal_params", current_token.lexem.symbol))
+  entry_t *entry = NULL;
+  if (assert(symbol_id)) {
+    entry = create_entry(current_token.lexem.id, current_token.position, class_proc);
+    add_entry(entry, symbol_table);
+    scan();
+  }
+  open_scope();
+  current_level++;
+  open_procedure(entry);
+  if (is_first(non_terminal_formal_params, current_token.lexem.symbol))
     formal_params();
+  if (entry && symbol_table) {
+    entry->parameters = symbol_table->first;
+    for (entry_t *e = entry->parameters; e; e = e->next)
+      entry->parameter_count++;
+    if (entry->parameter_count > MAX_PARAMETERS)
+      mark_at(error_parser, entry->position, "Too many parameters (at most %d).", MAX_PARAMETERS);
+  }
+  write_parameters(entry);
+  return entry;
 }
 
 void declarations();
@@ -861,11 +820,18 @@ void proc_body()
 }
 
 // proc_decl = proc_head ";" proc_body
+// As variáveis locais ocupam os endereços seguintes aos do escopo externo, que voltam a ficar livres ao fim do
+// procedimento; o gerador de código as transforma em posições do registro de ativação
 void proc_decl()
 {
+  address_t address = current_address;
   proc_head();
   consume(symbol_semicolon);
   proc_body();
+  close_procedure();
+  close_scope();
+  current_level--;
+  current_address = address;
 }
 
 // const_decl = "const" {id "=" expr ";"}
@@ -876,13 +842,17 @@ void const_decl()
     entry_t *new_entry = create_entry(current_token.lexem.id, current_token.position, class_const);
     scan();
     consume(symbol_equal);
-    // expr();
-    if (assert(symbol_number)) {
-      if (new_entry) {
-        new_entry->value = current_token.value;
-        add_entry(new_entry, &symbol_table);
-      }
-      scan();
+    // O gerador de código calcula as expressões constantes durante a compilação, sem escrever instruções
+    item_t item;
+    item.links = NULL;
+    position_t position = current_token.position;
+    expr(&item);
+    if (item.addressing != addressing_immediate)
+      mark_at(error_parser, position, "Constant expression expected.");
+    else if (new_entry) {
+      new_entry->type = item.type;
+      new_entry->value = item.value;
+      add_entry(new_entry, symbol_table);
     }
     consume(symbol_semicolon);
   }
@@ -899,8 +869,8 @@ void type_decl()
     consume(symbol_equal);
     type_t *base = type();
     if (new_entry && base) {
-      new_entry->type = base;
-      add_entry(new_entry, &symbol_table);
+      new_entry->type = declared_type(new_entry->id, base, new_entry->position);
+      add_entry(new_entry, symbol_table);
     }
     consume(symbol_semicolon);
   }
@@ -910,18 +880,19 @@ void type_decl()
 void var_decl()
 {
   try_consume(symbol_var);
-  while (is_first("id_list", current_token.lexem.symbol)) {
+  while (is_first(non_terminal_id_list, current_token.lexem.symbol)) {
     entry_t *new_entries = id_list();
     consume(symbol_colon);
     type_t *base = type();
     entry_t *e = new_entries;
     while (e && base) {
+      e->type = declared_type(e->id, base, e->position);
+      current_address = align_variable(current_address, e->type, current_level == 0);
       e->address = current_address;
-      e->type = base;
       current_address += e->type->size;
       e = e->next;
     }
-    add_entry(new_entries, &symbol_table);
+    add_entry(new_entries, symbol_table);
     consume(symbol_semicolon);
   }
 }
@@ -929,13 +900,13 @@ void var_decl()
 // declarations = [const_decl] [type_decl] [var_decl] {proc_decl ";"}
 void declarations()
 {
-  if (is_first("const_decl", current_token.lexem.symbol))
+  if (is_first(non_terminal_const_decl, current_token.lexem.symbol))
     const_decl();
-  if (is_first("type_decl", current_token.lexem.symbol))
+  if (is_first(non_terminal_type_decl, current_token.lexem.symbol))
     type_decl();
-  if (is_first("var_decl", current_token.lexem.symbol))
+  if (is_first(non_terminal_var_decl, current_token.lexem.symbol))
     var_decl();
-  while (is_first("proc_decl", current_token.lexem.symbol)) {
+  while (is_first(non_terminal_proc_decl, current_token.lexem.symbol)) {
     proc_decl();
     consume(symbol_semicolon);
   }
@@ -960,7 +931,8 @@ void module()
 bool initialize_parser(FILE *file)
 {
   should_log = false;
-  if (!initialize_table(0, &symbol_table))
+  initialize_arena(&compilation_arena);
+  if (!initialize_atoms() || !initialize_table(0))
     return false;
   initialize_scanner(file);
   read_token();
@@ -970,6 +942,15 @@ bool initialize_parser(FILE *file)
 bool parse()
 {
   module();
-  clear_table(&symbol_table);
+  finalize_parser();
   return true;
 }
+
+// Libera o estado da análise ao final de “parse” ou quando um erro fatal a interrompe (ver “error_recovery”)
+void finalize_parser()
+{
+  clear_table();
+  clear_arena(&compilation_arena);
+  finalize_scanner();
+  clear_atoms();
+}
@@ -14,5 +14,6 @@
 
 bool initialize_parser(FILE *file);
 bool parse();
+void finalize_parser();
 
 #endif
@@ -0,0 +1,223 @@
+//
+//  peephole.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "peephole.h"
+
+// As regras podem criar novas oportunidades (um desvio para a instrução seguinte só aparece depois que as instruções
+// entre eles somem), por isso as passagens se repetem até que nada mude
+#define PEEPHOLE_MAX_PASSES 8
+
+// Estado da janela: a instrução anterior já otimizada (nula no início e nos destinos de desvios, pois nesses pontos
+// a instrução anterior não é a única que pode ter sido executada antes) e quais registradores guardam valores que
+// cabem em “value_t”
+typedef struct _peephole {
+  unsigned int index;
+  const instruction_t *previous;
+  bool narrow[REGISTER_INDEX_COUNT];
+} peephole_t;
+
+// Uma regra reescreve a instrução atual ou a transforma em “NOP” para descartá-la
+typedef bool (*peephole_rule_t)(const peephole_t *state, instruction_t *current);
+
+static inline bool is_branch(opcode_t opcode)
+{
+  return opcode >= opcode_breq && opcode <= opcode_jump;
+}
+
+static inline bool same_operand(operand_t first, operand_t second)
+{
+  return first.kind == second.kind && first.value == second.value;
+}
+
+static inline bool is_memory(operand_t operand)
+{
+  return operand.kind == operand_direct || operand.kind == operand_indirect || operand.kind == operand_spill ||
+    operand.kind == operand_frame;
+}
+
+// Os imediatos têm 32 bits, então só os valores mais estreitos podem não caber em “value_t”
+static inline bool fits_value(int value)
+{
+#if VALUE_BITS < 32
+  return value >= MIN_VALUE && value <= MAX_VALUE;
+#else
+  (void)value;
+  return true;
+#endif
+}
+
+static inline void remove_instruction(instruction_t *instruction)
+{
+  instruction->opcode = opcode_nop;
+}
+
+// ADD R, 0 / SUB R, 0 / OR R, 0 / SHL R, 0 / MUL R, 1 / DIV R, 1 / AND R, -1 / MOV R, R. As operações aritméticas
+// não alteram a condição usada pelos desvios (só “CMP” a altera), por isso podem sumir sem mais verificações. Como não
+// depende das instruções anteriores, é aplicada antes das regras de “rules”
+bool remove_identity(instruction_t *current)
+{
+  operand_t src = current->src;
+  bool identity = false;
+  if (src.kind == operand_immediate)
+    switch (current->opcode) {
+      case opcode_add:
+      case opcode_sub:
+      case opcode_or:
+      case opcode_shl: identity = src.value == 0; break;
+      case opcode_mul:
+      case opcode_div: identity = src.value == 1; break;
+      case opcode_and: identity = src.value == -1; break;
+      default: break;
+    }
+  else if (current->opcode == opcode_mov)
+    identity = same_operand(current->dst, src);
+  if (identity)
+    remove_instruction(current);
+  return identity;
+}
+
+// STORE m, Rs seguido de LOAD Rd, m: o valor já está em Rs. Com NARROW_VALUES, a leitura da memória estende o sinal
+// do “value_t” guardado, então em dados ela só é dispensável se Rs já couber em “value_t”; as posições dos
+// registradores em memória guardam o valor inteiro
+bool forward_stored_value(const peephole_t *state, instruction_t *current)
+{
+  const instruction_t *previous = state->previous;
+  if (!previous || previous->opcode != opcode_store || current->opcode != opcode_load ||
+      !is_memory(current->src) || !same_operand(previous->dst, current->src))
+    return false;
+  int value = previous->src.value;
+  if (NARROW_VALUES && current->src.kind != operand_spill && (value >= REGISTER_INDEX_COUNT || !state->narrow[value]))
+    return false;
+  if (current->dst.value == value)
+    remove_instruction(current);
+  else {
+    current->opcode = opcode_mov;
+    current->src.kind = operand_register;
+    current->src.value = value;
+  }
+  return true;
+}
+
+// LOAD R, m seguido de STORE m, R: a memória já contém o valor. O endereço indireto não pode ter sido sobrescrito
+// pela própria leitura
+bool remove_redundant_store(const peephole_t *state, instruction_t *current)
+{
+  const instruction_t *previous = state->previous;
+  if (!previous || previous->opcode != opcode_load || current->opcode != opcode_store ||
+      !is_memory(previous->src) || !same_operand(previous->src, current->dst) ||
+      previous->dst.value != current->src.value ||
+      (previous->src.kind == operand_indirect && previous->src.value == previous->dst.value))
+    return false;
+  remove_instruction(current);
+  return true;
+}
+
+bool remove_branch_to_next(const peephole_t *state, instruction_t *current)
+{
+  if (!is_branch(current->opcode) || current->dst.value != (int)state->index + 1)
+    return false;
+  remove_instruction(current);
+  return true;
+}
+
+static const peephole_rule_t rules[] = {
+  forward_stored_value, remove_redundant_store, remove_branch_to_next
+};
+
+// Desvios para um “JUMP” passam a apontar diretamente para o destino final da cadeia
+bool thread_jumps(instruction_t *code, unsigned int length)
+{
+  bool changed = false;
+  for (unsigned int index = 0; index < length; index++) {
+    if (!is_branch(code[index].opcode))
+      continue;
+    unsigned int target = (unsigned int)code[index].dst.value;
+    // O limite de passos evita laços infinitos em ciclos de “JUMP”
+    for (unsigned int step = 0; step < length && target < length && code[target].opcode == opcode_jump &&
+         (unsigned int)code[target].dst.value != target; step++)
+      target = (unsigned int)code[target].dst.value;
+    if ((int)target != code[index].dst.value) {
+      code[index].dst.value = (int)target;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+// Registra se o registrador escrito pela instrução passa a guardar um valor que cabe em “value_t”
+void update_narrow(peephole_t *state, const instruction_t *instruction)
+{
+  if (instruction->dst.kind != operand_register || is_branch(instruction->opcode) ||
+      instruction->opcode == opcode_cmp || instruction->dst.value >= REGISTER_INDEX_COUNT)
+    return;
+  bool narrow = false;
+  operand_t src = instruction->src;
+  if (instruction->opcode == opcode_load)
+    narrow = src.kind == operand_direct || src.kind == operand_indirect || src.kind == operand_frame ||
+      (src.kind == operand_immediate && fits_value(src.value));
+  else if (instruction->opcode == opcode_mov && src.kind == operand_register && src.value < REGISTER_INDEX_COUNT)
+    narrow = state->narrow[src.value];
+  state->narrow[instruction->dst.value] = narrow;
+}
+
+// Uma passagem completa: as instruções mantidas são compactadas no próprio vetor e “map” guarda a nova posição de
+// cada instrução (ou da seguinte mantida, se ela sumir) para a correção dos desvios
+bool peephole_pass(instruction_t *code, unsigned int *length, bool *targets, unsigned int *map)
+{
+  unsigned int count = *length, kept = 0;
+  memset(targets, 0, ((size_t)count + 1) * sizeof(bool));
+  for (unsigned int index = 0; index < count; index++)
+    if (is_branch(code[index].opcode) && code[index].dst.value >= 0 && (unsigned int)code[index].dst.value <= count)
+      targets[code[index].dst.value] = true;
+  peephole_t state;
+  memset(&state, 0, sizeof(state));
+  bool boundary = true;
+  for (unsigned int index = 0; index < count; index++) {
+    instruction_t current = code[index];
+    map[index] = kept;
+    if (targets[index]) {
+      boundary = true;
+      memset(state.narrow, 0, sizeof(state.narrow));
+    }
+    state.index = index;
+    state.previous = boundary || kept == 0 ? NULL : &code[kept - 1];
+    remove_identity(&current);
+    for (size_t rule = 0; rule < sizeof(rules) / sizeof(rules[0]) && current.opcode != opcode_nop; rule++)
+      rules[rule](&state, &current);
+    if (current.opcode == opcode_nop)
+      continue;
+    update_narrow(&state, &current);
+    code[kept++] = current;
+    boundary = false;
+  }
+  map[count] = kept;
+  for (unsigned int index = 0; index < kept; index++)
+    if (is_branch(code[index].opcode) && code[index].dst.value >= 0 && (unsigned int)code[index].dst.value <= count)
+      code[index].dst.value = (int)map[code[index].dst.value];
+  *length = kept;
+  return kept != count;
+}
+
+bool optimize_peephole(instruction_t *code, unsigned int *length)
+{
+  bool *targets = (bool *)malloc(((size_t)*length + 1) * sizeof(bool));
+  unsigned int *map = (unsigned int *)malloc(((size_t)*length + 1) * sizeof(unsigned int));
+  bool valid = targets && map;
+  bool changed = valid;
+  for (unsigned int pass = 0; pass < PEEPHOLE_MAX_PASSES && changed; pass++) {
+    changed = thread_jumps(code, *length);
+    changed = peephole_pass(code, length, targets, map) || changed;
+  }
+  free(targets);
+  free(map);
+  return valid;
+}
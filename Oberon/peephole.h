@@ -0,0 +1,21 @@
+//
+//  peephole.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_peephole_h
+#define Oberon_peephole_h
+
+#include <stdbool.h>
+
+#include "backend.h"
+
+// Otimização por janela (“peephole”) sobre as instruções finais, já com os registradores da máquina. Uma tabela de
+// regras examina cada instrução e a anterior; as instruções descartadas são removidas do vetor e os desvios são
+// corrigidos. “length” recebe o novo tamanho
+bool optimize_peephole(instruction_t *code, unsigned int *length);
+
+#endif
@@ -0,0 +1,514 @@
+//
+//  ranges.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdbool.h>
+
+#include "ranges.h"
+#include "backend.h"
+
+// Limites da análise: variáveis acompanhadas (as usadas como índices e os seus limites nas comparações) e valores
+// conhecidos para o alargamento
+#define RANGES_MAX_VARIABLES 16
+#define RANGES_MAX_THRESHOLDS 64
+
+// Depois de tantas mudanças na entrada de um bloco (o início de um laço), as faixas que ainda crescem saltam para o
+// próximo valor conhecido, o que garante o fim da análise
+#define RANGES_WIDENING_VISITS 2
+
+#define RANGES_NONE UINT_MAX
+
+typedef struct _range {
+  long long low, high;
+} range_t;
+
+// As faixas das variáveis ficam em “value_t”, como na memória; as dos registradores, nos 32 bits da máquina
+typedef struct _ranges {
+  ir_t *ir;
+  unsigned int block_count, variable_count;
+  unsigned int *firsts;   // Primeira instrução de cada bloco; a posição “block_count” guarda o fim do módulo
+  unsigned int *block_of; // Bloco de cada instrução
+  unsigned int *slots;    // Posição de cada endereço entre as variáveis acompanhadas ou RANGES_NONE
+  range_t *entries;       // Faixas das variáveis na entrada de cada bloco
+  unsigned char *visits;  // Mudanças na entrada de cada bloco (zero enquanto ele não é alcançado)
+  bool *pending;
+  bool changed;
+  range_t *registers;     // Faixas dos registradores calculadas no bloco atual, válidas quando “stamps” coincide
+  unsigned int *stamps;
+  unsigned int stamp;
+  unsigned int current[RANGES_MAX_VARIABLES]; // Registrador que guarda o valor atual de cada variável no bloco
+  long long thresholds[RANGES_MAX_THRESHOLDS];
+  unsigned int threshold_count;
+} ranges_t;
+
+static inline range_t create_range(long long low, long long high)
+{
+  range_t range = { low, high };
+  return range;
+}
+
+static inline range_t value_range()
+{
+  return create_range(MIN_VALUE, MAX_VALUE);
+}
+
+static inline range_t word_range()
+{
+  return create_range(MIN_WORD, MAX_WORD);
+}
+
+// Um resultado fora de “word_t” dá a volta nos registradores da máquina e pode ser qualquer valor
+static inline range_t register_range(long long low, long long high)
+{
+  if (low < MIN_WORD || high > MAX_WORD)
+    return word_range();
+  return create_range(low, high);
+}
+
+static inline long long min_of(long long first, long long second) { return first < second ? first : second; }
+static inline long long max_of(long long first, long long second) { return first > second ? first : second; }
+
+// Soma que fica nos extremos de “long long” em vez de transbordar (os registradores de 64 bits ocupam toda a faixa)
+static inline long long saturated_add(long long first, long long second)
+{
+  long long result;
+  if (checked_add(first, second, &result))
+    return result;
+  return second > 0 ? LLONG_MAX : LLONG_MIN;
+}
+
+range_t operand_range(const ranges_t *ranges, ir_operand_t operand)
+{
+  switch (operand.kind) {
+    case ir_operand_register:
+      if (ranges->stamps[operand.value] == ranges->stamp)
+        return ranges->registers[operand.value];
+      return word_range();
+    case ir_operand_constant:
+    case ir_operand_address:
+      return create_range(operand.value, operand.value);
+    default:
+      return word_range();
+  }
+}
+
+// Faixa do resultado de uma instrução, a partir das faixas dos operandos
+range_t compute_range(const ranges_t *ranges, const range_t *state, const ir_instruction_t *instruction)
+{
+  range_t a = operand_range(ranges, instruction->a), b = operand_range(ranges, instruction->b);
+  bool constant = instruction->b.kind == ir_operand_constant;
+  switch (instruction->opcode) {
+    case ir_move:
+      return a;
+    case ir_load:
+      if (instruction->a.kind == ir_operand_address && ranges->slots[instruction->a.value] != RANGES_NONE)
+        return state[ranges->slots[instruction->a.value]];
+      return value_range();
+    case ir_add: {
+      long long low, high;
+      if (!checked_add(a.low, b.low, &low) || !checked_add(a.high, b.high, &high))
+        break;
+      return register_range(low, high);
+    }
+    case ir_sub: {
+      long long low, high;
+      if (!checked_sub(a.low, b.high, &low) || !checked_sub(a.high, b.low, &high))
+        break;
+      return register_range(low, high);
+    }
+    case ir_mul: {
+      long long products[4];
+      if (!checked_mul(a.low, b.low, &products[0]) || !checked_mul(a.low, b.high, &products[1]) ||
+          !checked_mul(a.high, b.low, &products[2]) || !checked_mul(a.high, b.high, &products[3]))
+        break;
+      return register_range(min_of(min_of(products[0], products[1]), min_of(products[2], products[3])),
+                            max_of(max_of(products[0], products[1]), max_of(products[2], products[3])));
+    }
+    case ir_shl: {
+      long long low, high;
+      if (!constant || b.low < 0 || b.low > WORD_BITS - 2 || !checked_mul(a.low, 1LL << b.low, &low) ||
+          !checked_mul(a.high, 1LL << b.low, &high))
+        break;
+      return register_range(low, high);
+    }
+    case ir_div:
+      // A divisão trunca o quociente, o que preserva a ordem quando o divisor é positivo
+      if (!constant || b.low <= 0)
+        break;
+      return create_range(a.low / b.low, a.high / b.low);
+    case ir_mod:
+      // O resto tem o sinal do dividendo
+      if (!constant || b.low <= 0)
+        break;
+      return create_range(a.low >= 0 ? 0 : -(b.low - 1), a.high <= 0 ? 0 : min_of(b.low - 1, max_of(a.high, 0)));
+    case ir_and:
+      if (a.low >= 0 && b.low >= 0)
+        return create_range(0, min_of(a.high, b.high));
+      if (a.low >= 0 || b.low >= 0)
+        return create_range(0, a.low >= 0 ? a.high : b.high);
+      break;
+    case ir_neg:
+      // A negação do menor valor de “word_t” é ele mesmo
+      if (a.low == MIN_WORD)
+        break;
+      return register_range(-a.high, -a.low);
+    case ir_not:
+      return register_range(~a.high, ~a.low);
+    default:
+      break;
+  }
+  return word_range();
+}
+
+// Restringe a faixa do operando a [low, high]. Se ele for um registrador, a nova faixa vale para o resto do bloco
+// (apenas quando “local”) e para as variáveis cujo valor ele ainda guarda. Retorna falso se a faixa ficar vazia, ou
+// seja, se o caminho for impossível
+bool restrict_operand(ranges_t *ranges, range_t *state, ir_operand_t operand, long long low, long long high,
+                      bool local)
+{
+  range_t range = operand_range(ranges, operand);
+  range.low = max_of(range.low, low);
+  range.high = min_of(range.high, high);
+  if (range.low > range.high)
+    return false;
+  if (operand.kind != ir_operand_register)
+    return true;
+  if (local) {
+    ranges->registers[operand.value] = range;
+    ranges->stamps[operand.value] = ranges->stamp;
+  }
+  for (unsigned int variable = 0; variable < ranges->variable_count; variable++)
+    if (ranges->current[variable] == (unsigned int)operand.value) {
+      state[variable].low = max_of(state[variable].low, range.low);
+      state[variable].high = min_of(state[variable].high, range.high);
+    }
+  return true;
+}
+
+// Aplica “a relação b” às faixas das variáveis envolvidas. Retorna falso se a relação nunca puder valer
+bool restrict_relation(ranges_t *ranges, range_t *state, symbol_t relation, ir_operand_t a, ir_operand_t b)
+{
+  range_t first = operand_range(ranges, a), second = operand_range(ranges, b);
+  switch (relation) {
+    case symbol_equal:
+      return restrict_operand(ranges, state, a, second.low, second.high, false) &&
+        restrict_operand(ranges, state, b, first.low, first.high, false);
+    case symbol_not_equal:
+      // Apenas uma constante nas pontas da faixa do outro operando a reduz
+      if (second.low == second.high && first.low == first.high)
+        return first.low != second.low;
+      if (second.low == second.high)
+        return restrict_operand(ranges, state, a, saturated_add(first.low, first.low == second.low),
+                                saturated_add(first.high, -(first.high == second.low)), false);
+      if (first.low == first.high)
+        return restrict_operand(ranges, state, b, saturated_add(second.low, second.low == first.low),
+                                saturated_add(second.high, -(second.high == first.low)), false);
+      return true;
+    case symbol_less:
+      return restrict_operand(ranges, state, a, LLONG_MIN, saturated_add(second.high, -1), false) &&
+        restrict_operand(ranges, state, b, saturated_add(first.low, 1), LLONG_MAX, false);
+    case symbol_less_equal:
+      return restrict_operand(ranges, state, a, LLONG_MIN, second.high, false) &&
+        restrict_operand(ranges, state, b, first.low, LLONG_MAX, false);
+    case symbol_greater:
+      return restrict_operand(ranges, state, a, saturated_add(second.low, 1), LLONG_MAX, false) &&
+        restrict_operand(ranges, state, b, LLONG_MIN, saturated_add(first.high, -1), false);
+    case symbol_greater_equal:
+      return restrict_operand(ranges, state, a, second.low, LLONG_MAX, false) &&
+        restrict_operand(ranges, state, b, LLONG_MIN, first.high, false);
+    default:
+      return true;
+  }
+}
+
+// Próximo valor conhecido abaixo de “low” ou acima de “high”; os extremos de “value_t” sempre estão entre eles
+long long widen(const ranges_t *ranges, long long value, bool upward)
+{
+  if (upward) {
+    for (unsigned int index = 0; index < ranges->threshold_count; index++)
+      if (ranges->thresholds[index] >= value)
+        return ranges->thresholds[index];
+    return MAX_VALUE;
+  }
+  for (unsigned int index = ranges->threshold_count; index > 0; index--)
+    if (ranges->thresholds[index - 1] <= value)
+      return ranges->thresholds[index - 1];
+  return MIN_VALUE;
+}
+
+// Junta “state” à entrada do bloco; o bloco volta a ser visitado se a entrada mudar
+void propagate(ranges_t *ranges, unsigned int block, const range_t *state)
+{
+  if (block >= ranges->block_count)
+    return;
+  range_t *entry = &ranges->entries[(size_t)block * ranges->variable_count];
+  bool grown = ranges->visits[block] == 0;
+  if (grown)
+    memcpy(entry, state, ranges->variable_count * sizeof(range_t));
+  else
+    for (unsigned int variable = 0; variable < ranges->variable_count; variable++) {
+      long long low = min_of(entry[variable].low, state[variable].low);
+      long long high = max_of(entry[variable].high, state[variable].high);
+      if (low == entry[variable].low && high == entry[variable].high)
+        continue;
+      if (ranges->visits[block] >= RANGES_WIDENING_VISITS) {
+        if (low < entry[variable].low)
+          low = widen(ranges, low, false);
+        if (high > entry[variable].high)
+          high = widen(ranges, high, true);
+      }
+      entry[variable] = create_range(low, high);
+      grown = true;
+    }
+  if (!grown)
+    return;
+  if (ranges->visits[block] < UCHAR_MAX)
+    ranges->visits[block]++;
+  ranges->pending[block] = true;
+  ranges->changed = true;
+}
+
+// Percorre o bloco a partir da faixa de entrada. Com “apply”, as entradas já são definitivas: em vez de propagar as
+// faixas, remove os limites das verificações que sempre valem. Retorna verdadeiro se alguma verificação sumiu
+bool visit_block(ranges_t *ranges, unsigned int block, bool apply)
+{
+  range_t state[RANGES_MAX_VARIABLES], taken[RANGES_MAX_VARIABLES];
+  memcpy(state, &ranges->entries[(size_t)block * ranges->variable_count], ranges->variable_count * sizeof(range_t));
+  for (unsigned int variable = 0; variable < ranges->variable_count; variable++)
+    ranges->current[variable] = RANGES_NONE;
+  ranges->stamp++;
+  bool removed = false;
+  const ir_instruction_t *compare = NULL;
+  unsigned int end = ranges->firsts[block + 1];
+  for (unsigned int index = ranges->firsts[block]; index < end; index++) {
+    ir_instruction_t *instruction = &ranges->ir->instructions[index];
+    ir_operand_t a = instruction->a, b = instruction->b;
+    switch (instruction->opcode) {
+      case ir_nop:
+        break;
+      case ir_store:
+        if (a.kind == ir_operand_address && ranges->slots[a.value] != RANGES_NONE) {
+          // A memória guarda apenas um “value_t”: um valor maior chega truncado
+          unsigned int variable = ranges->slots[a.value];
+          range_t range = operand_range(ranges, b);
+          bool narrow = range.low >= MIN_VALUE && range.high <= MAX_VALUE;
+          state[variable] = narrow ? range : value_range();
+          ranges->current[variable] = narrow && b.kind == ir_operand_register ? (unsigned int)b.value : RANGES_NONE;
+        }
+        break;
+      case ir_compare:
+        compare = instruction;
+        break;
+      case ir_call:
+        // Um procedimento chamado pode escrever em qualquer variável
+        for (unsigned int variable = 0; variable < ranges->variable_count; variable++) {
+          state[variable] = value_range();
+          ranges->current[variable] = RANGES_NONE;
+        }
+        break;
+      case ir_check: {
+        range_t range = operand_range(ranges, a);
+        if (apply && range.low >= 0)
+          instruction->condition &= ~IR_CHECK_LOWER;
+        if (apply && range.high < b.value)
+          instruction->condition &= ~IR_CHECK_UPPER;
+        if (apply && instruction->condition == 0) {
+          instruction->opcode = ir_nop;
+          removed = true;
+        }
+        // Depois da verificação, o índice está dentro dos limites
+        restrict_operand(ranges, state, a, 0, (long long)b.value - 1, true);
+        break;
+      }
+      case ir_branch:
+        if (apply)
+          return removed;
+        memcpy(taken, state, ranges->variable_count * sizeof(range_t));
+        if (!compare || restrict_relation(ranges, taken, (symbol_t)instruction->condition, compare->a, compare->b))
+          propagate(ranges, ranges->block_of[instruction->dst], taken);
+        if (compare && !restrict_relation(ranges, state, inverse_condition((symbol_t)instruction->condition),
+                                          compare->a, compare->b))
+          return removed;
+        break;
+      case ir_jump:
+        if (!apply)
+          propagate(ranges, ranges->block_of[instruction->dst], state);
+        return removed;
+      default:
+        if (instruction->dst >= ranges->ir->register_count)
+          break;
+        ranges->registers[instruction->dst] = compute_range(ranges, state, instruction);
+        ranges->stamps[instruction->dst] = ranges->stamp;
+        if (instruction->opcode == ir_load && a.kind == ir_operand_address && ranges->slots[a.value] != RANGES_NONE)
+          ranges->current[ranges->slots[a.value]] = instruction->dst;
+        break;
+    }
+  }
+  if (!apply)
+    propagate(ranges, block + 1, state);
+  return removed;
+}
+
+// Endereço da variável lida diretamente (ou somada a uma constante) para calcular o registrador, se houver
+unsigned int source_address(const ir_t *ir, const unsigned int *definitions, const bool *indexed, ir_operand_t operand,
+                            bool offset)
+{
+  if (operand.kind != ir_operand_register || definitions[operand.value] == RANGES_NONE)
+    return RANGES_NONE;
+  const ir_instruction_t *instruction = &ir->instructions[definitions[operand.value]];
+  if (instruction->opcode == ir_load && instruction->a.kind == ir_operand_address && !indexed[instruction->a.value])
+    return (unsigned int)instruction->a.value;
+  if (offset && (instruction->opcode == ir_add || instruction->opcode == ir_sub) &&
+      instruction->b.kind == ir_operand_constant)
+    return source_address(ir, definitions, indexed, instruction->a, false);
+  return RANGES_NONE;
+}
+
+void add_variable(ranges_t *ranges, unsigned int address)
+{
+  if (address != RANGES_NONE && ranges->slots[address] == RANGES_NONE &&
+      ranges->variable_count < RANGES_MAX_VARIABLES)
+    ranges->slots[address] = ranges->variable_count++;
+}
+
+void add_threshold(ranges_t *ranges, long long value)
+{
+  if (value < MIN_VALUE || value > MAX_VALUE || ranges->threshold_count == RANGES_MAX_THRESHOLDS)
+    return;
+  unsigned int position = 0;
+  while (position < ranges->threshold_count && ranges->thresholds[position] < value)
+    position++;
+  if (position < ranges->threshold_count && ranges->thresholds[position] == value)
+    return;
+  memmove(&ranges->thresholds[position + 1], &ranges->thresholds[position],
+          (ranges->threshold_count - position) * sizeof(long long));
+  ranges->thresholds[position] = value;
+  ranges->threshold_count++;
+}
+
+// Escolhe as variáveis acompanhadas: primeiro as que dão origem aos índices verificados, depois as que são comparadas
+// com elas (os limites dos laços). Também reúne os valores usados no alargamento
+bool select_variables(ranges_t *ranges)
+{
+  ir_t *ir = ranges->ir;
+  unsigned int *definitions = (unsigned int *)malloc(((size_t)ir->register_count + 1) * sizeof(unsigned int));
+  bool *indexed = create_indexed_map(ir, MAX_ADDRESS + 1);
+  if (!definitions || !indexed) {
+    free(definitions);
+    free(indexed);
+    return false;
+  }
+  for (unsigned int reg = 0; reg < ir->register_count; reg++)
+    definitions[reg] = RANGES_NONE;
+  for (unsigned int index = 0; index < ir->length; index++)
+    if (!is_ir_branch(ir->instructions[index].opcode) && ir->instructions[index].dst < ir->register_count)
+      definitions[ir->instructions[index].dst] = index;
+  add_threshold(ranges, MIN_VALUE);
+  add_threshold(ranges, 0);
+  add_threshold(ranges, MAX_VALUE);
+  for (unsigned int index = 0; index < ir->length; index++) {
+    const ir_instruction_t *instruction = &ir->instructions[index];
+    if (instruction->opcode == ir_check) {
+      add_variable(ranges, source_address(ir, definitions, indexed, instruction->a, true));
+      add_threshold(ranges, (long long)instruction->b.value - 1);
+    }
+  }
+  for (unsigned int index = 0; index < ir->length; index++) {
+    const ir_instruction_t *instruction = &ir->instructions[index];
+    if (instruction->opcode != ir_compare)
+      continue;
+    unsigned int first = source_address(ir, definitions, indexed, instruction->a, false);
+    unsigned int second = source_address(ir, definitions, indexed, instruction->b, false);
+    if ((first != RANGES_NONE && ranges->slots[first] != RANGES_NONE) ||
+        (second != RANGES_NONE && ranges->slots[second] != RANGES_NONE)) {
+      add_variable(ranges, first);
+      add_variable(ranges, second);
+    }
+    ir_operand_t operands[2] = { instruction->a, instruction->b };
+    for (unsigned int position = 0; position < 2; position++)
+      if (operands[position].kind == ir_operand_constant) {
+        add_threshold(ranges, (long long)operands[position].value - 1);
+        add_threshold(ranges, operands[position].value);
+        add_threshold(ranges, (long long)operands[position].value + 1);
+      }
+  }
+  free(definitions);
+  free(indexed);
+  return true;
+}
+
+bool eliminate_index_checks(ir_t *ir)
+{
+  unsigned int length = ir->length, check_count = 0;
+  for (unsigned int index = 0; index < length; index++)
+    check_count += ir->instructions[index].opcode == ir_check;
+  if (check_count == 0)
+    return true;
+  ranges_t ranges;
+  memset(&ranges, 0, sizeof(ranges));
+  ranges.ir = ir;
+  bool *leaders = create_leader_map(ir);
+  ranges.block_of = (unsigned int *)malloc(((size_t)length + 1) * sizeof(unsigned int));
+  ranges.firsts = (unsigned int *)malloc(((size_t)length + 2) * sizeof(unsigned int));
+  ranges.slots = (unsigned int *)malloc(((size_t)MAX_ADDRESS + 1) * sizeof(unsigned int));
+  ranges.registers = (range_t *)malloc(((size_t)ir->register_count + 1) * sizeof(range_t));
+  ranges.stamps = (unsigned int *)calloc((size_t)ir->register_count + 1, sizeof(unsigned int));
+  bool valid = leaders && ranges.block_of && ranges.firsts && ranges.slots && ranges.registers && ranges.stamps;
+  if (valid) {
+    for (unsigned int index = 0; index < length; index++) {
+      if (leaders[index])
+        ranges.firsts[ranges.block_count++] = index;
+      ranges.block_of[index] = ranges.block_count - 1;
+    }
+    ranges.firsts[ranges.block_count] = length;
+    ranges.block_of[length] = ranges.block_count;
+    for (unsigned int address = 0; address <= MAX_ADDRESS; address++)
+      ranges.slots[address] = RANGES_NONE;
+    valid = select_variables(&ranges);
+  }
+  unsigned int variable_count = ranges.variable_count > 0 ? ranges.variable_count : 1;
+  if (valid) {
+    ranges.entries = (range_t *)malloc(((size_t)ranges.block_count + 1) * variable_count * sizeof(range_t));
+    ranges.visits = (unsigned char *)calloc((size_t)ranges.block_count + 1, sizeof(unsigned char));
+    ranges.pending = (bool *)calloc((size_t)ranges.block_count + 1, sizeof(bool));
+    valid = ranges.entries && ranges.visits && ranges.pending;
+  }
+  if (valid && ranges.block_count > 0) {
+    // Nada se sabe sobre os valores iniciais das variáveis além de caberem em “value_t”
+    range_t initial[RANGES_MAX_VARIABLES];
+    for (unsigned int variable = 0; variable < ranges.variable_count; variable++)
+      initial[variable] = value_range();
+    propagate(&ranges, 0, initial);
+    while (ranges.changed) {
+      ranges.changed = false;
+      for (unsigned int block = 0; block < ranges.block_count; block++)
+        if (ranges.pending[block]) {
+          ranges.pending[block] = false;
+          visit_block(&ranges, block, false);
+        }
+    }
+    bool removed = false;
+    for (unsigned int block = 0; block < ranges.block_count; block++)
+      if (ranges.visits[block] > 0)
+        removed = visit_block(&ranges, block, true) || removed;
+    if (removed)
+      valid = remove_nops(ir);
+  }
+  free(leaders);
+  free(ranges.block_of);
+  free(ranges.firsts);
+  free(ranges.slots);
+  free(ranges.registers);
+  free(ranges.stamps);
+  free(ranges.entries);
+  free(ranges.visits);
+  free(ranges.pending);
+  return valid;
+}
@@ -0,0 +1,22 @@
+//
+//  ranges.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_ranges_h
+#define Oberon_ranges_h
+
+#include <stdbool.h>
+
+#include "ir.h"
+
+// Análise de faixas sobre a representação intermediária ainda sem blocos: calcula, para as variáveis usadas como
+// índices, o intervalo de valores possíveis na entrada de cada bloco, refinado pelas comparações dos desvios (como o
+// teste “k < n” de um “while”). Os limites de “ir_check” que sempre valem são removidos, e a verificação inteira some
+// quando nenhum deles resta
+bool eliminate_index_checks(ir_t *ir);
+
+#endif
@@ -0,0 +1,288 @@
+//
+//  registers.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <limits.h>
+#include <stdbool.h>
+
+#include "registers.h"
+
+// Quantidade de registradores reservados como temporários quando há valores em memória
+#define REGISTERS_TEMPORARY_COUNT 2
+
+typedef struct _loop {
+  unsigned int header, end;
+} loop_t;
+
+typedef struct _interval {
+  unsigned int start, end;
+  unsigned int location; // Registrador da máquina ou posição de memória, conforme “spilled”
+  bool used, spilled;
+} interval_t;
+
+static inline bool is_register_operand(operand_t operand)
+{
+  return operand.kind == operand_register || operand.kind == operand_indirect;
+}
+
+static inline bool is_branch(opcode_t opcode)
+{
+  return opcode >= opcode_breq && opcode <= opcode_jump;
+}
+
+// Apenas “LOAD” e “MOV” escrevem no destino sem lê-lo; “STORE”, “CMP” e os desvios não escrevem registrador algum
+static inline bool reads_destination(opcode_t opcode)
+{
+  return opcode != opcode_load && opcode != opcode_mov;
+}
+
+static inline bool writes_destination(opcode_t opcode)
+{
+  return opcode != opcode_store && opcode != opcode_cmp && !is_branch(opcode);
+}
+
+// O intervalo de cada registrador virtual vai da primeira à última instrução em que ele aparece
+void compute_intervals(const instruction_t *code, unsigned int length, interval_t *intervals)
+{
+  for (unsigned int index = 0; index < length; index++) {
+    const operand_t *operands[] = { &code[index].dst, &code[index].src };
+    for (int side = 0; side < 2; side++)
+      if (is_register_operand(*operands[side])) {
+        interval_t *interval = &intervals[operands[side]->value];
+        if (!interval->used) {
+          interval->used = true;
+          interval->start = index;
+        }
+        interval->end = index;
+      }
+  }
+}
+
+// Um valor vivo no início de um laço pode ser lido de novo depois do desvio para trás, por isso o seu intervalo é
+// estendido até esse desvio. Os intervalos são visitados em ordem de início e “loops” guarda, para cada início de laço
+// (também em ordem), o último desvio para trás até ele; ao ser estendido, o intervalo pode passar a cobrir outros laços
+void extend_intervals(interval_t **order, unsigned int count, const loop_t *loops, unsigned int loop_count)
+{
+  unsigned int first = 0;
+  for (unsigned int current = 0; current < count; current++) {
+    interval_t *interval = order[current];
+    while (first < loop_count && loops[first].header <= interval->start)
+      first++;
+    for (unsigned int loop = first; loop < loop_count && loops[loop].header <= interval->end; loop++)
+      if (loops[loop].end > interval->end)
+        interval->end = loops[loop].end;
+  }
+}
+
+// Os inícios de laços, em ordem, com o último desvio para trás de cada um
+loop_t *find_loops(const instruction_t *code, unsigned int length, unsigned int *loop_count)
+{
+  unsigned int *ends = (unsigned int *)malloc(((size_t)length + 1) * sizeof(unsigned int));
+  loop_t *loops = (loop_t *)malloc(((size_t)length + 1) * sizeof(loop_t));
+  *loop_count = 0;
+  if (!ends || !loops) {
+    free(ends);
+    free(loops);
+    return NULL;
+  }
+  for (unsigned int index = 0; index <= length; index++)
+    ends[index] = UINT_MAX;
+  for (unsigned int index = 0; index < length; index++) {
+    int target = code[index].dst.value;
+    if (is_branch(code[index].opcode) && target >= 0 && (unsigned int)target <= index &&
+        (ends[target] == UINT_MAX || ends[target] < index))
+      ends[target] = index;
+  }
+  for (unsigned int index = 0; index < length; index++)
+    if (ends[index] != UINT_MAX) {
+      loops[*loop_count].header = index;
+      loops[(*loop_count)++].end = ends[index];
+    }
+  free(ends);
+  return loops;
+}
+
+// Ordena os intervalos usados pelo início (uma contagem por posição, já que os inícios são índices de instruções)
+bool sort_intervals(interval_t *intervals, unsigned int count, unsigned int length, interval_t **order)
+{
+  unsigned int *positions = (unsigned int *)calloc((size_t)length + 2, sizeof(unsigned int));
+  if (!positions)
+    return false;
+  for (unsigned int index = 0; index < count; index++)
+    if (intervals[index].used)
+      positions[intervals[index].start + 1]++;
+  for (unsigned int index = 1; index <= length; index++)
+    positions[index] += positions[index - 1];
+  for (unsigned int index = 0; index < count; index++)
+    if (intervals[index].used)
+      order[positions[intervals[index].start]++] = &intervals[index];
+  free(positions);
+  return true;
+}
+
+// Escolhe uma posição de memória livre durante todo o intervalo; “slot_ends” guarda o maior fim entre os intervalos
+// que já ocuparam cada posição
+unsigned int allocate_slot(interval_t *interval, unsigned int **slot_ends, unsigned int *slot_count)
+{
+  for (unsigned int slot = 0; slot < *slot_count; slot++)
+    if ((*slot_ends)[slot] < interval->start) {
+      (*slot_ends)[slot] = interval->end;
+      return slot;
+    }
+  unsigned int *larger = (unsigned int *)realloc(*slot_ends, (*slot_count + 1) * sizeof(unsigned int));
+  if (!larger)
+    return UINT_MAX;
+  *slot_ends = larger;
+  larger[*slot_count] = interval->end;
+  return (*slot_count)++;
+}
+
+// Varredura linear clássica: os intervalos são visitados em ordem de início e os ativos ficam ordenados pelo fim. Os
+// registradores da redução de força são criados depois dos usados no laço, mas aparecem antes dele, por isso a ordem
+// de início não é a dos registradores virtuais
+bool scan_intervals(interval_t **order, unsigned int count, unsigned int register_count, unsigned int *spill_count,
+                    bool *spilled)
+{
+  interval_t **active = (interval_t **)malloc(register_count * sizeof(interval_t *));
+  bool *busy = (bool *)calloc(register_count, sizeof(bool));
+  unsigned int *slot_ends = NULL;
+  unsigned int active_count = 0;
+  bool valid = active && busy;
+  *spill_count = 0;
+  *spilled = false;
+  for (unsigned int current = 0; current < count && valid; current++) {
+    interval_t *interval = order[current];
+    interval->spilled = false;
+    unsigned int expired = 0;
+    while (expired < active_count && active[expired]->end < interval->start)
+      busy[active[expired++]->location] = false;
+    for (unsigned int index = expired; index < active_count; index++)
+      active[index - expired] = active[index];
+    active_count -= expired;
+    interval_t *victim = NULL;
+    unsigned int reg = 0;
+    while (reg < register_count && busy[reg])
+      reg++;
+    if (reg == register_count) {
+      // Sem registradores livres: vai para a memória o intervalo que termina mais tarde
+      victim = interval;
+      interval_t *last = active[active_count - 1];
+      if (last->end > interval->end) {
+        reg = last->location;
+        active_count--;
+        victim = last;
+      }
+    }
+    if (reg < register_count) {
+      busy[reg] = true;
+      interval->location = reg;
+      unsigned int position = active_count++;
+      while (position > 0 && active[position - 1]->end > interval->end) {
+        active[position] = active[position - 1];
+        position--;
+      }
+      active[position] = interval;
+    }
+    if (victim) {
+      victim->spilled = true;
+      victim->location = allocate_slot(victim, &slot_ends, spill_count);
+      valid = victim->location != UINT_MAX;
+      *spilled = true;
+    }
+  }
+  free(active);
+  free(busy);
+  free(slot_ends);
+  return valid;
+}
+
+// Substitui um registrador virtual pelo registrador da máquina ou, se o valor estiver em memória, pelo temporário
+static inline operand_t rewrite_operand(operand_t operand, const interval_t *intervals, unsigned int temporary)
+{
+  if (is_register_operand(operand))
+    operand.value = intervals[operand.value].spilled ? (int)temporary : (int)intervals[operand.value].location;
+  return operand;
+}
+
+static inline instruction_t spill_instruction(opcode_t opcode, operand_t dst, operand_t src)
+{
+  instruction_t instruction = { opcode, dst, src };
+  return instruction;
+}
+
+bool allocate_registers(instruction_t **code, unsigned int *length, unsigned int virtual_count,
+                        unsigned int register_count, unsigned int *spill_count)
+{
+  *spill_count = 0;
+  if (register_count <= REGISTERS_TEMPORARY_COUNT)
+    return false;
+  interval_t *intervals = (interval_t *)calloc((size_t)virtual_count + 1, sizeof(interval_t));
+  interval_t **order = (interval_t **)malloc(((size_t)virtual_count + 1) * sizeof(interval_t *));
+  unsigned int loop_count = 0, used_count = 0;
+  loop_t *loops = find_loops(*code, *length, &loop_count);
+  // Cada instrução pode precisar de duas cargas e um armazenamento extras
+  instruction_t *result = (instruction_t *)malloc(((size_t)*length * 4 + 1) * sizeof(instruction_t));
+  unsigned int *map = (unsigned int *)malloc(((size_t)*length + 1) * sizeof(unsigned int));
+  bool valid = intervals && order && loops && result && map;
+  bool spilled = false;
+  if (valid) {
+    compute_intervals(*code, *length, intervals);
+    for (unsigned int index = 0; index < virtual_count; index++)
+      used_count += intervals[index].used;
+    valid = sort_intervals(intervals, virtual_count, *length, order);
+    if (valid) {
+      extend_intervals(order, used_count, loops, loop_count);
+      valid = scan_intervals(order, used_count, register_count, spill_count, &spilled);
+    }
+    // Os temporários só são reservados quando algum valor realmente precisa ir para a memória
+    if (valid && spilled)
+      valid = scan_intervals(order, used_count, register_count - REGISTERS_TEMPORARY_COUNT, spill_count,
+                             &spilled);
+  }
+  unsigned int result_length = 0;
+  const unsigned int first_temporary = register_count - REGISTERS_TEMPORARY_COUNT;
+  for (unsigned int index = 0; index < *length && valid; index++) {
+    instruction_t instruction = (*code)[index];
+    operand_t dst = instruction.dst, src = instruction.src;
+    map[index] = result_length;
+    bool dst_spilled = is_register_operand(dst) && intervals[dst.value].spilled;
+    bool src_spilled = is_register_operand(src) && intervals[src.value].spilled;
+    bool same = dst_spilled && src_spilled && dst.value == src.value;
+    unsigned int dst_temporary = first_temporary, src_temporary = same ? first_temporary : first_temporary + 1;
+    operand_t dst_register = { operand_register, (int)dst_temporary };
+    operand_t src_register = { operand_register, (int)src_temporary };
+    operand_t dst_slot = { operand_spill, dst_spilled ? (int)intervals[dst.value].location : 0 };
+    operand_t src_slot = { operand_spill, src_spilled ? (int)intervals[src.value].location : 0 };
+    if (dst_spilled && (reads_destination(instruction.opcode) || same))
+      result[result_length++] = spill_instruction(opcode_load, dst_register, dst_slot);
+    if (src_spilled && !same)
+      result[result_length++] = spill_instruction(opcode_load, src_register, src_slot);
+    instruction.dst = rewrite_operand(dst, intervals, dst_temporary);
+    instruction.src = rewrite_operand(src, intervals, src_temporary);
+    result[result_length++] = instruction;
+    if (dst_spilled && writes_destination(instruction.opcode))
+      result[result_length++] = spill_instruction(opcode_store, dst_slot, dst_register);
+  }
+  if (valid) {
+    map[*length] = result_length;
+    for (unsigned int index = 0; index < result_length; index++)
+      if (result[index].dst.kind == operand_label && result[index].dst.value >= 0 &&
+          (unsigned int)result[index].dst.value <= *length)
+        result[index].dst.value = (int)map[result[index].dst.value];
+    free(*code);
+    *code = result;
+    *length = result_length;
+  }
+  else
+    free(result);
+  free(intervals);
+  free(order);
+  free(loops);
+  free(map);
+  return valid;
+}
@@ -0,0 +1,26 @@
+//
+//  registers.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_registers_h
+#define Oberon_registers_h
+
+#include <stdbool.h>
+
+#include "backend.h"
+
+// Alocação de registradores por varredura linear (“linear scan”). O gerador de código usa um registrador virtual novo
+// para cada valor e esta etapa os mapeia nos “register_count” registradores da máquina. Quando faltam registradores, os
+// valores cujos intervalos terminam mais tarde vão para posições de memória próprias (“operand_spill”) e os dois
+// últimos registradores passam a servir de temporários para as instruções de carga e armazenamento inseridas
+//
+// “code” é substituído por um novo vetor (alocado com “malloc”), com os índices dos desvios corrigidos; “length” e
+// “spill_count” recebem o novo tamanho e a quantidade de posições de memória usadas
+bool allocate_registers(instruction_t **code, unsigned int *length, unsigned int virtual_count,
+                        unsigned int register_count, unsigned int *spill_count);
+
+#endif
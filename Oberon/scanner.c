@@ -59,75 +59,112 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <ctype.h>
 
 #include "errors.h"
+#include "source.h"
 #include "scanner.h"
 
-FILE *input_file;
+// O código-fonte inteiro fica em memória e é percorrido diretamente por “cursor”. O caractere nulo em “source_end”
+// serve de sentinela, evitando verificações de limite na maior parte dos laços
+__thread source_t source;
+__thread const char *cursor, *source_end;
+__thread const char *line_start;
+__thread unsigned int current_line;
 
-// Variávies e constantes globais
-token_t current_token, last_token;
+// Variáveis de cada linha de execução (ver “compiler.h”) e constantes globais
+__thread token_t current_token, last_token;
 const position_t position_zero = { .line = 0, .column = 0, .index = 0 };
 
-char current_char, last_char;
-position_t current_position;
+// Palavras-chave reconhecidas por uma função de “hash” perfeita: o índice de cada uma em “keywords” é obtido somando
+// o seu comprimento aos valores associados à primeira e à última letras (“keyword_letter_values”), módulo o tamanho da
+// tabela. Os valores foram gerados por busca aleatória, à moda do “gperf”, de forma que nenhuma posição seja ocupada
+// por mais de uma palavra-chave. Ao incluir uma nova palavra-chave, os valores e as posições devem ser gerados novamente
+#define SCANNER_KEYWORD_SLOTS 32
+#define SCANNER_KEYWORD_MIN_LENGTH 2
+#define SCANNER_KEYWORD_MAX_LENGTH 9
 
-// Vetor com todas as palavras-chave da linguagem
-lexem_t keywords[] = {
-	{ .id = "do",					.symbol = symbol_do },
-	{ .id = "if",					.symbol = symbol_if },
-	{ .id = "of",					.symbol = symbol_of },
-	{ .id = "or",					.symbol = symbol_or },
-	{ .id = "end",				.symbol = symbol_end },
-	{ .id = "mod",				.symbol = symbol_mod },
-	{ .id = "var",				.symbol = symbol_var },
-	{ .id = "else",				.symbol = symbol_else },
-	{ .id = "then",				.symbol = symbol_then },
-	{ .id = "type",				.symbol = symbol_type },
-	{ .id = "array",			.symbol = symbol_array },
-	{ .id = "begin",			.symbol = symbol_begin },
-	{ .id = "const",			.symbol = symbol_const },
-	{ .id = "elsif",			.symbol = symbol_elsif },
-	{ .id = "until",			.symbol = symbol_until },
-	{ .id = "while",			.symbol = symbol_while },
-	{ .id = "record",			.symbol = symbol_record },
-	{ .id = "repeat",			.symbol = symbol_repeat },
-	{ .id = "procedure",	.symbol = symbol_proc },
-	{ .id = "div",				.symbol = symbol_div },
-	{ .id = "module",			.symbol = symbol_module }
+typedef struct _keyword {
+	const char *id;
+	size_t length;
+	symbol_t symbol;
+} keyword_t;
+
+const unsigned char keyword_letter_values[26] = {
+	12, 24, 2, 12, 0, 24, 0, 2, 9, 0, 0, 0, 28, 2, 19, 23, 0, 9, 0, 1, 9, 10, 15, 0, 24, 0
 };
-const unsigned int keywords_count = sizeof(keywords) / sizeof(lexem_t);
 
-// Vetor com todos os operadores da linguagem
-lexem_t operators[] = {
-	{ .id = "*",	.symbol = symbol_times },
-	{ .id = "&",	.symbol = symbol_and },
-	{ .id = "+",	.symbol = symbol_plus },
-	{ .id = "-",	.symbol = symbol_minus },
-	{ .id = "=",	.symbol = symbol_equal },
-	{ .id = "#",	.symbol = symbol_not_equal },
-	{ .id = "<",	.symbol = symbol_less },
-	{ .id = "<=",	.symbol = symbol_less_equal },
-	{ .id = ">",	.symbol = symbol_greater },
-	{ .id = ">=",	.symbol = symbol_greater_equal },
-	{ .id = "~",	.symbol = symbol_not },
-	{ .id = ":=",	.symbol = symbol_becomes }
+const keyword_t keywords[SCANNER_KEYWORD_SLOTS] = {
+	[0]		= { .id = "procedure",	.length = 9,	.symbol = symbol_proc },
+	[1]		= { .id = "do",					.length = 2,	.symbol = symbol_do },
+	[2]		= { .id = "module",			.length = 6,	.symbol = symbol_module },
+	[3]		= { .id = "if",					.length = 2,	.symbol = symbol_if },
+	[4]		= { .id = "else",				.length = 4,	.symbol = symbol_else },
+	[5]		= { .id = "type",				.length = 4,	.symbol = symbol_type },
+	[7]		= { .id = "then",				.length = 4,	.symbol = symbol_then },
+	[8]		= { .id = "const",			.length = 5,	.symbol = symbol_const },
+	[9]		= { .id = "array",			.length = 5,	.symbol = symbol_array },
+	[11]	= { .id = "mod",				.length = 3,	.symbol = symbol_mod },
+	[13]	= { .id = "of",					.length = 2,	.symbol = symbol_of },
+	[14]	= { .id = "until",			.length = 5,	.symbol = symbol_until },
+	[15]	= { .id = "end",				.length = 3,	.symbol = symbol_end },
+	[16]	= { .id = "repeat",			.length = 6,	.symbol = symbol_repeat },
+	[20]	= { .id = "while",			.length = 5,	.symbol = symbol_while },
+	[22]	= { .id = "var",				.length = 3,	.symbol = symbol_var },
+	[25]	= { .id = "div",				.length = 3,	.symbol = symbol_div },
+	[27]	= { .id = "record",			.length = 6,	.symbol = symbol_record },
+	[29]	= { .id = "elsif",			.length = 5,	.symbol = symbol_elsif },
+	[30]	= { .id = "or",					.length = 2,	.symbol = symbol_or },
+	[31]	= { .id = "begin",			.length = 5,	.symbol = symbol_begin }
 };
-const unsigned int operators_count = sizeof(keywords) / sizeof(lexem_t);
 
-// Vetor com todos os sinais de pontuação da linguagem
-lexem_t punctuation[] = {
-	{ .id = ".", .symbol = symbol_period },
-	{ .id = ",", .symbol = symbol_colon },
-	{ .id = ":", .symbol = symbol_comma },
-	{ .id = ")", .symbol = symbol_close_paren },
-	{ .id = "]", .symbol = symbol_close_bracket },
-	{ .id = "(", .symbol = symbol_open_paren },
-	{ .id = "[", .symbol = symbol_open_bracket },
-	{ .id = ";", .symbol = symbol_semicolon }
+// Tabela inversa com a representação textual de cada símbolo (palavras-chave, operadores e sinais de pontuação),
+// indexada pelo próprio símbolo
+const char *symbol_ids[symbol_eof + 1] = {
+	[symbol_times]					= "*",
+	[symbol_div]						= "div",
+	[symbol_mod]						= "mod",
+	[symbol_and]						= "&",
+	[symbol_plus]						= "+",
+	[symbol_minus]					= "-",
+	[symbol_or]							= "or",
+	[symbol_equal]					= "=",
+	[symbol_not_equal]			= "#",
+	[symbol_less]						= "<",
+	[symbol_less_equal]			= "<=",
+	[symbol_greater]				= ">",
+	[symbol_greater_equal]	= ">=",
+	[symbol_period]					= ".",
+	[symbol_comma]					= ",",
+	[symbol_colon]					= ":",
+	[symbol_close_paren]		= ")",
+	[symbol_close_bracket]	= "]",
+	[symbol_of]							= "of",
+	[symbol_then]						= "then",
+	[symbol_do]							= "do",
+	[symbol_open_paren]			= "(",
+	[symbol_open_bracket]		= "[",
+	[symbol_not]						= "~",
+	[symbol_becomes]				= ":=",
+	[symbol_semicolon]			= ";",
+	[symbol_end]						= "end",
+	[symbol_else]						= "else",
+	[symbol_elsif]					= "elsif",
+	[symbol_until]					= "until",
+	[symbol_if]							= "if",
+	[symbol_while]					= "while",
+	[symbol_repeat]					= "repeat",
+	[symbol_array]					= "array",
+	[symbol_record]					= "record",
+	[symbol_const]					= "const",
+	[symbol_type]						= "type",
+	[symbol_var]						= "var",
+	[symbol_proc]						= "procedure",
+	[symbol_begin]					= "begin",
+	[symbol_module]					= "module",
+	[symbol_eof]						= "EOF"
 };
-const unsigned int punctuation_count = sizeof(keywords) / sizeof(lexem_t);
 
 //
 // Analisador léxico
@@ -149,42 +186,50 @@ bool is_blank(char c)
 	return isspace(c);
 }
 
-bool is_newline(char c, char p)
+bool is_newline(char c)
 {
-	return (c == '\n' && p != '\r') || c == '\r';
+	return c == '\n' || c == '\r';
 }
 
-// Esta função é responsável por verificar se o identificar “id” é uma palavra reservada ou não
+static inline unsigned int letter_value(char c)
+{
+	return keyword_letter_values[(c | 0x20) - 'a'];
+}
+
+// Esta função é responsável por verificar se o identificador “id” (com “length” caracteres, não necessariamente
+// terminado em nulo) é uma palavra reservada ou não. Apenas uma comparação de texto é feita, com a única palavra-chave
+// que poderia corresponder ao identificador
 // O símbolo equivalente à palavra reservada é armazenado via referência no parâmetro “symbol”
-bool is_keyword(identifier_t id, symbol_t *symbol)
+bool is_keyword(const char *id, size_t length, symbol_t *symbol)
 {
-	unsigned int index = 0;
-	while (index < keywords_count && strcasecmp(keywords[index].id, id) != 0)
-		index++;
-	if (index < keywords_count) {
-		if (symbol)
-			*symbol = keywords[index].symbol;
-		return true;
-	}
 	if (symbol)
 		*symbol = symbol_null;
-	return false;
+	// Identificadores sempre começam com uma letra, mas podem terminar com um dígito
+	if (length < SCANNER_KEYWORD_MIN_LENGTH || length > SCANNER_KEYWORD_MAX_LENGTH || !is_letter(id[length - 1]))
+		return false;
+	unsigned int hash = (unsigned int)(length + letter_value(id[0]) + letter_value(id[length - 1]));
+	const keyword_t *keyword = &keywords[hash & (SCANNER_KEYWORD_SLOTS - 1)];
+	if (keyword->length != length || strncasecmp(keyword->id, id, length) != 0)
+		return false;
+	if (symbol)
+		*symbol = keyword->symbol;
+	return true;
 }
 
-char *id_for_symbol(symbol_t symbol)
+const char *id_for_symbol(symbol_t symbol)
 {
-	for (unsigned int index = 0; index < keywords_count; index++)
-		if (keywords[index].symbol == symbol)
-			return keywords[index].id;
-	for (unsigned int index = 0; index < operators_count; index++)
-		if (operators[index].symbol == symbol)
-			return operators[index].id;
-	for (unsigned int index = 0; index < punctuation_count; index++)
-		if (punctuation[index].symbol == symbol)
-			return punctuation[index].id;
+	if (symbol >= symbol_null && symbol <= symbol_eof && symbol_ids[symbol])
+		return symbol_ids[symbol];
 	return "unknown";
 }
 
+const char *id_for_lexem(lexem_t lexem)
+{
+	if (lexem.id != ATOM_NONE)
+		return id_for_atom(lexem.id);
+	return id_for_symbol(lexem.symbol);
+}
+
 symbol_t inverse_condition(symbol_t symbol)
 {
 	switch (symbol) {
@@ -199,25 +244,30 @@ symbol_t inverse_condition(symbol_t symbol)
 	return symbol_null;
 }
 
-// A razão de se criar uma função somente para isto é aproveitá-la se a codificação do arquivo de código-fonte mudar
-bool read_char()
+// Avança sobre uma quebra de linha (“\n”, “\r” ou “\r\n”), registrando o início da nova linha. A coluna de qualquer
+// posição é calculada a partir do deslocamento em relação a este início, sem contagem caractere a caractere
+void new_line()
 {
-	last_char = current_char;
-	if (fread(&current_char, sizeof(char), 1, input_file) == sizeof(char)) {
-		if (is_newline(current_char, last_char)) {
-			current_position.line++;
-			current_position.column = 0;
-		} else current_position.column++;
-		current_position.index++;
-		return true;
-	}
-	return false;
+	if (cursor[0] == '\r' && cursor[1] == '\n')
+		cursor++;
+	cursor++;
+	current_line++;
+	line_start = cursor;
+}
+
+position_t position_at(const char *p)
+{
+	position_t position;
+	position.line = current_line;
+	position.column = (unsigned int)(p - line_start) + 1;
+	position.index = (size_t)(p - source.text);
+	return position;
 }
 
 //
-// ATENÇÃO: todas as funções do analisador léxico devem garantir que “current_char” termine com o caractere subsequente
-// ao lexema reconhecido. Por exemplo, ao analisar “var x: integer”, a função “id“ será a primeira a ser invocada para
-// reconhecer “var”. Ao terminar, “current_char” deve conter o espaço em branco entre “var” e “x”
+// ATENÇÃO: todas as funções do analisador léxico devem garantir que “cursor” termine apontando para o caractere
+// subsequente ao lexema reconhecido. Por exemplo, ao analisar “var x: integer”, a função “id“ será a primeira a ser
+// invocada para reconhecer “var”. Ao terminar, “cursor” deve apontar para o espaço em branco entre “var” e “x”
 //
 // As funções “id”, “integer” e “number” fazem parte da EBNF e deveriam ser consideradas parte do analisador sintático.
 // No entanto, pela forma com que o compilador está definido, o reconhecimento de lexemas também é estipulado pela EBNF
@@ -226,48 +276,51 @@ bool read_char()
 
 void id()
 {
-	unsigned int index = 0;
-	current_token.position = current_position;
-	while (index < SCANNER_MAX_ID_LENGTH && (is_letter(current_char) || is_digit(current_char))) {
-		current_token.lexem.id[index++] = current_char;
-		if (!read_char())
-			break;
+	const char *start = cursor;
+	current_token.position = position_at(start);
+	// O valor de espalhamento do identificador é calculado durante a própria leitura
+	uint32_t hash = ATOMS_HASH_SEED;
+	while (is_letter(*cursor) || is_digit(*cursor)) {
+		hash = ATOMS_HASH_STEP(hash, *cursor);
+		cursor++;
 	}
-	// O tamanho máximo para um identificador é especificado por “id_length”, a variável “scanner_id” possui tamanho
-	// “id_length + 1” e por isso o caractere terminador pode ser incluído mesmo que o limite seja alcançado
-	current_token.lexem.id[index] = '\0';
-	if (!is_keyword(current_token.lexem.id, &current_token.lexem.symbol))
+	// Palavras-chave não precisam de átomos; os demais identificadores são internalizados sem limite de tamanho
+	size_t length = (size_t)(cursor - start);
+	current_token.lexem.id = ATOM_NONE;
+	if (!is_keyword(start, length, &current_token.lexem.symbol)) {
+		current_token.lexem.id = intern_hashed(start, length, hash);
 		current_token.lexem.symbol = symbol_id;
+	}
 }
 
-// TODO: Adicionar verificação se o número é muito longo
+// Um número maior que MAX_VALUE é apontado como erro, mas todos os seus dígitos são consumidos
 void integer()
 {
-	unsigned int index = 0;
-	current_token.position = current_position;
+	const char *start = cursor;
+	current_token.position = position_at(start);
 	current_token.value = 0;
-	identifier_t id;
-	while (index < SCANNER_MAX_ID_LENGTH && is_digit(current_char)) {
-		id[index] = current_char;
-		current_token.lexem.id[index] = current_char;
-		index++;
-		// Efetua o cálculo do valor, dígito-a-dígito, com base nos caracteres lidos
-		current_token.value = 10 * current_token.value + (current_char - '0');
-		if (!read_char())
-			break;
+	bool overflow = false;
+	while (is_digit(*cursor)) {
+		// Efetua o cálculo do valor, dígito-a-dígito, com base nos caracteres lidos, sem ultrapassar MAX_VALUE
+		value_t digit = (value_t)(*cursor - '0');
+		if (current_token.value > (MAX_VALUE - digit) / 10)
+			overflow = true;
+		else if (!overflow)
+			current_token.value = (value_t)(10 * current_token.value + digit);
+		cursor++;
 	}
-	current_token.lexem.id[index] = '\0';
+	current_token.lexem.id = intern(start, (size_t)(cursor - start));
 	current_token.lexem.symbol = symbol_number;
+	if (overflow)
+		mark(error_scanner, "The number \"%s\" is too large (at most %lld).", id_for_atom(current_token.lexem.id),
+				 (long long)MAX_VALUE);
 	// Avalia se há caracteres inválidos após os dígitos do número
-	bool invalid_ending = false;
-	while (index < SCANNER_MAX_ID_LENGTH && (is_letter(current_char) || current_char == '_')) {
-		id[index++] = current_char;
-		invalid_ending	= true;
-		if (!read_char())
-			break;
-	}
-	if (invalid_ending)
-		mark(error_warning, "\"%s\" is not a number. Assuming \"%s\".", id, current_token.lexem.id);
+	const char *digits_end = cursor;
+	while (is_letter(*cursor) || *cursor == '_')
+		cursor++;
+	if (cursor > digits_end)
+		mark(error_warning, "\"%.*s\" is not a number. Assuming \"%s\".", (int)(cursor - start), start,
+				 id_for_atom(current_token.lexem.id));
 }
 
 // Por definição, somente números positivos inteiros são reconhecidos
@@ -276,20 +329,25 @@ void number()
 	integer();
 }
 
-// Ao entrar nesta função, o analisador léxico já encontrou os caracteres "(*" que iniciam o comentário e “current_char”
-// possui o asterisco como valor
+// Ao entrar nesta função, o analisador léxico já consumiu os caracteres "(*" que iniciam o comentário
 void comment()
 {
-	current_token.position = current_position;
-	while (read_char()) {
+	current_token.position = position_at(cursor);
+	while (cursor < source_end) {
 		// Comentários aninhados
-		if (current_char == '*' && last_char == '(')
+		if (cursor[0] == '(' && cursor[1] == '*') {
+			cursor += 2;
 			comment();
+		}
 		// Fim do comentário
-		if (current_char == ')' && last_char == '*') {
-			read_char();
+		else if (cursor[0] == '*' && cursor[1] == ')') {
+			cursor += 2;
 			return;
 		}
+		else if (is_newline(*cursor))
+			new_line();
+		else
+			cursor++;
 	}
 	mark(error_fatal, "Endless comment detected.");
 	current_token.lexem.symbol = symbol_eof;
@@ -299,25 +357,30 @@ void read_token()
 {
 	last_token = current_token;
 	// Salta os caracteres em branco, incluindo símbolos de quebra de linha
-	while (is_blank(current_char))
-		read_char();
-	if (feof(input_file)) {
-		strcpy(current_token.lexem.id, "EOF");
+	while (is_blank(*cursor)) {
+		if (is_newline(*cursor))
+			new_line();
+		else
+			cursor++;
+	}
+	if (cursor >= source_end) {
+		current_token.lexem.id = ATOM_NONE;
 		current_token.lexem.symbol = symbol_eof;
+		current_token.position = position_at(source_end);
 		return;
 	}
 	// Os casos de um identificador ou um número são considerados separadamente para que o código no “switch” não precise
-	// incluir uma chamada a “read_char” em cada “case”
-	if (is_letter(current_char)) {
+	// avançar o cursor em cada “case”
+	if (is_letter(*cursor)) {
 		id();
 		return;
-	} else if (is_digit(current_char)) {
+	} else if (is_digit(*cursor)) {
 		number();
 		return;
 	}
-	current_token.position = current_position;
-	current_token.lexem.id[0] = current_char;
-	switch (current_token.lexem.id[0]) {
+	current_token.position = position_at(cursor);
+	current_token.lexem.id = ATOM_NONE;
+	switch (*cursor) {
 		case '&': current_token.lexem.symbol = symbol_and;						break;
 		case '*': current_token.lexem.symbol = symbol_times;					break;
 		case '+': current_token.lexem.symbol = symbol_plus;						break;
@@ -337,30 +400,23 @@ void read_token()
 		case '~': current_token.lexem.symbol = symbol_not;						break;
 		default:	current_token.lexem.symbol = symbol_null;						break;
 	}
-	current_token.lexem.id[1] = '\0';
-	read_char();
+	cursor++;
 	if (current_token.lexem.symbol == symbol_null) {
-		mark(error_scanner, "\"%s\" is not a valid symbol.", current_token.lexem.id);
+		mark(error_scanner, "\"%c\" is not a valid symbol.", cursor[-1]);
 		return;
 	}
 	// Os casos abaixo representam os lexemas com mais de um caracter (como “>=”, “:=” etc.)
-	if (current_token.lexem.symbol == symbol_less && current_char == '=') {
-		current_token.lexem.id[1] = '=';
-		current_token.lexem.id[2] = '\0';
-		read_char();
+	if (current_token.lexem.symbol == symbol_less && *cursor == '=') {
+		cursor++;
 		current_token.lexem.symbol = symbol_less_equal;
-	} else if (current_token.lexem.symbol == symbol_greater && current_char == '=') {
-		current_token.lexem.id[1] = '=';
-		current_token.lexem.id[2] = '\0';
-		read_char();
+	} else if (current_token.lexem.symbol == symbol_greater && *cursor == '=') {
+		cursor++;
 		current_token.lexem.symbol = symbol_greater_equal;
-	} else if (current_token.lexem.symbol == symbol_colon && current_char == '=') {
-		current_token.lexem.id[1] = '=';
-		current_token.lexem.id[2] = '\0';
-		read_char();
+	} else if (current_token.lexem.symbol == symbol_colon && *cursor == '=') {
+		cursor++;
 		current_token.lexem.symbol = symbol_becomes;
-	} else if (current_token.lexem.symbol == symbol_open_paren	&& current_char == '*') {
-		read_char();
+	} else if (current_token.lexem.symbol == symbol_open_paren	&& *cursor == '*') {
+		cursor++;
 		// Ignora os caracteres entre “(*” e “*)” como sendo comentários e entra novamente na função para buscar o próximo
 		// lexema válido
 		comment();
@@ -370,14 +426,20 @@ void read_token()
 
 void initialize_scanner(FILE *file)
 {
-	input_file = file;
-	strcpy(current_token.lexem.id, "");
+	if (!load_source(file, &source))
+		mark_not_enough_memory();
+	cursor = source.text;
+	source_end = source.text + source.length;
+	line_start = cursor;
+	current_line = 1;
+	current_token.lexem.id = ATOM_NONE;
 	current_token.position = position_zero;
 	current_token.lexem.symbol = symbol_null;
 	current_token.value = 0;
-	current_position.line = 1;
-	current_position.column = 0;
-	current_position.index = 0;
-	current_char = '\0';
-	read_char();
+}
+
+void finalize_scanner()
+{
+	unload_source(&source);
+	cursor = source_end = line_start = NULL;
 }
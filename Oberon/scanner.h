@@ -12,7 +12,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 
-#define SCANNER_MAX_ID_LENGTH 16
+#include "atoms.h"
 
 typedef enum _symbol {
 	symbol_null = 0,
@@ -66,16 +66,16 @@ typedef enum _symbol {
 
 // TODO: Organizar esta bagunça. Simplificar!
 
-typedef char identifier_t[SCANNER_MAX_ID_LENGTH + 1];
-
 typedef struct _position {
 	unsigned int line;
 	unsigned int column;
-	fpos_t index;
+	size_t index;
 } position_t;
 
+// Somente identificadores e números possuem um átomo próprio em “id”. Para os demais símbolos, “id” é “ATOM_NONE” e o
+// texto pode ser obtido por “id_for_lexem”
 typedef struct _lexem {
-	identifier_t id;
+	atom_t id;
 	symbol_t symbol;
 } lexem_t;
 
@@ -85,15 +85,17 @@ typedef struct _token {
 	position_t position;
 } token_t;
 
-extern token_t current_token, last_token;
+extern __thread token_t current_token, last_token;
 
 extern const position_t position_zero;
 
-char *id_for_symbol(symbol_t symbol);
+const char *id_for_symbol(symbol_t symbol);
+const char *id_for_lexem(lexem_t lexem);
 
 symbol_t inverse_condition(symbol_t symbol);
 
 void initialize_scanner(FILE *file);
+void finalize_scanner();
 void read_token();
 
 #endif
@@ -0,0 +1,101 @@
+//
+//  source.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+// “fileno”, “mmap” e “madvise” vêm do POSIX e das extensões do sistema, fora do C99
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SOURCE_USE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "source.h"
+
+#ifdef SOURCE_USE_MMAP
+// O mapeamento só é usado quando o tamanho do arquivo não é múltiplo do tamanho da página: o restante da última página
+// é preenchido com zeros pelo sistema e o caractere nulo sentinela fica disponível sem cópia alguma
+bool map_source(FILE *file, source_t *source)
+{
+	struct stat info;
+	int descriptor = fileno(file);
+	if (descriptor < 0 || fstat(descriptor, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0)
+		return false;
+	long page_size = sysconf(_SC_PAGESIZE);
+	if (page_size <= 0 || info.st_size % page_size == 0)
+		return false;
+	void *text = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	if (text == MAP_FAILED)
+		return false;
+#ifdef MADV_SEQUENTIAL
+	madvise(text, (size_t)info.st_size, MADV_SEQUENTIAL);
+#endif
+	source->text = text;
+	source->length = (size_t)info.st_size;
+	source->mapped = true;
+	return true;
+}
+#endif
+
+// Leitura em blocos grandes para os casos em que o mapeamento não é possível
+bool read_source(FILE *file, source_t *source)
+{
+	size_t capacity = SOURCE_BLOCK_SIZE, length = 0;
+	char *text = (char *)malloc(capacity + 1);
+	if (!text)
+		return false;
+	size_t count;
+	while ((count = fread(text + length, sizeof(char), capacity - length, file)) > 0) {
+		length += count;
+		if (length == capacity) {
+			capacity *= 2;
+			char *larger = (char *)realloc(text, capacity + 1);
+			if (!larger) {
+				free(text);
+				return false;
+			}
+			text = larger;
+		}
+	}
+	text[length] = '\0';
+	source->text = text;
+	source->length = length;
+	source->mapped = false;
+	return true;
+}
+
+bool load_source(FILE *file, source_t *source)
+{
+	if (!file || !source)
+		return false;
+#ifdef SOURCE_USE_MMAP
+	if (map_source(file, source))
+		return true;
+#endif
+	return read_source(file, source);
+}
+
+void unload_source(source_t *source)
+{
+	if (!source || !source->text)
+		return;
+#ifdef SOURCE_USE_MMAP
+	if (source->mapped)
+		munmap((void *)source->text, source->length);
+	else
+#endif
+		free((void *)source->text);
+	source->text = NULL;
+	source->length = 0;
+	source->mapped = false;
+}
@@ -0,0 +1,29 @@
+//
+//  source.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_source_h
+#define Oberon_source_h
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// Tamanho de cada bloco lido quando o arquivo não pode ser mapeado em memória (“pipes”, “stdin” etc.)
+#define SOURCE_BLOCK_SIZE (64 * 1024)
+
+// O conteúdo completo do código-fonte fica disponível em “text”, sempre terminado por um caractere nulo que serve de
+// sentinela para o analisador léxico
+typedef struct _source {
+	const char *text;
+	size_t length;
+	bool mapped;
+} source_t;
+
+bool load_source(FILE *file, source_t *source);
+void unload_source(source_t *source);
+
+#endif
@@ -0,0 +1,594 @@
+//
+//  strength.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "strength.h"
+#include "backend.h"
+
+// Cada valor reduzido ocupa um registrador durante todo o laço, por isso a quantidade por laço é limitada
+#define STRENGTH_MAX_REDUCTIONS 4
+#define STRENGTH_MAX_VARIABLES 16
+// Limite das escalas e deslocamentos acompanhados, bem abaixo do transbordamento de “int”
+#define STRENGTH_MAX_FACTOR 0x10000
+#define STRENGTH_NONE UINT_MAX
+
+// Forma afim de um registrador virtual: “variável * scale + offset”, somada ao endereço “base” quando ele não é
+// negativo. “root” é o índice da leitura da variável que deu origem ao valor e “loop” identifica o laço em que a forma
+// foi calculada (zero indica nenhuma)
+typedef struct _affine {
+  unsigned int loop;
+  int variable, scale, offset, base;
+  unsigned int root;
+} affine_t;
+
+// Um valor reduzido e o registrador que o acompanha ao longo do laço
+typedef struct _reduction {
+  int variable, scale, offset, base;
+  unsigned int reg;
+} reduction_t;
+
+// Uma variável pode ser reduzida no laço se não é escrita nele ou se a única escrita é o incremento “store” por “step”
+typedef struct _induction {
+  int variable;
+  bool valid;
+  unsigned int store;
+  int step;
+} induction_t;
+
+// Teste do início de um laço “while”: “variável relação limite” mantém o laço executando; “index” é o desvio de saída
+typedef struct _guard {
+  int variable;
+  symbol_t relation;
+  bool constant;
+  int bound;
+  unsigned int index;
+} guard_t;
+
+// Instrução a inserir antes da posição “position” do vetor original. Os incrementos (logo após a escrita da variável)
+// vêm antes das iniciações (antes do início do laço)
+typedef struct _insertion {
+  unsigned int position;
+  bool preheader;
+  unsigned int sequence;
+  ir_instruction_t instruction;
+} insertion_t;
+
+typedef struct _loop {
+  unsigned int header, end;
+} loop_t;
+
+typedef struct _strength {
+  ir_t *ir;
+  unsigned int length, form_count;
+  affine_t *forms;
+  unsigned int *ends;       // Para cada início de laço, o último desvio para trás até ele
+  unsigned int *leaders;    // Quantidade acumulada de inícios de blocos até cada instrução
+  unsigned int *store_counts, *store_indices;
+  bool *indexed;            // Endereços que as escritas indiretas podem alcançar
+  bool indirect;            // O laço atual tem escritas indiretas
+  unsigned int *orphans;    // Registradores cujos usos foram substituídos
+  size_t orphan_count;
+  insertion_t *insertions;
+  size_t insertion_count, insertion_capacity;
+} strength_t;
+
+static inline bool fits(long long value)
+{
+  return value > -STRENGTH_MAX_FACTOR && value < STRENGTH_MAX_FACTOR;
+}
+
+static inline bool is_trivial(const affine_t *form)
+{
+  return form->scale == 1 && form->offset == 0 && form->base < 0;
+}
+
+static inline affine_t *affine_form(strength_t *strength, ir_operand_t operand, unsigned int loop)
+{
+  if (operand.kind != ir_operand_register || (unsigned int)operand.value >= strength->form_count)
+    return NULL;
+  affine_t *form = &strength->forms[operand.value];
+  return form->loop == loop ? form : NULL;
+}
+
+static inline bool has_form(strength_t *strength, unsigned int reg, unsigned int loop)
+{
+  return reg < strength->form_count && strength->forms[reg].loop == loop;
+}
+
+static inline symbol_t mirrored_relation(symbol_t relation)
+{
+  switch (relation) {
+    case symbol_less: return symbol_greater;
+    case symbol_less_equal: return symbol_greater_equal;
+    case symbol_greater: return symbol_less;
+    case symbol_greater_equal: return symbol_less_equal;
+    default: return relation;
+  }
+}
+
+// Calcula a forma afim do resultado da instrução, se ela existir
+void compute_form(strength_t *strength, unsigned int index, unsigned int loop)
+{
+  const ir_instruction_t *instruction = &strength->ir->instructions[index];
+  if (is_ir_branch(instruction->opcode) || instruction->dst >= strength->form_count)
+    return;
+  ir_operand_t a = instruction->a, b = instruction->b;
+  affine_t *source = affine_form(strength, a, loop);
+  // Nas operações comutativas, a forma passa para a esquerda
+  if (!source && (instruction->opcode == ir_add || instruction->opcode == ir_mul)) {
+    source = affine_form(strength, b, loop);
+    b = a;
+  }
+  affine_t form;
+  if (instruction->opcode == ir_load && a.kind == ir_operand_address) {
+    form.variable = a.value;
+    form.scale = 1;
+    form.offset = 0;
+    form.base = -1;
+    form.root = index;
+  }
+  else if (!source)
+    return;
+  else {
+    form = *source;
+    long long value = b.value;
+    switch (instruction->opcode) {
+      case ir_move:
+        break;
+      case ir_add:
+        if (b.kind == ir_operand_constant && fits(form.offset + value))
+          form.offset += b.value;
+        // O endereço zero (o início da área de dados) não muda o valor, a menos que seja do registro de ativação
+        else if (b.kind == ir_operand_address && (b.value == 0 || form.base < 0) &&
+                 !is_frame_address(strength->ir, b.value))
+          form.base = b.value == 0 ? form.base : b.value;
+        else
+          return;
+        break;
+      case ir_sub:
+        if (b.kind != ir_operand_constant || !fits(form.offset - value))
+          return;
+        form.offset -= b.value;
+        break;
+      case ir_mul:
+        if (b.kind != ir_operand_constant || form.base >= 0 || !fits(form.scale * value) || !fits(form.offset * value))
+          return;
+        form.scale *= b.value;
+        form.offset *= b.value;
+        break;
+      case ir_shl:
+        if (b.kind != ir_operand_constant || form.base >= 0 || value < 0 || value > 16 ||
+            !fits((long long)form.scale << value) || !fits((long long)form.offset << value))
+          return;
+        form.scale <<= b.value;
+        form.offset <<= b.value;
+        break;
+      default:
+        return;
+    }
+  }
+  form.loop = loop;
+  strength->forms[instruction->dst] = form;
+}
+
+// Reconhece o teste do início de um laço “while”: “CMP variável, limite” seguido de um desvio para fora do laço, sem
+// escritas antes dele. O limite é uma constante ou outra variável, cujo valor cabe em “value_t”
+guard_t find_guard(strength_t *strength, const loop_t *loop, unsigned int id)
+{
+  guard_t guard = { -1, symbol_null, false, 0, 0 };
+  const ir_instruction_t *code = strength->ir->instructions;
+  unsigned int index = loop->header;
+  for (; index <= loop->end && !is_ir_branch(code[index].opcode); index++)
+    if (code[index].opcode == ir_store)
+      return guard;
+  if (index > loop->end || index == loop->header || code[index].opcode != ir_branch ||
+      code[index - 1].opcode != ir_compare || (code[index].dst >= loop->header && code[index].dst <= loop->end))
+    return guard;
+  symbol_t relation = inverse_condition((symbol_t)code[index].condition);
+  ir_operand_t variable = code[index - 1].a, limit = code[index - 1].b;
+  affine_t *form = affine_form(strength, variable, id);
+  if (!form || !is_trivial(form)) {
+    variable = code[index - 1].b;
+    limit = code[index - 1].a;
+    relation = mirrored_relation(relation);
+    form = affine_form(strength, variable, id);
+    if (!form || !is_trivial(form))
+      return guard;
+  }
+  if (limit.kind == ir_operand_constant) {
+    guard.constant = true;
+    guard.bound = limit.value;
+  }
+  else {
+    affine_t *bound = affine_form(strength, limit, id);
+    if (!bound || !is_trivial(bound))
+      return guard;
+  }
+  guard.variable = form->variable;
+  guard.relation = relation;
+  guard.index = index;
+  return guard;
+}
+
+// O registrador reduzido cresce sem truncamento, enquanto a variável é guardada em “value_t”; por isso o incremento não
+// pode transbordar, o que a condição do laço garante quando limita a variável antes dele
+bool is_bounded_step(const guard_t *guard, int step)
+{
+  long long limit = guard->bound;
+  switch (guard->relation) {
+    case symbol_less: return step > 0 && (guard->constant ? limit - 1 + step <= MAX_VALUE : step == 1);
+    case symbol_less_equal: return step > 0 && guard->constant && limit + step <= MAX_VALUE;
+    case symbol_greater: return step < 0 && (guard->constant ? limit + 1 + step >= MIN_VALUE : step == -1);
+    case symbol_greater_equal: return step < 0 && guard->constant && limit + step >= MIN_VALUE;
+    default: return false;
+  }
+}
+
+// A única escrita de uma variável de indução é “variável := variável + constante”, fora de laços internos (ou ela
+// poderia acontecer mais de uma vez por iteração) e depois do teste do laço
+induction_t classify_variable(strength_t *strength, int variable, const guard_t *guard, const loop_t *loop,
+                              unsigned int id)
+{
+  induction_t induction = { variable, false, STRENGTH_NONE, 0 };
+  // Elementos de vetores lidos com índices constantes podem ser escritos por outras instruções do laço
+  if (strength->indirect && strength->indexed[variable])
+    return induction;
+  unsigned int count = strength->store_counts[variable];
+  if (count == 0) {
+    induction.valid = true;
+    return induction;
+  }
+  unsigned int store = strength->store_indices[variable];
+  if (count != 1 || variable != guard->variable || store < guard->index)
+    return induction;
+  for (unsigned int index = loop->header + 1; index <= store; index++)
+    if (strength->ends[index] != STRENGTH_NONE && strength->ends[index] >= store)
+      return induction;
+  affine_t *value = affine_form(strength, strength->ir->instructions[store].b, id);
+  if (!value || value->variable != variable || value->scale != 1 || value->base >= 0 || value->offset == 0 ||
+      !is_bounded_step(guard, value->offset))
+    return induction;
+  induction.valid = true;
+  induction.store = store;
+  induction.step = value->offset;
+  return induction;
+}
+
+bool insert(strength_t *strength, unsigned int position, bool preheader, ir_opcode_t opcode, unsigned int dst,
+            ir_operand_t a, ir_operand_t b)
+{
+  if (strength->insertion_count == strength->insertion_capacity) {
+    size_t capacity = strength->insertion_capacity ? strength->insertion_capacity * 2 : 64;
+    insertion_t *larger = (insertion_t *)realloc(strength->insertions, capacity * sizeof(insertion_t));
+    if (!larger)
+      return false;
+    strength->insertions = larger;
+    strength->insertion_capacity = capacity;
+  }
+  insertion_t *insertion = &strength->insertions[strength->insertion_count];
+  insertion->position = position;
+  insertion->preheader = preheader;
+  insertion->sequence = (unsigned int)strength->insertion_count++;
+  insertion->instruction.opcode = (unsigned char)opcode;
+  insertion->instruction.condition = symbol_null;
+  insertion->instruction.dst = dst;
+  insertion->instruction.a = a;
+  insertion->instruction.b = b;
+  return true;
+}
+
+// Calcula o valor reduzido antes do laço; a última instrução escreve diretamente no registrador reduzido
+bool insert_initialization(strength_t *strength, unsigned int header, const reduction_t *reduction)
+{
+  ir_opcode_t opcodes[3];
+  ir_operand_t operands[3];
+  unsigned int count = 0;
+  int exponent = 0;
+  while (exponent < 16 && (1 << exponent) < reduction->scale)
+    exponent++;
+  if (reduction->scale != 1) {
+    bool shift = (1 << exponent) == reduction->scale;
+    opcodes[count] = shift ? ir_shl : ir_mul;
+    operands[count++] = ir_operand(ir_operand_constant, shift ? exponent : reduction->scale);
+  }
+  // O deslocamento é somado ao endereço quando o resultado ainda é um endereço válido (e global, já que os endereços do
+  // registro de ativação são relativos a ele)
+  int offset = reduction->offset;
+  if (reduction->base >= 0) {
+    bool merged = reduction->base + offset >= 0 && reduction->base + offset <= MAX_ADDRESS &&
+      !is_frame_address(strength->ir, reduction->base) && !is_frame_address(strength->ir, reduction->base + offset);
+    opcodes[count] = ir_add;
+    operands[count++] = ir_operand(ir_operand_address, merged ? reduction->base + offset : reduction->base);
+    offset = merged ? 0 : offset;
+  }
+  if (offset != 0) {
+    opcodes[count] = ir_add;
+    operands[count++] = ir_operand(ir_operand_constant, offset);
+  }
+  unsigned int value = create_register(strength->ir);
+  if (!insert(strength, header, true, ir_load, value, ir_operand(ir_operand_address, reduction->variable),
+              ir_operand(ir_operand_none, 0)))
+    return false;
+  for (unsigned int step = 0; step < count; step++) {
+    unsigned int dst = step + 1 == count ? reduction->reg : create_register(strength->ir);
+    if (!insert(strength, header, true, opcodes[step], dst, ir_operand(ir_operand_register, (int)value),
+                operands[step]))
+      return false;
+    value = dst;
+  }
+  return true;
+}
+
+// Substitui os usos finais das formas afins (os que não estendem a forma, como o endereço de “LOAD” e “STORE”) pelos
+// registradores reduzidos
+bool reduce_loop(strength_t *strength, const loop_t *loop, unsigned int id)
+{
+  ir_instruction_t *code = strength->ir->instructions;
+  // Um procedimento chamado no laço pode escrever nas variáveis de indução
+  for (unsigned int index = loop->header; index <= loop->end; index++)
+    if (code[index].opcode == ir_call)
+      return true;
+  strength->indirect = false;
+  for (unsigned int index = loop->header; index <= loop->end; index++) {
+    compute_form(strength, index, id);
+    if (code[index].opcode == ir_store && code[index].a.kind == ir_operand_address) {
+      strength->store_counts[code[index].a.value]++;
+      strength->store_indices[code[index].a.value] = index;
+    }
+    else if (code[index].opcode == ir_store)
+      strength->indirect = true;
+  }
+  guard_t guard = find_guard(strength, loop, id);
+  induction_t inductions[STRENGTH_MAX_VARIABLES];
+  reduction_t reductions[STRENGTH_MAX_REDUCTIONS];
+  unsigned int induction_count = 0, reduction_count = 0;
+  for (unsigned int index = loop->header; index <= loop->end; index++) {
+    ir_instruction_t *instruction = &code[index];
+    if (is_ir_branch(instruction->opcode) || has_form(strength, instruction->dst, id))
+      continue;
+    ir_operand_t *operands[2] = { &instruction->a, &instruction->b };
+    for (unsigned int position = 0; position < 2; position++) {
+      affine_t *form = affine_form(strength, *operands[position], id);
+      // O valor escrito na própria variável (o incremento) não é reduzido
+      if (!form || is_trivial(form) || strength->leaders[index] != strength->leaders[form->root] ||
+          (instruction->opcode == ir_store && position == 1 && instruction->a.kind == ir_operand_address &&
+           instruction->a.value == form->variable))
+        continue;
+      unsigned int variable = 0;
+      while (variable < induction_count && inductions[variable].variable != form->variable)
+        variable++;
+      if (variable == induction_count) {
+        if (induction_count == STRENGTH_MAX_VARIABLES)
+          continue;
+        inductions[induction_count++] = classify_variable(strength, form->variable, &guard, loop, id);
+      }
+      induction_t *induction = &inductions[variable];
+      // Entre a leitura da variável e o uso, o incremento já teria mudado o registrador reduzido
+      if (!induction->valid || (induction->store != STRENGTH_NONE && form->root < induction->store &&
+                                induction->store < index))
+        continue;
+      unsigned int reduction = 0;
+      while (reduction < reduction_count &&
+             (reductions[reduction].variable != form->variable || reductions[reduction].scale != form->scale ||
+              reductions[reduction].offset != form->offset || reductions[reduction].base != form->base))
+        reduction++;
+      if (reduction == reduction_count) {
+        if (reduction_count == STRENGTH_MAX_REDUCTIONS)
+          continue;
+        reductions[reduction_count].variable = form->variable;
+        reductions[reduction_count].scale = form->scale;
+        reductions[reduction_count].offset = form->offset;
+        reductions[reduction_count].base = form->base;
+        reductions[reduction_count++].reg = create_register(strength->ir);
+      }
+      strength->orphans[strength->orphan_count++] = (unsigned int)operands[position]->value;
+      operands[position]->value = (int)reductions[reduction].reg;
+    }
+  }
+  bool valid = true;
+  for (unsigned int reduction = 0; reduction < reduction_count && valid; reduction++) {
+    valid = insert_initialization(strength, loop->header, &reductions[reduction]);
+    for (unsigned int variable = 0; variable < induction_count && valid; variable++)
+      if (inductions[variable].variable == reductions[reduction].variable &&
+          inductions[variable].store != STRENGTH_NONE)
+        valid = insert(strength, inductions[variable].store + 1, false, ir_add, reductions[reduction].reg,
+                       ir_operand(ir_operand_register, (int)reductions[reduction].reg),
+                       ir_operand(ir_operand_constant, inductions[variable].step * reductions[reduction].scale));
+  }
+  for (unsigned int index = loop->header; index <= loop->end; index++)
+    if (code[index].opcode == ir_store && code[index].a.kind == ir_operand_address)
+      strength->store_counts[code[index].a.value] = 0;
+  return valid;
+}
+
+// Remove as instruções que só calculavam os valores substituídos (a leitura da variável, a multiplicação e a soma)
+void release_value(strength_t *strength, unsigned int *uses, unsigned int *definitions, unsigned int value)
+{
+  if (value >= strength->form_count || uses[value] > 0 || definitions[value] == STRENGTH_NONE)
+    return;
+  ir_instruction_t *instruction = &strength->ir->instructions[definitions[value]];
+  definitions[value] = STRENGTH_NONE;
+  if (instruction->opcode != ir_load && instruction->opcode != ir_move && instruction->opcode != ir_add &&
+      instruction->opcode != ir_sub && instruction->opcode != ir_mul && instruction->opcode != ir_shl)
+    return;
+  instruction->opcode = ir_nop;
+  ir_operand_t operands[2] = { instruction->a, instruction->b };
+  for (unsigned int position = 0; position < 2; position++)
+    if (operands[position].kind == ir_operand_register && (unsigned int)operands[position].value < strength->form_count) {
+      uses[operands[position].value]--;
+      release_value(strength, uses, definitions, (unsigned int)operands[position].value);
+    }
+}
+
+bool remove_orphans(strength_t *strength)
+{
+  unsigned int *uses = (unsigned int *)calloc((size_t)strength->form_count + 1, sizeof(unsigned int));
+  unsigned int *definitions = (unsigned int *)malloc(((size_t)strength->form_count + 1) * sizeof(unsigned int));
+  if (!uses || !definitions) {
+    free(uses);
+    free(definitions);
+    return false;
+  }
+  for (unsigned int index = 0; index < strength->form_count; index++)
+    definitions[index] = STRENGTH_NONE;
+  const ir_instruction_t *code = strength->ir->instructions;
+  for (unsigned int index = 0; index < strength->length; index++) {
+    if (code[index].a.kind == ir_operand_register && (unsigned int)code[index].a.value < strength->form_count)
+      uses[code[index].a.value]++;
+    if (code[index].b.kind == ir_operand_register && (unsigned int)code[index].b.value < strength->form_count)
+      uses[code[index].b.value]++;
+    if (!is_ir_branch(code[index].opcode) && code[index].dst < strength->form_count)
+      definitions[code[index].dst] = index;
+  }
+  for (size_t orphan = 0; orphan < strength->orphan_count; orphan++)
+    release_value(strength, uses, definitions, strength->orphans[orphan]);
+  free(uses);
+  free(definitions);
+  return true;
+}
+
+int compare_insertions(const void *first, const void *second)
+{
+  const insertion_t *a = (const insertion_t *)first, *b = (const insertion_t *)second;
+  if (a->position != b->position)
+    return a->position < b->position ? -1 : 1;
+  if (a->preheader != b->preheader)
+    return a->preheader ? 1 : -1;
+  return a->sequence < b->sequence ? -1 : (a->sequence > b->sequence);
+}
+
+int compare_loops(const void *first, const void *second)
+{
+  const loop_t *a = (const loop_t *)first, *b = (const loop_t *)second;
+  unsigned int size_a = a->end - a->header, size_b = b->end - b->header;
+  return size_a < size_b ? -1 : (size_a > size_b);
+}
+
+// Monta o novo vetor com as instruções inseridas e sem as removidas. Desvios de fora de um laço para o seu início
+// passam a apontar para as iniciações; os desvios para trás continuam apontando para o teste
+bool rebuild(strength_t *strength)
+{
+  ir_t *ir = strength->ir;
+  unsigned int length = strength->length;
+  size_t capacity = (size_t)length + strength->insertion_count + 1;
+  ir_instruction_t *code = (ir_instruction_t *)malloc(capacity * sizeof(ir_instruction_t));
+  unsigned int *entries = (unsigned int *)malloc(((size_t)length + 1) * sizeof(unsigned int));
+  unsigned int *positions = (unsigned int *)malloc(((size_t)length + 1) * sizeof(unsigned int));
+  if (!code || !entries || !positions) {
+    free(code);
+    free(entries);
+    free(positions);
+    return false;
+  }
+  qsort(strength->insertions, strength->insertion_count, sizeof(insertion_t), compare_insertions);
+  unsigned int count = 0;
+  size_t next = 0;
+  for (unsigned int index = 0; index <= length; index++) {
+    for (; next < strength->insertion_count && strength->insertions[next].position == index &&
+         !strength->insertions[next].preheader; next++)
+      code[count++] = strength->insertions[next].instruction;
+    entries[index] = count;
+    for (; next < strength->insertion_count && strength->insertions[next].position == index; next++)
+      code[count++] = strength->insertions[next].instruction;
+    positions[index] = count;
+    if (index < length && ir->instructions[index].opcode != ir_nop)
+      code[count++] = ir->instructions[index];
+  }
+  for (unsigned int index = 0; index < length; index++) {
+    ir_instruction_t *instruction = &ir->instructions[index];
+    if (instruction->opcode == ir_nop || !is_ir_branch(instruction->opcode) || instruction->dst > length)
+      continue;
+    unsigned int target = instruction->dst;
+    bool backward = target <= index && strength->ends[target] != STRENGTH_NONE && index <= strength->ends[target];
+    code[positions[index]].dst = backward ? positions[target] : entries[target];
+  }
+  free(ir->instructions);
+  ir->instructions = code;
+  ir->length = count;
+  ir->capacity = (unsigned int)capacity;
+  free(entries);
+  free(positions);
+  return true;
+}
+
+bool reduce_strength(ir_t *ir)
+{
+  strength_t strength;
+  memset(&strength, 0, sizeof(strength));
+  strength.ir = ir;
+  strength.length = ir->length;
+  strength.form_count = ir->register_count;
+  unsigned int length = ir->length;
+  strength.ends = (unsigned int *)malloc(((size_t)length + 1) * sizeof(unsigned int));
+  strength.leaders = (unsigned int *)malloc(((size_t)length + 1) * sizeof(unsigned int));
+  loop_t *loops = (loop_t *)malloc(((size_t)length + 1) * sizeof(loop_t));
+  if (!strength.ends || !strength.leaders || !loops) {
+    free(strength.ends);
+    free(strength.leaders);
+    free(loops);
+    return false;
+  }
+  // Os laços são identificados pelos desvios para trás; o início de um laço pode receber mais de um deles
+  for (unsigned int index = 0; index <= length; index++)
+    strength.ends[index] = STRENGTH_NONE;
+  for (unsigned int index = 0; index < length; index++) {
+    unsigned int target = ir->instructions[index].dst;
+    if (!is_ir_branch(ir->instructions[index].opcode) || target > length)
+      continue;
+    if (target <= index && (strength.ends[target] == STRENGTH_NONE || strength.ends[target] < index))
+      strength.ends[target] = index;
+  }
+  unsigned int loop_count = 0;
+  for (unsigned int index = 0; index < length; index++)
+    if (strength.ends[index] != STRENGTH_NONE) {
+      loops[loop_count].header = index;
+      loops[loop_count++].end = strength.ends[index];
+    }
+  bool valid = true;
+  if (loop_count > 0) {
+    unsigned int leaders = 0;
+    bool *is_target = (bool *)calloc((size_t)length + 1, sizeof(bool));
+    strength.forms = (affine_t *)calloc((size_t)strength.form_count + 1, sizeof(affine_t));
+    strength.store_counts = (unsigned int *)calloc((size_t)MAX_ADDRESS + 1, sizeof(unsigned int));
+    strength.store_indices = (unsigned int *)calloc((size_t)MAX_ADDRESS + 1, sizeof(unsigned int));
+    strength.orphans = (unsigned int *)malloc(((size_t)length * 2 + 1) * sizeof(unsigned int));
+    strength.indexed = create_indexed_map(ir, MAX_ADDRESS + 1);
+    valid = is_target && strength.forms && strength.store_counts && strength.store_indices && strength.orphans &&
+      strength.indexed;
+    if (valid) {
+      for (unsigned int index = 0; index < length; index++)
+        if (is_ir_branch(ir->instructions[index].opcode) && ir->instructions[index].dst <= length)
+          is_target[ir->instructions[index].dst] = true;
+      for (unsigned int index = 0; index <= length; index++) {
+        if (index == 0 || is_target[index] || is_ir_branch(ir->instructions[index - 1].opcode))
+          leaders++;
+        strength.leaders[index] = leaders;
+      }
+      // Os laços internos são tratados primeiro: o que eles reduzem já não aparece para os laços externos
+      qsort(loops, loop_count, sizeof(loop_t), compare_loops);
+      for (unsigned int loop = 0; loop < loop_count && valid; loop++)
+        valid = reduce_loop(&strength, &loops[loop], loop + 1);
+      if (valid && strength.insertion_count > 0)
+        valid = remove_orphans(&strength) && rebuild(&strength);
+    }
+    free(is_target);
+  }
+  free(strength.forms);
+  free(strength.store_counts);
+  free(strength.store_indices);
+  free(strength.orphans);
+  free(strength.indexed);
+  free(strength.insertions);
+  free(strength.ends);
+  free(strength.leaders);
+  free(loops);
+  return valid;
+}
@@ -0,0 +1,22 @@
+//
+//  strength.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_strength_h
+#define Oberon_strength_h
+
+#include <stdbool.h>
+
+#include "ir.h"
+
+// Redução de força nos laços (“while” e “repeat”), sobre a representação intermediária ainda sem blocos, quando os
+// destinos dos desvios são índices de instruções. Os valores da forma “variável * escala + deslocamento” (como os
+// endereços de “a[k]”) passam a ser mantidos em um registrador, iniciado antes do laço e incrementado junto com a
+// variável, no lugar da leitura, da multiplicação e da soma repetidas a cada iteração
+bool reduce_strength(ir_t *ir);
+
+#endif
@@ -10,51 +10,65 @@
 #include <stdbool.h>
 #include <string.h>
 
+#include "arena.h"
 #include "backend.h"
 #include "errors.h"
 #include "scanner.h"
 #include "symbol_table.h"
 
-entry_t *symbol_table;
-address_t current_address;
-entry_t *integer_type;
-entry_t *boolean_type;
+#define SYMBOL_TABLE_INITIAL_CAPACITY 16
 
-entry_t *create_elementary_type(identifier_t id)
+__thread scope_t *symbol_table = NULL;
+__thread address_t current_address;
+__thread unsigned int current_level = 0;
+__thread entry_t *integer_type;
+__thread entry_t *boolean_type;
+
+// Como os identificadores são átomos, basta espalhar os bits do próprio número (método multiplicativo de Fibonacci)
+static inline unsigned int hash_atom(atom_t id)
+{
+  unsigned int hash = id * 2654435769u;
+  return hash ^ (hash >> 16);
+}
+
+entry_t *create_elementary_type(const char *id)
 {
-  entry_t *entry = create_entry(id, position_zero, class_type);
+  entry_t *entry = create_entry(intern_id(id), position_zero, class_type);
   if (!entry) {
     mark_not_enough_memory();
     return NULL;
   }
-  type_t *type = create_type(form_atomic, 0, sizeof(value_t), NULL, NULL);
+  type_t *type = create_type(form_atomic, 0, 1, NULL, NULL);
   if (!type) {
     mark_not_enough_memory();
-    free(entry);
     return NULL;
   }
   entry->type = type;
 	return entry;
 }
 
-bool initialize_table(address_t base_address, entry_t **ref)
+bool initialize_table(address_t base_address)
 {
   current_address = base_address;
-  clear_table(ref);
-  // Os tipos elementares (“integer” e “boolean”) são as primeiras entradas da tabela de símbolos
+  current_level = 0;
+  clear_table();
+  open_scope();
+  if (!symbol_table)
+    return false;
+  // Os tipos elementares (“integer” e “boolean”) são as primeiras entradas do escopo mais externo
   // Todos os tipos elementares da linguagem devem ser criados e adicionados à tabela nesta função
 	integer_type = create_elementary_type("INTEGER");
   boolean_type = create_elementary_type("BOOLEAN");
 	if (!integer_type || !boolean_type)
 		return false;
-  add_entry(integer_type, ref);
-  add_entry(boolean_type, ref);
+  add_entry(integer_type, symbol_table);
+  add_entry(boolean_type, symbol_table);
   return true;
 }
 
-type_t *create_type(form_t form, value_t length, unsigned int size, entry_t *fields, type_t *base)
+type_t *create_type(form_t form, value_t length, unsigned int size, scope_t *fields, type_t *base)
 {
-  type_t *type = (type_t *)malloc(sizeof(type_t));
+  type_t *type = (type_t *)arena_allocate(&compilation_arena, sizeof(type_t));
   if (!type) {
     mark_not_enough_memory();
     return NULL;
@@ -62,14 +76,16 @@ type_t *create_type(form_t form, value_t length, unsigned int size, entry_t *fie
   type->form = form;
   type->length = length;
   type->size = size;
+  type->alignment = 1;
+  type->columns = false;
   type->fields = fields;
   type->base = base;
   return type;
 }
 
-link_t *create_link(fpos_t position)
+link_t *create_link(unsigned int position)
 {
-  link_t *link = (link_t *)malloc(sizeof(link_t));
+  link_t *link = (link_t *)arena_allocate(&compilation_arena, sizeof(link_t));
   if (!link) {
     mark_not_enough_memory();
     return NULL;
@@ -79,67 +95,121 @@ link_t *create_link(fpos_t position)
   return link;
 }
 
-entry_t *create_entry(identifier_t id, position_t position, class_t class)
+entry_t *create_entry(atom_t id, position_t position, class_t class)
 {
-  entry_t *new_entry = (entry_t *)malloc(sizeof(entry_t));
+  entry_t *new_entry = (entry_t *)arena_allocate(&compilation_arena, sizeof(entry_t));
   if (!new_entry) {
     mark_not_enough_memory();
     return NULL;
   }
-  strcpy(new_entry->id, id);
+  new_entry->id = id;
   new_entry->position = position;
   new_entry->address = 0;
   new_entry->class = class;
   new_entry->type = NULL;
   new_entry->value = 0;
   new_entry->next = NULL;
+  new_entry->level = current_level;
+  new_entry->reference = false;
+  new_entry->index = 0;
+  new_entry->parameters = NULL;
+  new_entry->parameter_count = 0;
   return new_entry;
 }
 
-void clear_links(link_t **ref)
+scope_t *create_scope(scope_t *parent)
 {
-  link_t *links = *ref;
-  while (links) {
-    link_t *current = links;
-    links = current->next;
-    free(current);
+  scope_t *scope = (scope_t *)arena_allocate(&compilation_arena, sizeof(scope_t));
+  if (!scope) {
+    mark_not_enough_memory();
+    return NULL;
   }
-  *ref = NULL;
+  scope->slots = (entry_t **)arena_allocate(&compilation_arena, SYMBOL_TABLE_INITIAL_CAPACITY * sizeof(entry_t *));
+  if (!scope->slots) {
+    mark_not_enough_memory();
+    return NULL;
+  }
+  memset(scope->slots, 0, SYMBOL_TABLE_INITIAL_CAPACITY * sizeof(entry_t *));
+  scope->capacity = SYMBOL_TABLE_INITIAL_CAPACITY;
+  scope->count = 0;
+  scope->first = NULL;
+  scope->last = NULL;
+  scope->parent = parent;
+  return scope;
 }
 
-void clear_table(entry_t **ref)
+// Toda a memória da tabela de símbolos pertence a “compilation_arena” e é liberada de uma só vez ao final de “parse”,
+// por isso tipos compartilhados entre várias entradas (ou entre escopos) não exigem cuidado algum
+void clear_table()
 {
-  // TODO: Verificar quais tipos de entradas na tabela devem ser removidos primeiro
-  // Pode haver um problema ao liberar a memória para um “type” e este ainda ter referências para si
-  // em outras entradas. Contagem de referências seria uma solução…
-  entry_t *table = *ref;
-  while (table) {
-    entry_t *current = table;
-    table = current->next;
-    if (current->type && current->type->fields)
-      clear_table(&current->type->fields);
-    free(current);
-  }
-  *ref = NULL;
+  symbol_table = NULL;
+}
+
+void open_scope()
+{
+  scope_t *scope = create_scope(symbol_table);
+  if (scope)
+    symbol_table = scope;
 }
 
-void log_table(entry_t *table)
+// As entradas do escopo continuam válidas após o seu fechamento: procedimentos podem manter referências para os seus
+// parâmetros e tipos locais podem ser compartilhados
+void close_scope()
 {
+  if (symbol_table)
+    symbol_table = symbol_table->parent;
+}
+
+void log_table(scope_t *scope)
+{
+  entry_t *table = scope ? scope->first : NULL;
   while (table) {
-    mark_at(error_log, position_zero, "Entry \"%s\" found.", table->id);
+    mark_at(error_log, position_zero, "Entry \"%s\" found.", id_for_atom(table->id));
     table = table->next;
   }
 }
 
-entry_t *find_entry(identifier_t id, entry_t *table)
+// Retorna a posição da entrada com o identificador dado ou a posição vazia onde ela deveria ser inserida
+entry_t **probe_scope(scope_t *scope, atom_t id)
 {
-  entry_t *current = table;
-  while (current) {
-    if (strcmp(current->id, id) == 0)
-      break;
-    current = current->next;
+  unsigned int mask = scope->capacity - 1;
+  unsigned int index = hash_atom(id) & mask;
+  while (scope->slots[index] && scope->slots[index]->id != id)
+    index = (index + 1) & mask;
+  return &scope->slots[index];
+}
+
+// Dobra a capacidade da tabela de espalhamento, reinserindo as entradas existentes
+bool grow_scope(scope_t *scope)
+{
+  unsigned int capacity = scope->capacity * 2;
+  // A tabela antiga continua na arena até o fim da compilação; o desperdício é limitado pelo crescimento geométrico
+  entry_t **slots = (entry_t **)arena_allocate(&compilation_arena, capacity * sizeof(entry_t *));
+  if (!slots) {
+    mark_not_enough_memory();
+    return false;
+  }
+  memset(slots, 0, capacity * sizeof(entry_t *));
+  entry_t **old_slots = scope->slots;
+  unsigned int old_capacity = scope->capacity;
+  scope->slots = slots;
+  scope->capacity = capacity;
+  for (unsigned int index = 0; index < old_capacity; index++)
+    if (old_slots[index])
+      *probe_scope(scope, old_slots[index]->id) = old_slots[index];
+  return true;
+}
+
+// A busca começa em “scope” e continua pelos escopos externos até que o identificador seja encontrado
+entry_t *find_entry(atom_t id, scope_t *scope)
+{
+  while (scope) {
+    entry_t *entry = *probe_scope(scope, id);
+    if (entry)
+      return entry;
+    scope = scope->parent;
   }
-  return current;
+  return NULL;
 }
 
 bool add_link(link_t *link, link_t **ref)
@@ -153,23 +223,31 @@ bool add_link(link_t *link, link_t **ref)
   return true;
 }
 
-bool add_entry(entry_t *entry, entry_t **ref)
+// A entrada pode ser o início de uma lista (como as criadas por “id_list”) e, neste caso, todas as entradas da lista são
+// adicionadas ao escopo. Identificadores repetidos são apontados como erro e não substituem a primeira declaração
+bool add_entry(entry_t *entry, scope_t *scope)
 {
-  if (!ref || !entry)
+  if (!scope || !entry)
     return false;
-  entry_t *table = *ref;
   entry_t *e = entry;
   while (e) {
-    if (find_entry(e->id, table))
-      mark_at(error_parser, e->position, "The identifier \"%s\" has already been declared.", e->id);
+    if ((scope->count + 1) * 4 > scope->capacity * 3 && !grow_scope(scope))
+      return false;
+    entry_t **slot = probe_scope(scope, e->id);
+    if (*slot)
+      mark_at(error_parser, e->position, "The identifier \"%s\" has already been declared.", id_for_atom(e->id));
+    else {
+      *slot = e;
+      scope->count++;
+    }
+    if (!e->next)
+      break;
     e = e->next;
   }
-  if (!table)
-    *ref = entry;
-  else {
-    while (table->next)
-      table = table->next;
-    table->next = entry;
-  }
+  if (scope->last)
+    scope->last->next = entry;
+  else
+    scope->first = entry;
+  scope->last = e;
   return true;
 }
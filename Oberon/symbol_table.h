@@ -14,8 +14,6 @@
 #include "backend.h"
 #include "scanner.h"
 
-#define SYMBOL_TABLE_MAX_LABEL_LENGTH 16
-
 typedef enum _class {
   class_unknown,
   class_var,
@@ -31,25 +29,44 @@ typedef enum _form {
 } form_t;
 
 struct _entry;
+struct _scope;
 
 typedef struct _type {
   form_t form;
   value_t length;
   unsigned int size;
-  struct _entry *fields;
+  unsigned int alignment; // Em posições de memória (ver “layout.h”)
+  bool columns;           // Vetor de registros disposto como estrutura de vetores
+  struct _scope *fields;
   struct _type *base;
 } type_t;
 
 typedef struct _entry {
-  identifier_t id;
+  atom_t id;
   position_t position;
   address_t address;
   class_t class;
   value_t value;
   struct _type *type;
   struct _entry *next;
+  unsigned int level;            // Nível de aninhamento da declaração (zero no escopo do módulo)
+  bool reference;                // Parâmetro passado por referência (“var”)
+  unsigned int index;            // Número do procedimento ou registrador com o endereço do parâmetro por referência
+  struct _entry *parameters;     // Parâmetros do procedimento: as primeiras entradas do seu escopo
+  unsigned int parameter_count;
 } entry_t;
 
+// Cada escopo possui sua própria tabela de espalhamento com endereçamento aberto (sondagem linear) e mantém também a
+// lista de suas entradas na ordem de declaração, usada para calcular endereços e deslocamentos. Os escopos formam uma
+// pilha através de “parent”: a busca por um identificador começa no escopo mais interno e segue para os externos
+typedef struct _scope {
+  struct _entry **slots;
+  unsigned int capacity;
+  unsigned int count;
+  struct _entry *first, *last;
+  struct _scope *parent;
+} scope_t;
+
 typedef enum _addressing {
   addressing_unknown,
   addressing_direct,
@@ -59,8 +76,9 @@ typedef enum _addressing {
   addressing_condition
 } addressing_t;
 
+// Cada ligação aponta para uma instrução de desvio cujo destino ainda não é conhecido
 typedef struct _link {
-  fpos_t position;
+  unsigned int position;
   struct _link *next;
 } link_t;
 
@@ -69,30 +87,33 @@ typedef struct _item {
   struct _type *type;
   address_t address;   // Para variáveis na memória
   value_t value;       // Para constantes
-  unsigned char index; // Para registradores
+  unsigned int index; // Para registradores (virtuais)
+  value_t columns;     // Comprimento da estrutura de vetores do elemento selecionado (zero nos demais itens)
   symbol_t condition;  // Para condicionais
-  char label[SYMBOL_TABLE_MAX_LABEL_LENGTH + 1];
+  int label;           // Índice da instrução marcada pelo rótulo
   link_t *links;
-  link_t *true_links, *false_links;
+  link_t *true_links, *false_links;  // Desvios de “&” e “OR” que já decidem a condição, ainda sem destino
 } item_t;
 
-// TODO: Criar uma estrutura de dados real e organizar toda essa bagunça!
-
-extern entry_t *symbol_table;
-extern address_t current_address;
-extern entry_t *integer_type;
-extern entry_t *boolean_type;
-
-type_t *create_type(form_t form, value_t length, unsigned int size, entry_t *fields, type_t *base);
-link_t *create_link(fpos_t position);
-entry_t *create_entry(identifier_t id, position_t position, class_t class);
-
-bool initialize_table(address_t base_address, entry_t **ref);
-void clear_table(entry_t **ref);
-void clear_links(link_t **ref);
-void log_table(entry_t *table);
-entry_t *find_entry(identifier_t id, entry_t *table);
-bool add_entry(entry_t *entry, entry_t **ref);
+// “symbol_table” aponta sempre para o escopo corrente (o topo da pilha de escopos)
+extern __thread scope_t *symbol_table;
+extern __thread address_t current_address;
+extern __thread unsigned int current_level;
+extern __thread entry_t *integer_type;
+extern __thread entry_t *boolean_type;
+
+type_t *create_type(form_t form, value_t length, unsigned int size, scope_t *fields, type_t *base);
+link_t *create_link(unsigned int position);
+entry_t *create_entry(atom_t id, position_t position, class_t class);
+scope_t *create_scope(scope_t *parent);
+
+bool initialize_table(address_t base_address);
+void clear_table();
+void open_scope();
+void close_scope();
+void log_table(scope_t *scope);
+entry_t *find_entry(atom_t id, scope_t *scope);
+bool add_entry(entry_t *entry, scope_t *scope);
 bool add_link(link_t *link, link_t **ref);
 
 #endif
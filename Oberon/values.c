@@ -0,0 +1,187 @@
+//
+//  values.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "values.h"
+#include "backend.h"
+
+// Tabela de dispersão com endereçamento aberto; blocos muito longos param de acrescentar valores na metade dela
+#define VALUES_TABLE_SIZE 4096
+#define VALUES_TABLE_LIMIT (VALUES_TABLE_SIZE / 2)
+
+// “block” marca o bloco em que a entrada foi criada, o que dispensa limpar a tabela a cada bloco. Nas leituras que
+// escritas indiretas podem alcançar, “epoch” precisa ser a época atual; “reg” é IR_NO_REGISTER nas entradas anuladas
+typedef struct _number {
+  unsigned int block, epoch;
+  unsigned char opcode;
+  ir_operand_t a, b;
+  unsigned int reg;
+} number_t;
+
+typedef struct _values {
+  number_t *table;
+  unsigned int block, count, epoch;
+  unsigned int *rename; // Registrador que substitui cada registrador removido
+  bool *narrow;         // Registradores lidos da memória, cujo valor cabe em “value_t”
+  bool *indexed;        // Endereços que as escritas indiretas podem alcançar
+} values_t;
+
+static inline bool same_operand(ir_operand_t first, ir_operand_t second)
+{
+  return first.kind == second.kind && first.value == second.value;
+}
+
+static inline bool is_numbered(unsigned char opcode)
+{
+  return opcode == ir_move || opcode == ir_load || (opcode >= ir_add && opcode <= ir_not);
+}
+
+static inline bool is_commutative(unsigned char opcode)
+{
+  return opcode == ir_add || opcode == ir_mul || opcode == ir_and || opcode == ir_or;
+}
+
+// Leituras indiretas e de elementos de vetores podem ser alteradas por escritas indiretas
+static inline bool is_aliased(const values_t *values, unsigned char opcode, ir_operand_t a)
+{
+  return opcode == ir_load && (a.kind != ir_operand_address || values->indexed[a.value]);
+}
+
+static inline ir_operand_t renamed(const values_t *values, ir_operand_t operand)
+{
+  if (operand.kind == ir_operand_register)
+    operand.value = (int)values->rename[operand.value];
+  return operand;
+}
+
+// Posição da entrada com a mesma operação no bloco atual ou, se não houver, da posição livre onde ela entraria
+unsigned int find_value(const values_t *values, unsigned char opcode, ir_operand_t a, ir_operand_t b)
+{
+  unsigned int hash = opcode * 31u + (unsigned int)a.kind * 7u + (unsigned int)b.kind;
+  hash = hash * 2654435761u + (unsigned int)a.value;
+  hash = hash * 2654435761u + (unsigned int)b.value;
+  unsigned int slot = (hash ^ (hash >> 15)) & (VALUES_TABLE_SIZE - 1);
+  while (values->table[slot].block == values->block) {
+    const number_t *entry = &values->table[slot];
+    if (entry->opcode == opcode && same_operand(entry->a, a) && same_operand(entry->b, b))
+      break;
+    slot = (slot + 1) & (VALUES_TABLE_SIZE - 1);
+  }
+  return slot;
+}
+
+void record_value(values_t *values, unsigned int slot, unsigned char opcode, ir_operand_t a, ir_operand_t b,
+                  unsigned int reg)
+{
+  number_t *entry = &values->table[slot];
+  if (entry->block != values->block) {
+    if (values->count == VALUES_TABLE_LIMIT)
+      return;
+    values->count++;
+  }
+  entry->block = values->block;
+  entry->epoch = values->epoch;
+  entry->opcode = opcode;
+  entry->a = a;
+  entry->b = b;
+  entry->reg = reg;
+}
+
+// Depois de “STORE a, b”, a leitura de “a” devolve “b” se ele couber em “value_t” (sempre, quando os registradores
+// não são mais largos que a memória); do contrário, a leitura é anulada
+void record_store(values_t *values, ir_operand_t a, ir_operand_t b)
+{
+  if (a.kind != ir_operand_address || values->indexed[a.value])
+    values->epoch++;
+  ir_operand_t none = ir_operand(ir_operand_none, 0);
+  unsigned int slot = find_value(values, ir_load, a, none);
+  bool narrow = b.kind == ir_operand_register && (!NARROW_VALUES || values->narrow[b.value]);
+  if (narrow)
+    record_value(values, slot, ir_load, a, none, (unsigned int)b.value);
+  else if (values->table[slot].block == values->block)
+    values->table[slot].reg = IR_NO_REGISTER;
+}
+
+bool number_values(ir_t *ir)
+{
+  values_t values;
+  unsigned int length = ir->length;
+  values.table = (number_t *)calloc(VALUES_TABLE_SIZE, sizeof(number_t));
+  values.rename = (unsigned int *)malloc(((size_t)ir->register_count + 1) * sizeof(unsigned int));
+  values.narrow = (bool *)calloc((size_t)ir->register_count + 1, sizeof(bool));
+  values.indexed = create_indexed_map(ir, MAX_ADDRESS + 1);
+  bool *targets = (bool *)calloc((size_t)length + 1, sizeof(bool));
+  bool valid = values.table && values.rename && values.narrow && values.indexed && targets;
+  if (valid) {
+    for (unsigned int reg = 0; reg < ir->register_count; reg++)
+      values.rename[reg] = reg;
+    for (unsigned int index = 0; index < length; index++)
+      if (is_ir_branch(ir->instructions[index].opcode) && ir->instructions[index].dst <= length)
+        targets[ir->instructions[index].dst] = true;
+    values.block = 1;
+    values.count = 0;
+    values.epoch = 0;
+    bool removed = false;
+    for (unsigned int index = 0; index < length; index++) {
+      ir_instruction_t *instruction = &ir->instructions[index];
+      // Um destino de desvio começa um novo bloco; a tabela do bloco anterior deixa de valer
+      if (targets[index] && values.count > 0) {
+        values.block++;
+        values.count = 0;
+      }
+      instruction->a = renamed(&values, instruction->a);
+      instruction->b = renamed(&values, instruction->b);
+      unsigned char opcode = instruction->opcode;
+      if (is_ir_branch(opcode)) {
+        values.block++;
+        values.count = 0;
+        continue;
+      }
+      if (opcode == ir_store) {
+        record_store(&values, instruction->a, instruction->b);
+        continue;
+      }
+      // Um procedimento chamado pode escrever em qualquer variável
+      if (opcode == ir_call) {
+        values.block++;
+        values.count = 0;
+        continue;
+      }
+      if (!is_numbered(opcode) || instruction->dst >= ir->register_count)
+        continue;
+      ir_operand_t a = instruction->a, b = instruction->b;
+      // Operandos de operações comutativas ficam em uma ordem fixa, para que “x + y” e “y + x” coincidam
+      if (is_commutative(opcode) && (a.kind > b.kind || (a.kind == b.kind && a.value > b.value))) {
+        a = instruction->b;
+        b = instruction->a;
+      }
+      unsigned int slot = find_value(&values, opcode, a, b);
+      const number_t *entry = &values.table[slot];
+      if (entry->block == values.block && entry->reg != IR_NO_REGISTER &&
+          (!is_aliased(&values, opcode, a) || entry->epoch == values.epoch)) {
+        values.rename[instruction->dst] = entry->reg;
+        instruction->opcode = ir_nop;
+        removed = true;
+        continue;
+      }
+      values.narrow[instruction->dst] = opcode == ir_load;
+      record_value(&values, slot, opcode, a, b, instruction->dst);
+    }
+    if (removed)
+      valid = remove_nops(ir);
+  }
+  free(values.table);
+  free(values.rename);
+  free(values.narrow);
+  free(values.indexed);
+  free(targets);
+  return valid;
+}
@@ -0,0 +1,22 @@
+//
+//  values.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_values_h
+#define Oberon_values_h
+
+#include <stdbool.h>
+
+#include "ir.h"
+
+// Numeração de valores local (por bloco básico) sobre a representação intermediária ainda sem blocos. Os seletores
+// (“arquivo.d[i].x”, “m[i][j][k]”) recalculam o mesmo endereço a cada uso; uma instrução que repete outra do mesmo
+// bloco, com os mesmos operandos, é removida e os seus usos passam para o registrador já calculado. As leituras valem
+// até uma escrita que possa alcançar a mesma posição; uma leitura logo após a escrita usa o valor escrito
+bool number_values(ir_t *ir);
+
+#endif
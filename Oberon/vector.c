@@ -0,0 +1,723 @@
+//
+//  vector.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "native.h"
+#include "vector.h"
+
+#if VALUE_BITS == 32
+
+// O corpo do laço é executado simbolicamente uma vez: cada registrador e posição de memória direta (as “posições”)
+// recebe um valor linear, “valor da posição no início da iteração + constante”, ou o resultado de uma operação (um
+// nó). As posições cujo valor final é “o próprio valor inicial + passo” são as induções; os acessos indiretos e as
+// operações viram nós, na ordem do corpo
+
+#define VECTOR_NONE -1
+#define VECTOR_MAX_LOCATIONS 64
+#define VECTOR_MAX_NODES 128
+
+// ymm0 a ymm11 guardam os vetores calculados antes do laço e os nós; ymm12 e ymm13 recebem as induções usadas como
+// operandos e ymm14 e ymm15 são os temporários da multiplicação com SSE2 (que não tem “pmulld”)
+#define VECTOR_REGISTERS 12
+#define VECTOR_OPERAND_SCRATCH 12
+#define VECTOR_MULTIPLY_SCRATCH 14
+
+typedef struct _vector_value {
+  int location;    // VECTOR_NONE nas constantes
+  uint32_t offset; // Aritmética de 32 bits, com transbordamento
+  int node;        // VECTOR_NONE nos valores lineares
+} vector_value_t;
+
+typedef struct _vector_location {
+  operand_kind_t kind; // operand_register, operand_local (o FP, que não muda no laço) ou uma posição de memória
+  int value;
+  vector_value_t current;
+  bool written;
+  bool read;           // Lida antes de ser escrita na iteração
+  bool induction;
+  uint32_t step;
+} vector_location_t;
+
+typedef struct _vector_node {
+  opcode_t opcode;            // opcode_load, opcode_store ou a operação
+  vector_value_t left, right; // Nos acessos, “left” é o endereço e “right” o valor escrito
+  bool needed;
+  int last_use;
+  int reg;
+} vector_node_t;
+
+// Vetor calculado antes do laço: um valor repetido em todas as faixas ou, com “lanes”, o passo de uma indução (em
+// “value”) vezes o índice de cada faixa
+typedef struct _vector_hoisted {
+  bool lanes;
+  vector_value_t value;
+} vector_hoisted_t;
+
+typedef struct _vector_loop {
+  unsigned int header, end, branch;
+  const char *const *registers;
+  vector_location_t locations[VECTOR_MAX_LOCATIONS];
+  unsigned int location_count;
+  vector_node_t nodes[VECTOR_MAX_NODES];
+  unsigned int node_count;
+  vector_hoisted_t hoisted[VECTOR_REGISTERS];
+  unsigned int hoisted_count;
+  vector_value_t compared[2];
+  vector_value_t counter, bound; // O laço termina quando “counter” (de passo ±1) alcança “bound”
+  bool ascending, inclusive;
+} vector_loop_t;
+
+static inline vector_value_t vector_linear(int location, uint32_t offset)
+{
+  vector_value_t value = { location, offset, VECTOR_NONE };
+  return value;
+}
+
+static inline vector_value_t vector_result(int node)
+{
+  vector_value_t value = { VECTOR_NONE, 0, node };
+  return value;
+}
+
+static inline bool is_vector_constant(vector_value_t value)
+{
+  return value.location == VECTOR_NONE && value.node == VECTOR_NONE;
+}
+
+static inline bool same_vector_value(vector_value_t a, vector_value_t b)
+{
+  return a.location == b.location && a.offset == b.offset && a.node == b.node;
+}
+
+// Valor linear de uma posição que o laço não altera (ou constante)
+static inline bool is_vector_invariant(const vector_loop_t *loop, vector_value_t value)
+{
+  return value.node == VECTOR_NONE && (value.location == VECTOR_NONE || !loop->locations[value.location].written);
+}
+
+static inline bool is_vector_induction(const vector_loop_t *loop, vector_value_t value)
+{
+  return value.node == VECTOR_NONE && value.location != VECTOR_NONE && loop->locations[value.location].induction;
+}
+
+// Posição correspondente ao operando, criada no primeiro uso. As posições “S[FP+n]” são as mesmas de “[FP+n]”, pois
+// com 32 bits um registrador ocupa uma posição
+int vector_location(vector_loop_t *loop, operand_kind_t kind, int value)
+{
+  if (kind == operand_slot)
+    kind = operand_frame;
+  if (kind == operand_register && (value < 0 || value >= NATIVE_REGISTER_COUNT))
+    return VECTOR_NONE;
+  for (unsigned int index = 0; index < loop->location_count; index++)
+    if (loop->locations[index].kind == kind && loop->locations[index].value == value)
+      return (int)index;
+  if (loop->location_count == VECTOR_MAX_LOCATIONS)
+    return VECTOR_NONE;
+  vector_location_t *location = &loop->locations[loop->location_count];
+  location->kind = kind;
+  location->value = value;
+  location->current = vector_linear((int)loop->location_count, 0);
+  location->written = location->read = location->induction = false;
+  location->step = 0;
+  return (int)loop->location_count++;
+}
+
+bool read_vector_location(vector_loop_t *loop, operand_kind_t kind, int value, vector_value_t *result)
+{
+  int index = vector_location(loop, kind, value);
+  if (index == VECTOR_NONE)
+    return false;
+  if (!loop->locations[index].written)
+    loop->locations[index].read = true;
+  *result = loop->locations[index].current;
+  return true;
+}
+
+bool write_vector_location(vector_loop_t *loop, operand_kind_t kind, int value, vector_value_t result)
+{
+  int index = vector_location(loop, kind, value);
+  if (index == VECTOR_NONE)
+    return false;
+  loop->locations[index].written = true;
+  loop->locations[index].current = result;
+  return true;
+}
+
+bool add_vector_node(vector_loop_t *loop, opcode_t opcode, vector_value_t left, vector_value_t right,
+                     vector_value_t *result)
+{
+  if (loop->node_count == VECTOR_MAX_NODES)
+    return false;
+  vector_node_t *node = &loop->nodes[loop->node_count];
+  node->opcode = opcode;
+  node->left = left;
+  node->right = right;
+  node->needed = false;
+  node->last_use = VECTOR_NONE;
+  node->reg = VECTOR_NONE;
+  *result = vector_result((int)loop->node_count++);
+  return true;
+}
+
+// As constantes são calculadas aqui mesmo, e somar uma constante a um valor linear só muda o seu deslocamento
+bool combine_vector_values(vector_loop_t *loop, opcode_t opcode, vector_value_t left, vector_value_t right,
+                           vector_value_t *result)
+{
+  bool unary = opcode == opcode_neg || opcode == opcode_not;
+  if (is_vector_constant(left) && (unary || is_vector_constant(right))) {
+    uint32_t a = left.offset, b = right.offset, value = 0;
+    switch (opcode) {
+      case opcode_add: value = a + b; break;
+      case opcode_sub: value = a - b; break;
+      case opcode_mul: value = a * b; break;
+      case opcode_and: value = a & b; break;
+      case opcode_or: value = a | b; break;
+      case opcode_shl: value = a << (b & 31); break;
+      case opcode_neg: value = 0u - a; break;
+      default: value = ~a; break;
+    }
+    *result = vector_linear(VECTOR_NONE, value);
+    return true;
+  }
+  if (left.node == VECTOR_NONE && is_vector_constant(right) && (opcode == opcode_add || opcode == opcode_sub)) {
+    *result = vector_linear(left.location, opcode == opcode_add ? left.offset + right.offset :
+                            left.offset - right.offset);
+    return true;
+  }
+  return add_vector_node(loop, opcode, left, right, result);
+}
+
+// Valor de um operando de origem: registrador ou imediato
+bool vector_source(vector_loop_t *loop, operand_t operand, vector_value_t *result)
+{
+  if (operand.kind == operand_immediate || operand.kind == operand_address) {
+    *result = vector_linear(VECTOR_NONE, (uint32_t)operand.value);
+    return true;
+  }
+  if (operand.kind != operand_register)
+    return false;
+  return read_vector_location(loop, operand_register, operand.value, result);
+}
+
+static inline bool is_vector_memory(operand_kind_t kind)
+{
+  return kind == operand_direct || kind == operand_frame || kind == operand_slot || kind == operand_spill;
+}
+
+// Procura o desvio de volta para “header” e confere que o corpo é uma sequência sem rótulos com uma única saída
+bool find_vector_loop(vector_loop_t *loop, const instruction_t *code, unsigned int length, unsigned int header)
+{
+  if (header > 0 && (code[header - 1].opcode == opcode_jump || code[header - 1].opcode == opcode_ret ||
+                     code[header - 1].opcode == opcode_trap))
+    return false;
+  unsigned int index = header;
+  while (index < length && !(code[index].opcode == opcode_jump && code[index].dst.kind == operand_label &&
+                             code[index].dst.value == (int)header))
+    index++;
+  if (index == length)
+    return false;
+  loop->header = header;
+  loop->end = index;
+  loop->branch = length;
+  for (index = 0; index < length; index++) {
+    const instruction_t *instruction = &code[index];
+    if (instruction->dst.kind != operand_label)
+      continue;
+    unsigned int target = (unsigned int)instruction->dst.value;
+    if ((target == header && index != loop->end) || (target > header && target <= loop->end))
+      return false;
+    if (index < header || index >= loop->end || instruction->opcode < opcode_breq || instruction->opcode > opcode_brge)
+      continue;
+    if (loop->branch != length || index == header || code[index - 1].opcode != opcode_cmp)
+      return false;
+    loop->branch = index;
+  }
+  return loop->branch != length;
+}
+
+bool simulate_vector_loop(vector_loop_t *loop, const instruction_t *code)
+{
+  loop->location_count = 0;
+  loop->node_count = 0;
+  for (unsigned int index = loop->header; index < loop->end; index++) {
+    opcode_t opcode = code[index].opcode;
+    operand_t dst = code[index].dst, src = code[index].src;
+    vector_value_t left, right, result;
+    switch (opcode) {
+      case opcode_nop:
+        break;
+      case opcode_load:
+        if (dst.kind != operand_register)
+          return false;
+        if (src.kind == operand_local)
+          result = vector_linear(vector_location(loop, operand_local, 0), (uint32_t)src.value);
+        else if (src.kind == operand_indirect) {
+          if (!read_vector_location(loop, operand_register, src.value, &left) ||
+              !add_vector_node(loop, opcode_load, left, left, &result))
+            return false;
+        }
+        else if (is_vector_memory(src.kind)) {
+          if (!read_vector_location(loop, src.kind, src.value, &result))
+            return false;
+        }
+        else if (!vector_source(loop, src, &result))
+          return false;
+        if (!write_vector_location(loop, operand_register, dst.value, result))
+          return false;
+        break;
+      case opcode_store:
+        if (src.kind != operand_register || !read_vector_location(loop, operand_register, src.value, &right))
+          return false;
+        if (dst.kind == operand_indirect) {
+          if (!read_vector_location(loop, operand_register, dst.value, &left) ||
+              !add_vector_node(loop, opcode_store, left, right, &result))
+            return false;
+        }
+        else if (!is_vector_memory(dst.kind) || !write_vector_location(loop, dst.kind, dst.value, right))
+          return false;
+        break;
+      case opcode_mov:
+        if (dst.kind != operand_register || !vector_source(loop, src, &result) ||
+            !write_vector_location(loop, operand_register, dst.value, result))
+          return false;
+        break;
+      case opcode_add:
+      case opcode_sub:
+      case opcode_mul:
+      case opcode_and:
+      case opcode_or:
+      case opcode_shl:
+      case opcode_neg:
+      case opcode_not:
+        if (dst.kind != operand_register || !read_vector_location(loop, operand_register, dst.value, &left))
+          return false;
+        if (opcode == opcode_neg || opcode == opcode_not)
+          right = left;
+        else if ((opcode == opcode_shl && src.kind != operand_immediate) || !vector_source(loop, src, &right))
+          return false;
+        if (!combine_vector_values(loop, opcode, left, right, &result) ||
+            !write_vector_location(loop, operand_register, dst.value, result))
+          return false;
+        break;
+      case opcode_cmp:
+        if (index + 1 != loop->branch || dst.kind != operand_register ||
+            !read_vector_location(loop, operand_register, dst.value, &loop->compared[0]) ||
+            !vector_source(loop, src, &loop->compared[1]))
+          return false;
+        break;
+      default:
+        // Apenas o desvio de saída; divisões, chamadas e os demais desvios impedem a vetorização
+        if (index != loop->branch)
+          return false;
+        break;
+    }
+  }
+  // Um valor lido antes de ser escrito passa de uma iteração para a seguinte, o que só é permitido nas induções
+  for (unsigned int index = 0; index < loop->location_count; index++) {
+    vector_location_t *location = &loop->locations[index];
+    if (!location->written)
+      continue;
+    location->induction = location->current.node == VECTOR_NONE && location->current.location == (int)index;
+    location->step = location->current.offset;
+    if (location->read && !location->induction)
+      return false;
+  }
+  return true;
+}
+
+// A condição de saída compara uma indução de passo ±1 com um valor que não muda: “counter >= bound” (ou “>”) quando o
+// passo é 1 e “counter <= bound” (ou “<”) quando é -1
+bool find_vector_count(vector_loop_t *loop, const instruction_t *code)
+{
+  static const opcode_t mirrored[] = { opcode_breq, opcode_brne, opcode_brgr, opcode_brge, opcode_brls, opcode_brle };
+  opcode_t exit = code[loop->branch].opcode;
+  if (is_vector_induction(loop, loop->compared[0]) && is_vector_invariant(loop, loop->compared[1])) {
+    loop->counter = loop->compared[0];
+    loop->bound = loop->compared[1];
+  }
+  else if (is_vector_induction(loop, loop->compared[1]) && is_vector_invariant(loop, loop->compared[0])) {
+    loop->counter = loop->compared[1];
+    loop->bound = loop->compared[0];
+    exit = mirrored[exit - opcode_breq];
+  }
+  else
+    return false;
+  uint32_t step = loop->locations[loop->counter.location].step;
+  loop->ascending = step == 1;
+  if (step == 1 && (exit == opcode_brge || exit == opcode_brgr))
+    loop->inclusive = exit == opcode_brgr;
+  else if (step == UINT32_MAX && (exit == opcode_brle || exit == opcode_brls))
+    loop->inclusive = exit == opcode_brls;
+  else
+    return false;
+  return true;
+}
+
+// Registrador do vetor calculado antes do laço, criado no primeiro uso
+int hoist_vector_value(vector_loop_t *loop, bool lanes, vector_value_t value)
+{
+  for (unsigned int index = 0; index < loop->hoisted_count; index++)
+    if (loop->hoisted[index].lanes == lanes && same_vector_value(loop->hoisted[index].value, value))
+      return (int)index;
+  if (loop->hoisted_count == VECTOR_REGISTERS)
+    return VECTOR_NONE;
+  loop->hoisted[loop->hoisted_count].lanes = lanes;
+  loop->hoisted[loop->hoisted_count].value = value;
+  return (int)loop->hoisted_count++;
+}
+
+// Os vetores calculados antes do laço e os dos nós dividem VECTOR_REGISTERS registradores
+bool plan_vector_operand(vector_loop_t *loop, vector_value_t value, int user)
+{
+  if (value.node != VECTOR_NONE) {
+    loop->nodes[value.node].last_use = user;
+    return true;
+  }
+  if (is_vector_induction(loop, value))
+    return hoist_vector_value(loop, true, vector_linear(VECTOR_NONE, loop->locations[value.location].step)) !=
+      VECTOR_NONE;
+  return hoist_vector_value(loop, false, value) != VECTOR_NONE;
+}
+
+// Apenas as escritas indiretas, os nós dos quais elas dependem e os acessos que podem se sobrepor a elas são
+// executados na versão vetorial. Os endereços precisam avançar uma posição por iteração
+bool plan_vector_loop(vector_loop_t *loop)
+{
+  bool stored = false;
+  for (int index = (int)loop->node_count - 1; index >= 0; index--) {
+    vector_node_t *node = &loop->nodes[index];
+    if (node->opcode == opcode_store)
+      node->needed = stored = true;
+    if (!node->needed)
+      continue;
+    if (node->left.node != VECTOR_NONE)
+      loop->nodes[node->left.node].needed = true;
+    if (node->right.node != VECTOR_NONE)
+      loop->nodes[node->right.node].needed = true;
+  }
+  if (!stored)
+    return false;
+  loop->hoisted_count = 0;
+  for (unsigned int index = 0; index < loop->node_count; index++) {
+    vector_node_t *node = &loop->nodes[index];
+    if (!node->needed)
+      continue;
+    if (node->opcode == opcode_load || node->opcode == opcode_store) {
+      if (!is_vector_induction(loop, node->left) || loop->locations[node->left.location].step != 1)
+        return false;
+      if (node->opcode == opcode_store && !plan_vector_operand(loop, node->right, (int)index))
+        return false;
+    }
+    else if (!plan_vector_operand(loop, node->left, (int)index) ||
+             (node->opcode != opcode_shl && !plan_vector_operand(loop, node->right, (int)index)))
+      return false;
+  }
+  bool used[VECTOR_REGISTERS] = { false };
+  for (unsigned int index = 0; index < loop->node_count; index++) {
+    vector_node_t *node = &loop->nodes[index];
+    if (!node->needed)
+      continue;
+    // O destino é escolhido antes de liberar os operandos, para que nunca coincida com eles
+    if (node->opcode != opcode_store) {
+      int reg = (int)loop->hoisted_count;
+      while (reg < VECTOR_REGISTERS && used[reg])
+        reg++;
+      if (reg == VECTOR_REGISTERS)
+        return false;
+      node->reg = reg;
+      used[reg] = true;
+    }
+    if (node->left.node != VECTOR_NONE && loop->nodes[node->left.node].last_use == (int)index)
+      used[loop->nodes[node->left.node].reg] = false;
+    if (node->right.node != VECTOR_NONE && loop->nodes[node->right.node].last_use == (int)index)
+      used[loop->nodes[node->right.node].reg] = false;
+  }
+  return true;
+}
+
+static inline bool is_vector_access(const vector_node_t *node)
+{
+  return node->needed && (node->opcode == opcode_load || node->opcode == opcode_store);
+}
+
+void print_vector_location(FILE *file, const vector_location_t *location)
+{
+  if (location->kind == operand_direct)
+    fprintf(file, NATIVE_SYMBOL_PREFIX "oberon_data+%d(%%rip)", location->value * (int)sizeof(value_t));
+  else if (location->kind == operand_frame)
+    fprintf(file, "%d(%%rbp,%%r15,%d)", location->value * (int)sizeof(value_t), (int)sizeof(value_t));
+  else
+    fprintf(file, NATIVE_SYMBOL_PREFIX "oberon_spill+%d(%%rip)", location->value * (int)sizeof(word_t));
+}
+
+// Coloca o valor linear, no início do bloco de iterações corrente, no registrador de 32 bits “target”
+void write_vector_scalar(FILE *file, const vector_loop_t *loop, vector_value_t value, const char *target)
+{
+  int offset = (int)value.offset;
+  if (value.location == VECTOR_NONE) {
+    fprintf(file, "\tmovl $%d, %%%s\n", offset, target);
+    return;
+  }
+  const vector_location_t *location = &loop->locations[value.location];
+  if (location->kind == operand_register && offset == 0)
+    fprintf(file, "\tmovl %%%s, %%%s\n", loop->registers[location->value], target);
+  else if (location->kind == operand_register)
+    fprintf(file, "\tleal %d(%%%s), %%%s\n", offset, loop->registers[location->value], target);
+  else if (location->kind == operand_local)
+    fprintf(file, "\tleal %d(%%r15), %%%s\n", offset, target);
+  else {
+    fprintf(file, "\tmovl ");
+    print_vector_location(file, location);
+    fprintf(file, ", %%%s\n", target);
+    if (offset != 0)
+      fprintf(file, "\taddl $%d, %%%s\n", offset, target);
+  }
+}
+
+// Endereço (reduzido a 16 bits) do primeiro elemento do bloco em “rax”
+void write_vector_address(FILE *file, const vector_loop_t *loop, vector_value_t value)
+{
+  write_vector_scalar(file, loop, value, "eax");
+  fprintf(file, "\tmovzwl %%ax, %%eax\n");
+}
+
+static inline const char *vector_register_prefix(bool avx)
+{
+  return avx ? "ymm" : "xmm";
+}
+
+// Repete “eax” em todas as faixas de “target”
+void write_vector_broadcast(FILE *file, bool avx, int target)
+{
+  if (avx)
+    fprintf(file, "\tvmovd %%eax, %%xmm%d\n\tvpbroadcastd %%xmm%d, %%ymm%d\n", target, target, target);
+  else
+    fprintf(file, "\tmovd %%eax, %%xmm%d\n\tpshufd $0, %%xmm%d, %%xmm%d\n", target, target, target);
+}
+
+// “target” ← “left” op “right”. Sem AVX, as operações têm dois operandos e “target” não pode ser “right”
+void write_vector_binary(FILE *file, bool avx, const char *mnemonic, int left, int right, int target)
+{
+  const char *prefix = vector_register_prefix(avx);
+  if (avx)
+    fprintf(file, "\tv%s %%%s%d, %%%s%d, %%%s%d\n", mnemonic, prefix, right, prefix, left, prefix, target);
+  else {
+    if (left != target)
+      fprintf(file, "\tmovdqa %%%s%d, %%%s%d\n", prefix, left, prefix, target);
+    fprintf(file, "\t%s %%%s%d, %%%s%d\n", mnemonic, prefix, right, prefix, target);
+  }
+}
+
+// Com SSE2, as faixas pares e ímpares são multiplicadas separadamente (“pmuludq”) e os 32 bits menos significativos
+// de cada produto são reunidos
+void write_vector_multiply(FILE *file, bool avx, int left, int right, int target)
+{
+  if (avx) {
+    write_vector_binary(file, avx, "pmulld", left, right, target);
+    return;
+  }
+  int odd = VECTOR_MULTIPLY_SCRATCH, other = VECTOR_MULTIPLY_SCRATCH + 1;
+  fprintf(file, "\tpshufd $0xf5, %%xmm%d, %%xmm%d\n\tpshufd $0xf5, %%xmm%d, %%xmm%d\n", left, odd, right, other);
+  fprintf(file, "\tpmuludq %%xmm%d, %%xmm%d\n", other, odd);
+  write_vector_binary(file, avx, "pmuludq", left, right, target);
+  fprintf(file, "\tpshufd $0x08, %%xmm%d, %%xmm%d\n\tpshufd $0x08, %%xmm%d, %%xmm%d\n", target, target, odd, odd);
+  fprintf(file, "\tpunpckldq %%xmm%d, %%xmm%d\n", odd, target);
+}
+
+// Registrador com o valor do operando em cada faixa. As induções são calculadas no próprio bloco, em “scratch”
+int write_vector_operand(FILE *file, const vector_loop_t *loop, vector_value_t value, int scratch, bool avx)
+{
+  if (value.node != VECTOR_NONE)
+    return loop->nodes[value.node].reg;
+  bool induction = is_vector_induction(loop, value);
+  vector_value_t hoisted = induction ? vector_linear(VECTOR_NONE, loop->locations[value.location].step) : value;
+  int lanes = VECTOR_NONE;
+  for (unsigned int index = 0; index < loop->hoisted_count; index++)
+    if (loop->hoisted[index].lanes == induction && same_vector_value(loop->hoisted[index].value, hoisted))
+      lanes = (int)index;
+  if (!induction)
+    return lanes;
+  write_vector_scalar(file, loop, value, "eax");
+  write_vector_broadcast(file, avx, scratch);
+  write_vector_binary(file, avx, "paddd", scratch, lanes, scratch);
+  return scratch;
+}
+
+void write_vector_node(FILE *file, const vector_loop_t *loop, const vector_node_t *node, bool avx)
+{
+  const char *prefix = vector_register_prefix(avx);
+  const char *move = avx ? "vmovdqu" : "movdqu";
+  int left = 0, right = 0, target = node->reg;
+  switch (node->opcode) {
+    case opcode_load:
+      write_vector_address(file, loop, node->left);
+      fprintf(file, "\t%s (%%rbp,%%rax,%d), %%%s%d\n", move, (int)sizeof(value_t), prefix, target);
+      return;
+    case opcode_store:
+      // O valor vem antes do endereço, pois as induções também são calculadas em “eax”
+      right = write_vector_operand(file, loop, node->right, VECTOR_OPERAND_SCRATCH, avx);
+      write_vector_address(file, loop, node->left);
+      fprintf(file, "\t%s %%%s%d, (%%rbp,%%rax,%d)\n", move, prefix, right, (int)sizeof(value_t));
+      return;
+    default:
+      break;
+  }
+  left = write_vector_operand(file, loop, node->left, VECTOR_OPERAND_SCRATCH, avx);
+  if (node->opcode != opcode_shl && node->opcode != opcode_neg && node->opcode != opcode_not)
+    right = write_vector_operand(file, loop, node->right, VECTOR_OPERAND_SCRATCH + 1, avx);
+  switch (node->opcode) {
+    case opcode_add: write_vector_binary(file, avx, "paddd", left, right, target); break;
+    case opcode_sub: write_vector_binary(file, avx, "psubd", left, right, target); break;
+    case opcode_and: write_vector_binary(file, avx, "pand", left, right, target); break;
+    case opcode_or: write_vector_binary(file, avx, "por", left, right, target); break;
+    case opcode_mul: write_vector_multiply(file, avx, left, right, target); break;
+    case opcode_shl:
+      if (avx)
+        fprintf(file, "\tvpslld $%u, %%ymm%d, %%ymm%d\n", node->right.offset & 31, left, target);
+      else
+        fprintf(file, "\tmovdqa %%xmm%d, %%xmm%d\n\tpslld $%u, %%xmm%d\n", left, target, node->right.offset & 31,
+                target);
+      break;
+    case opcode_neg:
+      write_vector_binary(file, avx, "pxor", target, target, target);
+      write_vector_binary(file, avx, "psubd", target, left, target);
+      break;
+    default:
+      write_vector_binary(file, avx, "pcmpeqd", target, target, target);
+      write_vector_binary(file, avx, "pxor", target, left, target);
+      break;
+  }
+}
+
+// Desvia para o laço original se o bloco puder ler o que uma iteração anterior do mesmo bloco ainda não escreveu (ou
+// escrever antes do que uma iteração anterior leria): um acesso posterior no corpo, a 1 até “lanes” - 1 posições
+// depois de um anterior. As posições diretas não podem estar nos vetores acessados, pois o bloco não as escreve nem as
+// lê novamente
+void write_vector_checks(FILE *file, const vector_loop_t *loop, unsigned int lanes)
+{
+  for (unsigned int index = 0; index < loop->node_count; index++) {
+    const vector_node_t *node = &loop->nodes[index];
+    if (!is_vector_access(node))
+      continue;
+    write_vector_address(file, loop, node->left);
+    fprintf(file, "\taddq %%r11, %%rax\n\tcmpq $%d, %%rax\n\tjg .L%u\n", MAX_ADDRESS + 1, loop->header);
+    for (unsigned int other = 0; other < index; other++) {
+      const vector_node_t *earlier = &loop->nodes[other];
+      if (!is_vector_access(earlier) || (node->opcode == opcode_load && earlier->opcode == opcode_load) ||
+          same_vector_value(node->left, earlier->left))
+        continue;
+      write_vector_scalar(file, loop, node->left, "eax");
+      write_vector_scalar(file, loop, earlier->left, "edx");
+      fprintf(file, "\tsubl %%edx, %%eax\n\tmovzwl %%ax, %%eax\n\tsubl $1, %%eax\n\tcmpl $%u, %%eax\n\tjb .L%u\n",
+              lanes - 1, loop->header);
+    }
+    for (unsigned int other = 0; other < loop->location_count; other++) {
+      const vector_location_t *location = &loop->locations[other];
+      if ((location->kind != operand_direct && location->kind != operand_frame) ||
+          (!location->written && node->opcode == opcode_load))
+        continue;
+      if (location->kind == operand_direct)
+        fprintf(file, "\tmovl $%d, %%eax\n", location->value);
+      else
+        fprintf(file, "\tleal %d(%%r15), %%eax\n", location->value);
+      write_vector_scalar(file, loop, node->left, "edx");
+      fprintf(file, "\tsubl %%edx, %%eax\n\tmovzwl %%ax, %%eax\n\tcmpq %%r11, %%rax\n\tjb .L%u\n", loop->header);
+    }
+  }
+}
+
+// A quantidade de iterações restantes fica em “r11”; os blocos são executados enquanto ela for maior que “lanes”,
+// para que o laço original execute ao menos uma iteração
+void write_vector_path(FILE *file, const vector_loop_t *loop, bool avx)
+{
+  unsigned int lanes = avx ? 8 : 4;
+  const char *prefix = vector_register_prefix(avx);
+  write_vector_scalar(file, loop, loop->counter, "eax");
+  write_vector_scalar(file, loop, loop->bound, "edx");
+  fprintf(file, "\tmovslq %%eax, %%rax\n\tmovslq %%edx, %%rdx\n");
+  if (loop->ascending)
+    fprintf(file, "\tmovq %%rdx, %%r11\n\tsubq %%rax, %%r11\n");
+  else
+    fprintf(file, "\tmovq %%rax, %%r11\n\tsubq %%rdx, %%r11\n");
+  if (loop->inclusive)
+    fprintf(file, "\taddq $1, %%r11\n");
+  fprintf(file, "\tcmpq $%u, %%r11\n\tjle .L%u\n", lanes, loop->header);
+  write_vector_checks(file, loop, lanes);
+  for (unsigned int index = 0; index < loop->hoisted_count; index++) {
+    const vector_hoisted_t *hoisted = &loop->hoisted[index];
+    if (!hoisted->lanes) {
+      write_vector_scalar(file, loop, hoisted->value, "eax");
+      write_vector_broadcast(file, avx, (int)index);
+      continue;
+    }
+    fprintf(file, "\t%s .Lvector_lanes(%%rip), %%%s%u\n", avx ? "vmovdqa" : "movdqa", prefix, index);
+    if (hoisted->value.offset != 1) {
+      fprintf(file, "\tmovl $%d, %%eax\n", (int)hoisted->value.offset);
+      write_vector_broadcast(file, avx, VECTOR_OPERAND_SCRATCH);
+      write_vector_multiply(file, avx, (int)index, VECTOR_OPERAND_SCRATCH, (int)index);
+    }
+  }
+  fprintf(file, ".LV%u_%u:\n", loop->header, lanes);
+  for (unsigned int index = 0; index < loop->node_count; index++)
+    if (loop->nodes[index].needed)
+      write_vector_node(file, loop, &loop->nodes[index], avx);
+  for (unsigned int index = 0; index < loop->location_count; index++) {
+    const vector_location_t *location = &loop->locations[index];
+    if (!location->induction || location->step == 0)
+      continue;
+    fprintf(file, "\taddl $%d, ", (int)(location->step * lanes));
+    if (location->kind == operand_register)
+      fprintf(file, "%%%s\n", loop->registers[location->value]);
+    else {
+      print_vector_location(file, location);
+      fprintf(file, "\n");
+    }
+  }
+  fprintf(file, "\tsubq $%u, %%r11\n\tcmpq $%u, %%r11\n\tjg .LV%u_%u\n", lanes, lanes, loop->header, lanes);
+  if (avx)
+    fprintf(file, "\tvzeroupper\n");
+}
+
+bool write_vector_loop(FILE *file, const instruction_t *code, unsigned int length, unsigned int header,
+                       const char *const *registers)
+{
+  vector_loop_t loop;
+  loop.registers = registers;
+  if (!find_vector_loop(&loop, code, length, header) || !simulate_vector_loop(&loop, code) ||
+      !find_vector_count(&loop, code) || !plan_vector_loop(&loop))
+    return false;
+  fprintf(file, "\tcmpl $0, " NATIVE_SYMBOL_PREFIX "oberon_avx2(%%rip)\n\tje .LV%u_sse\n", header);
+  write_vector_path(file, &loop, true);
+  fprintf(file, "\tjmp .L%u\n.LV%u_sse:\n", header, header);
+  write_vector_path(file, &loop, false);
+  return true;
+}
+
+void write_vector_data(FILE *file)
+{
+  fprintf(file, "\t.p2align 5\n.Lvector_lanes:\n\t.long 0, 1, 2, 3, 4, 5, 6, 7\n");
+}
+
+#else
+
+bool write_vector_loop(FILE *file, const instruction_t *code, unsigned int length, unsigned int header,
+                       const char *const *registers)
+{
+  (void)file; (void)code; (void)length; (void)header; (void)registers;
+  return false;
+}
+
+void write_vector_data(FILE *file)
+{
+  (void)file;
+}
+
+#endif
@@ -0,0 +1,44 @@
+//
+//  vector.h
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef Oberon_vector_h
+#define Oberon_vector_h
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "backend.h"
+
+// Vetorização dos laços simples no gerador x86-64 (ver “native.h”). Um laço pode ser vetorizado quando:
+//
+//   - começa em um rótulo alcançado apenas pela instrução anterior e pelo desvio incondicional do seu fim, e o corpo
+//     não tem outros rótulos nem desvios, exceto um desvio condicional para fora logo após um “CMP”;
+//   - o “CMP” compara uma variável de indução de passo ±1 (um registrador ou posição de memória que o laço só
+//     incrementa) com uma constante ou um valor que o laço não altera, então a quantidade de iterações é conhecida na
+//     entrada;
+//   - os acessos indiretos usam endereços da forma “indução + constante”, com passo 1 (posições consecutivas);
+//   - nenhum valor passa de uma iteração para a seguinte, exceto as induções, e não há divisões nem chamadas.
+//
+// A versão vetorial vem antes do rótulo do laço: ela confere, durante a execução, que os vetores acessados não passam
+// do fim da memória e não se sobrepõem de modo que uma iteração leia o que outra (do mesmo bloco) escreveria, e então
+// executa blocos de 8 iterações com AVX2 (ou de 4 com SSE2, conforme “oberon_avx2” no suporte de execução). Os
+// acessos indiretos e as operações necessárias para os valores escritos neles são feitos na ordem do corpo; as escritas
+// diretas e os demais valores ficam a cargo do laço original, que continua a partir das induções atualizadas e executa
+// sempre ao menos uma iteração (o que recalcula todos os valores que o corpo escreve).
+//
+// Apenas com VALUE_BITS igual a 32, em que um registrador e uma posição de memória têm a largura de uma faixa do vetor
+
+// Escreve a versão vetorial do laço que começa em “header” (antes do seu rótulo), usando os nomes dos registradores
+// R0, R1..., e retorna se o laço foi vetorizado
+bool write_vector_loop(FILE *file, const instruction_t *code, unsigned int length, unsigned int header,
+                       const char *const *registers);
+
+// Dados usados pelas versões vetoriais, escritos na seção de dados se algum laço foi vetorizado
+void write_vector_data(FILE *file);
+
+#endif
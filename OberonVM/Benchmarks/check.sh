@@ -0,0 +1,62 @@
+#!/bin/sh
+#
+#  check.sh
+#  OberonVM
+#
+#  Created by Alvaro Costa Neto on 10/17/26.
+#  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+#
+# Uso: check.sh [-u] compilador máquina_virtual
+#
+# Compila cada programa deste diretório que tem um resultado esperado (“Programa.expected” sem opções e
+# “Programa.checks.expected” com “-c”), executa-o na máquina virtual e compara a quantidade de instruções executadas e
+# a área de dados final com o esperado. A quantidade de instruções acusa as otimizações que deixam de acontecer; a área
+# de dados, os erros de compilação. Com “-u”, os resultados esperados são reescritos
+
+update=false
+if [ "$1" = "-u" ]; then
+	update=true
+	shift
+fi
+if [ $# -ne 2 ]; then
+	echo "Usage: check.sh [-u] compiler machine"
+	exit 1
+fi
+compiler=$1
+machine=$2
+directory=$(dirname "$0")
+object=$(mktemp)
+count=$(mktemp)
+data=$(mktemp)
+result=$(mktemp)
+trap 'rm -f "$object" "$count" "$data" "$result"' EXIT
+
+failures=0
+for expected in "$directory"/*.expected; do
+	name=${expected%.expected}
+	flags=""
+	case "$name" in
+		*.checks) name=${name%.checks}; flags="-c" ;;
+	esac
+	label="$(basename "$name")${flags:+ $flags}"
+	if ! "$compiler" $flags -b "$name.txt" "$object" > "$result" 2>&1 || [ -s "$result" ]; then
+		echo "$label: compilation failed"
+		cat "$result"
+		failures=$((failures + 1))
+		continue
+	fi
+	"$machine" -s -d "$object" > "$data" 2> "$count"
+	{ sed 's/ in .*$//' "$count"; cat "$data"; } > "$result"
+	if $update; then
+		cp "$result" "$expected"
+	elif ! cmp -s "$expected" "$result"; then
+		echo "$label: differs"
+		diff "$expected" "$result"
+		failures=$((failures + 1))
+	fi
+done
+if [ $failures -gt 0 ]; then
+	echo "$failures failed."
+	exit 1
+fi
+echo "All passed."
@@ -0,0 +1,468 @@
+//
+//  machine.c
+//  OberonVM
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "machine.h"
+
+// Com GCC e Clang o laço de execução usa “computed goto” (“direct threading”): cada operação guarda o endereço do seu
+// tratador e o salto para a próxima é feito ao final de cada tratador, sem passar por um “switch” central. Nos demais
+// compiladores (ou com MACHINE_NO_THREADING definido) o mesmo código é montado como um “switch” comum
+#if defined(__GNUC__) && !defined(MACHINE_NO_THREADING)
+#define MACHINE_THREADED
+#endif
+
+typedef enum _machine_code {
+  code_halt,
+  code_nop,
+  code_load_immediate,
+  code_load_direct,
+  code_load_indirect,
+  code_store_direct,
+  code_store_indirect,
+  code_load_spill,
+  code_store_spill,
+  code_mov,
+  // As operações aritméticas e lógicas aparecem aos pares: a versão com registrador é sempre seguida pela com imediato
+  code_add_register,
+  code_add_immediate,
+  code_sub_register,
+  code_sub_immediate,
+  code_mul_register,
+  code_mul_immediate,
+  code_div_register,
+  code_div_immediate,
+  code_mod_register,
+  code_mod_immediate,
+  code_and_register,
+  code_and_immediate,
+  code_or_register,
+  code_or_immediate,
+  code_cmp_register,
+  code_cmp_immediate,
+  code_shl,
+  code_neg,
+  code_not,
+  code_breq,
+  code_brne,
+  code_brls,
+  code_brle,
+  code_brgr,
+  code_brge,
+  code_jump,
+  code_trap,
+  // Procedimentos: registro de ativação, parâmetros, chamada e retorno
+  code_load_frame,
+  code_store_frame,
+  code_load_local,
+  code_load_slot,
+  code_store_slot,
+  code_set_argument,
+  code_set_argument_immediate,
+  code_get_argument,
+  code_call,
+  code_enter,
+  code_ret
+} machine_code_t;
+
+static inline bool is_register(operand_t operand)
+{
+  return operand.kind == operand_register && operand.value >= 0 && operand.value < MACHINE_REGISTER_COUNT;
+}
+
+static inline bool is_indirect(operand_t operand)
+{
+  return operand.kind == operand_indirect && operand.value >= 0 && operand.value < MACHINE_REGISTER_COUNT;
+}
+
+static inline bool is_immediate(operand_t operand)
+{
+  return operand.kind == operand_immediate || operand.kind == operand_address;
+}
+
+static inline bool is_argument(operand_t operand)
+{
+  return operand.kind == operand_argument && operand.value >= 0 && operand.value < MAX_PARAMETERS;
+}
+
+// Posições do registro de ativação ficam dentro da memória, cujo tamanho também limita o registro
+static inline bool is_frame(operand_t operand, operand_kind_t kind)
+{
+  return operand.kind == kind && operand.value >= 0 && operand.value < MACHINE_MEMORY_SIZE;
+}
+
+// As posições de memória dos registradores que não couberam na máquina formam uma área própria, dimensionada pelo
+// maior índice usado no programa
+static inline bool is_spill(operand_t operand, program_t *program)
+{
+  if (operand.kind != operand_spill || operand.value < 0 || operand.value >= MACHINE_MEMORY_SIZE)
+    return false;
+  if ((uint32_t)operand.value >= program->spill_count)
+    program->spill_count = (uint32_t)operand.value + 1;
+  return true;
+}
+
+// Traduz uma instrução do arquivo objeto para a operação especializada correspondente
+bool decode_operation(const instruction_t *instruction, operation_t *operation, program_t *program)
+{
+  operand_t dst = instruction->dst, src = instruction->src;
+  operation->a = is_register(dst) || is_indirect(dst) ? (unsigned char)dst.value : 0;
+  operation->b = is_register(src) || is_indirect(src) ? (unsigned char)src.value : 0;
+  operation->constant = 0;
+  operation->target = NULL;
+  switch (instruction->opcode) {
+    case opcode_nop:
+      operation->code = code_nop;
+      return true;
+    case opcode_load:
+      if (!is_register(dst))
+        return false;
+      operation->constant = src.value;
+      if (is_immediate(src))
+        operation->code = code_load_immediate;
+      else if (src.kind == operand_direct)
+        operation->code = code_load_direct;
+      else if (is_indirect(src))
+        operation->code = code_load_indirect;
+      else if (is_spill(src, program))
+        operation->code = code_load_spill;
+      else if (is_frame(src, operand_frame))
+        operation->code = code_load_frame;
+      else if (is_frame(src, operand_local))
+        operation->code = code_load_local;
+      else if (is_frame(src, operand_slot))
+        operation->code = code_load_slot;
+      else
+        return false;
+      return true;
+    case opcode_store:
+      if (!is_register(src))
+        return false;
+      operation->constant = dst.value;
+      if (dst.kind == operand_direct)
+        operation->code = code_store_direct;
+      else if (is_indirect(dst))
+        operation->code = code_store_indirect;
+      else if (is_spill(dst, program))
+        operation->code = code_store_spill;
+      else if (is_frame(dst, operand_frame))
+        operation->code = code_store_frame;
+      else if (is_frame(dst, operand_slot))
+        operation->code = code_store_slot;
+      else
+        return false;
+      return true;
+    case opcode_mov:
+      // Os parâmetros usam o campo “a” para o seu índice
+      if (is_argument(dst) && (is_register(src) || is_immediate(src))) {
+        operation->code = is_register(src) ? code_set_argument : code_set_argument_immediate;
+        operation->a = (unsigned char)dst.value;
+        operation->constant = src.value;
+        return true;
+      }
+      if (is_register(dst) && is_argument(src)) {
+        operation->code = code_get_argument;
+        operation->b = (unsigned char)src.value;
+        return true;
+      }
+      if (!is_register(dst) || !is_register(src))
+        return false;
+      operation->code = code_mov;
+      return true;
+    case opcode_add: operation->code = code_add_register; break;
+    case opcode_sub: operation->code = code_sub_register; break;
+    case opcode_mul: operation->code = code_mul_register; break;
+    case opcode_div: operation->code = code_div_register; break;
+    case opcode_mod: operation->code = code_mod_register; break;
+    case opcode_and: operation->code = code_and_register; break;
+    case opcode_or: operation->code = code_or_register; break;
+    case opcode_cmp: operation->code = code_cmp_register; break;
+    case opcode_shl:
+      if (!is_register(dst) || src.kind != operand_immediate)
+        return false;
+      operation->code = code_shl;
+      operation->constant = src.value & 31;
+      return true;
+    case opcode_neg:
+    case opcode_not:
+      if (!is_register(dst))
+        return false;
+      operation->code = instruction->opcode == opcode_neg ? code_neg : code_not;
+      return true;
+    case opcode_trap:
+      if (dst.kind != operand_immediate || dst.value != trap_index_out_of_range)
+        return false;
+      operation->code = code_trap;
+      operation->constant = dst.value;
+      return true;
+    case opcode_call:
+      if (dst.kind != operand_label || dst.value < 0 || (uint32_t)dst.value > program->length)
+        return false;
+      operation->code = code_call;
+      operation->target = &program->operations[dst.value];
+      return true;
+    case opcode_enter:
+    case opcode_ret:
+      if (dst.kind != operand_immediate || dst.value < 0 || dst.value > MACHINE_MEMORY_SIZE)
+        return false;
+      operation->code = instruction->opcode == opcode_enter ? code_enter : code_ret;
+      operation->constant = dst.value;
+      return true;
+    default:
+      if (instruction->opcode < opcode_breq || instruction->opcode > opcode_jump || dst.kind != operand_label ||
+          dst.value < 0 || (uint32_t)dst.value > program->length)
+        return false;
+      operation->code = code_breq + (instruction->opcode - opcode_breq);
+      // O destino pode ser o fim do programa, onde fica a operação de parada
+      operation->target = &program->operations[dst.value];
+      return true;
+  }
+  // Operações aritméticas, lógicas e comparações
+  if (!is_register(dst))
+    return false;
+  if (is_immediate(src)) {
+    operation->code++;
+    operation->constant = src.value;
+  }
+  else if (!is_register(src))
+    return false;
+  return true;
+}
+
+// Os endereços das variáveis são absolutos e a área de dados começa no endereço zero, por isso as relocações do
+// arquivo objeto não precisam ser aplicadas
+bool load_program(program_t *program, const object_t *object)
+{
+  if (!program || !object || object->data_size > MACHINE_MEMORY_SIZE)
+    return false;
+  program->length = object->code_length;
+  program->data_size = object->data_size;
+  program->threaded = false;
+  program->spill_count = 0;
+  program->spills = NULL;
+  program->returns = NULL;
+  program->operations = (operation_t *)malloc(((size_t)object->code_length + 1) * sizeof(operation_t));
+  if (!program->operations)
+    return false;
+  for (uint32_t index = 0; index < object->code_length; index++)
+    if (!decode_operation(&object->code[index], &program->operations[index], program)) {
+      unload_program(program);
+      return false;
+    }
+  program->spills = (word_t *)calloc((size_t)program->spill_count + 1, sizeof(word_t));
+  // Cada registro de ativação ocupa ao menos uma posição de memória, o que limita a profundidade das chamadas
+  bool calls = false;
+  for (uint32_t index = 0; index < object->code_length; index++)
+    calls = calls || program->operations[index].code == code_call;
+  if (calls)
+    program->returns = (const operation_t **)malloc(MACHINE_MEMORY_SIZE * sizeof(operation_t *));
+  if (!program->spills || (calls && !program->returns)) {
+    unload_program(program);
+    return false;
+  }
+  operation_t *halt = &program->operations[object->code_length];
+  memset(halt, 0, sizeof(operation_t));
+  halt->code = code_halt;
+  return true;
+}
+
+void unload_program(program_t *program)
+{
+  if (!program)
+    return;
+  free(program->operations);
+  free(program->spills);
+  free(program->returns);
+  program->operations = NULL;
+  program->spills = NULL;
+  program->returns = NULL;
+  program->length = 0;
+}
+
+void reset_machine(machine_t *machine)
+{
+  memset(machine, 0, sizeof(machine_t));
+}
+
+// A aritmética é feita sem sinal para que o transbordamento tenha o comportamento circular esperado (e definido)
+#define ARITHMETIC(x, operator, y) ((word_t)((unsigned_word_t)(x) operator (unsigned_word_t)(y)))
+
+#ifdef MACHINE_THREADED
+#define OPERATION(code) handle_##code:
+#define DISPATCH() goto *operation->handler
+#define NEXT() do { count++; operation++; DISPATCH(); } while (0)
+#define BRANCH(condition) do { count++; operation = (condition) ? operation->target : operation + 1; DISPATCH(); } while (0)
+#else
+#define OPERATION(code) case code:
+#define DISPATCH() goto dispatch
+#define NEXT() do { count++; operation++; DISPATCH(); } while (0)
+#define BRANCH(condition) do { count++; operation = (condition) ? operation->target : operation + 1; DISPATCH(); } while (0)
+#endif
+
+machine_status_t run_program(machine_t *machine, program_t *program)
+{
+#ifdef MACHINE_THREADED
+  static const void *handlers[] = {
+    &&handle_code_halt, &&handle_code_nop, &&handle_code_load_immediate, &&handle_code_load_direct,
+    &&handle_code_load_indirect, &&handle_code_store_direct, &&handle_code_store_indirect, &&handle_code_load_spill,
+    &&handle_code_store_spill, &&handle_code_mov,
+    &&handle_code_add_register, &&handle_code_add_immediate, &&handle_code_sub_register, &&handle_code_sub_immediate,
+    &&handle_code_mul_register, &&handle_code_mul_immediate, &&handle_code_div_register, &&handle_code_div_immediate,
+    &&handle_code_mod_register, &&handle_code_mod_immediate, &&handle_code_and_register, &&handle_code_and_immediate,
+    &&handle_code_or_register, &&handle_code_or_immediate, &&handle_code_cmp_register, &&handle_code_cmp_immediate,
+    &&handle_code_shl, &&handle_code_neg, &&handle_code_not,
+    &&handle_code_breq, &&handle_code_brne, &&handle_code_brls, &&handle_code_brle, &&handle_code_brgr,
+    &&handle_code_brge, &&handle_code_jump, &&handle_code_trap,
+    &&handle_code_load_frame, &&handle_code_store_frame, &&handle_code_load_local, &&handle_code_load_slot,
+    &&handle_code_store_slot, &&handle_code_set_argument, &&handle_code_set_argument_immediate,
+    &&handle_code_get_argument, &&handle_code_call, &&handle_code_enter, &&handle_code_ret
+  };
+  // Os endereços dos tratadores só são conhecidos dentro desta função, por isso a conversão é feita na primeira execução
+  if (!program->threaded) {
+    for (uint32_t index = 0; index <= program->length; index++)
+      program->operations[index].handler = handlers[program->operations[index].code];
+    program->threaded = true;
+  }
+#endif
+  word_t *r = machine->registers;
+  value_t *memory = machine->memory;
+  word_t *spills = program->spills;
+  word_t *arguments = machine->arguments;
+  const operation_t **returns = program->returns;
+  uint32_t depth = 0;
+  // A pilha de dados começa no fim da memória e não pode alcançar as variáveis globais
+  int frame = MACHINE_MEMORY_SIZE;
+  bool zero = machine->zero, negative = machine->negative;
+  uint64_t count = 0;
+  machine_status_t status = machine_halted;
+  const operation_t *operation = program->operations;
+#ifdef MACHINE_THREADED
+  DISPATCH();
+#else
+dispatch:
+  switch (operation->code) {
+#endif
+  OPERATION(code_nop) NEXT();
+  OPERATION(code_load_immediate) r[operation->a] = operation->constant; NEXT();
+  OPERATION(code_load_direct) r[operation->a] = memory[(address_t)operation->constant]; NEXT();
+  OPERATION(code_load_indirect) r[operation->a] = memory[(address_t)r[operation->b]]; NEXT();
+  OPERATION(code_store_direct) memory[(address_t)operation->constant] = (value_t)r[operation->b]; NEXT();
+  OPERATION(code_store_indirect) memory[(address_t)r[operation->a]] = (value_t)r[operation->b]; NEXT();
+  OPERATION(code_load_spill) r[operation->a] = spills[operation->constant]; NEXT();
+  OPERATION(code_store_spill) spills[operation->constant] = r[operation->b]; NEXT();
+  OPERATION(code_mov) r[operation->a] = r[operation->b]; NEXT();
+  OPERATION(code_add_register) r[operation->a] = ARITHMETIC(r[operation->a], +, r[operation->b]); NEXT();
+  OPERATION(code_add_immediate) r[operation->a] = ARITHMETIC(r[operation->a], +, operation->constant); NEXT();
+  OPERATION(code_sub_register) r[operation->a] = ARITHMETIC(r[operation->a], -, r[operation->b]); NEXT();
+  OPERATION(code_sub_immediate) r[operation->a] = ARITHMETIC(r[operation->a], -, operation->constant); NEXT();
+  OPERATION(code_mul_register) r[operation->a] = ARITHMETIC(r[operation->a], *, r[operation->b]); NEXT();
+  OPERATION(code_mul_immediate) r[operation->a] = ARITHMETIC(r[operation->a], *, operation->constant); NEXT();
+  OPERATION(code_div_register)
+    if (r[operation->b] == 0) {
+      status = machine_division_by_zero;
+      goto halt;
+    }
+    r[operation->a] = r[operation->b] == -1 ? ARITHMETIC(0, -, r[operation->a]) : r[operation->a] / r[operation->b];
+    NEXT();
+  OPERATION(code_div_immediate)
+    if (operation->constant == 0) {
+      status = machine_division_by_zero;
+      goto halt;
+    }
+    r[operation->a] = operation->constant == -1 ? ARITHMETIC(0, -, r[operation->a]) : r[operation->a] / operation->constant;
+    NEXT();
+  // O resto acompanha o quociente truncado: tem o sinal do dividendo
+  OPERATION(code_mod_register)
+    if (r[operation->b] == 0) {
+      status = machine_division_by_zero;
+      goto halt;
+    }
+    r[operation->a] = r[operation->b] == -1 ? 0 : r[operation->a] % r[operation->b];
+    NEXT();
+  OPERATION(code_mod_immediate)
+    if (operation->constant == 0) {
+      status = machine_division_by_zero;
+      goto halt;
+    }
+    r[operation->a] = operation->constant == -1 ? 0 : r[operation->a] % operation->constant;
+    NEXT();
+  OPERATION(code_and_register) r[operation->a] &= r[operation->b]; NEXT();
+  OPERATION(code_and_immediate) r[operation->a] &= operation->constant; NEXT();
+  OPERATION(code_or_register) r[operation->a] |= r[operation->b]; NEXT();
+  OPERATION(code_or_immediate) r[operation->a] |= operation->constant; NEXT();
+  OPERATION(code_cmp_register)
+    zero = r[operation->a] == r[operation->b];
+    negative = r[operation->a] < r[operation->b];
+    NEXT();
+  OPERATION(code_cmp_immediate)
+    zero = r[operation->a] == operation->constant;
+    negative = r[operation->a] < operation->constant;
+    NEXT();
+  OPERATION(code_shl) r[operation->a] = (word_t)((unsigned_word_t)r[operation->a] << operation->constant); NEXT();
+  OPERATION(code_neg) r[operation->a] = ARITHMETIC(0, -, r[operation->a]); NEXT();
+  OPERATION(code_not) r[operation->a] = ~r[operation->a]; NEXT();
+  OPERATION(code_breq) BRANCH(zero);
+  OPERATION(code_brne) BRANCH(!zero);
+  OPERATION(code_brls) BRANCH(negative);
+  OPERATION(code_brle) BRANCH(negative || zero);
+  OPERATION(code_brgr) BRANCH(!negative && !zero);
+  OPERATION(code_brge) BRANCH(!negative);
+  OPERATION(code_jump) count++; operation = operation->target; DISPATCH();
+  OPERATION(code_trap)
+    count++;
+    status = machine_index_out_of_range;
+    goto halt;
+  OPERATION(code_load_frame) r[operation->a] = memory[(address_t)(frame + operation->constant)]; NEXT();
+  OPERATION(code_store_frame) memory[(address_t)(frame + operation->constant)] = (value_t)r[operation->b]; NEXT();
+  OPERATION(code_load_local) r[operation->a] = frame + operation->constant; NEXT();
+  // As posições que guardam registradores ocupam SLOT_SIZE células, sem alinhamento
+  OPERATION(code_load_slot)
+    memcpy(&r[operation->a], &memory[(address_t)(frame + operation->constant)], sizeof(word_t));
+    NEXT();
+  OPERATION(code_store_slot)
+    memcpy(&memory[(address_t)(frame + operation->constant)], &r[operation->b], sizeof(word_t));
+    NEXT();
+  OPERATION(code_set_argument) arguments[operation->a] = r[operation->b]; NEXT();
+  OPERATION(code_set_argument_immediate) arguments[operation->a] = operation->constant; NEXT();
+  OPERATION(code_get_argument) r[operation->a] = arguments[operation->b]; NEXT();
+  OPERATION(code_call)
+    count++;
+    if (depth == MACHINE_MEMORY_SIZE) {
+      status = machine_stack_overflow;
+      goto halt;
+    }
+    returns[depth++] = operation + 1;
+    operation = operation->target;
+    DISPATCH();
+  OPERATION(code_enter)
+    if (frame - operation->constant < (int)program->data_size) {
+      count++;
+      status = machine_stack_overflow;
+      goto halt;
+    }
+    frame -= operation->constant;
+    NEXT();
+  OPERATION(code_ret)
+    count++;
+    frame += operation->constant;
+    if (depth == 0)
+      goto halt;
+    operation = returns[--depth];
+    DISPATCH();
+  OPERATION(code_halt) goto halt;
+#ifndef MACHINE_THREADED
+  }
+#endif
+halt:
+  machine->zero = zero;
+  machine->negative = negative;
+  machine->instruction_count += count;
+  return status;
+}
@@ -0,0 +1,68 @@
+//
+//  machine.h
+//  OberonVM
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#ifndef OberonVM_machine_h
+#define OberonVM_machine_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "backend.h"
+#include "object.h"
+
+// A máquina possui a mesma quantidade de registradores usada pelo gerador de código e uma memória de dados que cobre
+// todo o espaço de endereçamento de “address_t”. Cada posição da memória guarda um “value_t”; os registradores
+// (“word_t”) nunca são menores que 32 bits, para que possam conter endereços
+#define MACHINE_REGISTER_COUNT REGISTER_INDEX_COUNT
+#define MACHINE_MEMORY_SIZE (MAX_ADDRESS + 1)
+
+// Instrução pré-decodificada: a operação já considera os tipos dos operandos (“LOAD R, n” e “LOAD R, [R]” são operações
+// distintas) e os desvios apontam diretamente para a instrução de destino
+typedef struct _operation {
+  const void *handler; // Endereço do tratador no laço de execução (somente com “computed goto”)
+  unsigned char code;
+  unsigned char a, b;
+  int constant;
+  const struct _operation *target;
+} operation_t;
+
+// Os registradores que não couberam na máquina (ver “registers.h”) ficam em “spills”, que pertence ao programa, assim
+// como a pilha de retorno das chamadas de procedimentos (“returns”, alocada apenas se houver alguma chamada)
+typedef struct _program {
+  operation_t *operations;
+  uint32_t length;
+  uint32_t data_size;
+  word_t *spills;
+  uint32_t spill_count;
+  const operation_t **returns;
+  bool threaded;
+} program_t;
+
+typedef enum _machine_status {
+  machine_halted,
+  machine_division_by_zero,
+  machine_index_out_of_range,
+  machine_stack_overflow
+} machine_status_t;
+
+// Os registros de ativação ficam no fim da memória (ver “backend.h”); as posições de SLOT_SIZE células que guardam
+// registradores podem terminar logo após o último endereço, por isso a memória tem uma pequena folga
+typedef struct _machine {
+  word_t registers[MACHINE_REGISTER_COUNT];
+  word_t arguments[MAX_PARAMETERS];
+  value_t memory[MACHINE_MEMORY_SIZE + SLOT_SIZE];
+  bool zero, negative;
+  uint64_t instruction_count;
+} machine_t;
+
+bool load_program(program_t *program, const object_t *object);
+void unload_program(program_t *program);
+void reset_machine(machine_t *machine);
+machine_status_t run_program(machine_t *machine, program_t *program);
+
+#endif
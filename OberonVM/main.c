@@ -0,0 +1,93 @@
+//
+//  main.c
+//  OberonVM
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "object.h"
+#include "machine.h"
+
+// Executa um arquivo objeto gerado por “Oberon -b”
+// Uso: OberonVM [-s] [-d] [-r repetições] objeto
+//   -s  mostra a quantidade de instruções executadas, o tempo e a vazão (instruções por segundo)
+//   -d  mostra o conteúdo da área de dados ao final da execução
+//   -r  executa o programa várias vezes (a memória é zerada antes de cada execução), útil para medições
+int main(int argc, const char *argv[])
+{
+	const char *input_path = NULL;
+	bool statistics = false, dump = false;
+	long repetitions = 1;
+	for (int index = 1; index < argc; index++) {
+		if (strcmp(argv[index], "-s") == 0)
+			statistics = true;
+		else if (strcmp(argv[index], "-d") == 0)
+			dump = true;
+		else if (strcmp(argv[index], "-r") == 0 && index + 1 < argc)
+			repetitions = strtol(argv[++index], NULL, 10);
+		else
+			input_path = argv[index];
+	}
+	if (!input_path || repetitions < 1) {
+		printf("Usage: OberonVM [-s] [-d] [-r repetitions] object\n");
+		return EXIT_FAILURE;
+	}
+	FILE *input_file = strcmp(input_path, "-") == 0 ? stdin : fopen(input_path, "rb");
+	if (!input_file) {
+		printf("Input file could not be opened.\n");
+		return EXIT_FAILURE;
+	}
+	object_t object;
+	bool loaded = read_object(input_file, &object);
+	if (input_file != stdin)
+		fclose(input_file);
+	if (!loaded) {
+		printf("Empty or damaged object file.\n");
+		return EXIT_FAILURE;
+	}
+	program_t program;
+	loaded = load_program(&program, &object);
+	clear_object(&object);
+	if (!loaded) {
+		printf("The object file contains invalid instructions.\n");
+		return EXIT_FAILURE;
+	}
+	machine_t *machine = (machine_t *)malloc(sizeof(machine_t));
+	if (!machine) {
+		printf("Not enough memory.\n");
+		return EXIT_FAILURE;
+	}
+	machine_status_t status = machine_halted;
+	uint64_t instruction_count = 0;
+	clock_t start = clock();
+	for (long repetition = 0; repetition < repetitions && status == machine_halted; repetition++) {
+		reset_machine(machine);
+		status = run_program(machine, &program);
+		instruction_count += machine->instruction_count;
+	}
+	double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	if (status == machine_division_by_zero)
+		printf("Division by zero.\n");
+	else if (status == machine_index_out_of_range)
+		printf("Index out of range.\n");
+	else if (status == machine_stack_overflow)
+		printf("Stack overflow.\n");
+	if (dump)
+		for (uint32_t address = 0; address < program.data_size; address++)
+			printf("[%.4X] %lld\n", address, (long long)machine->memory[address]);
+	if (statistics) {
+		fprintf(stderr, "%llu instructions in %.3f s", (unsigned long long)instruction_count, seconds);
+		if (seconds > 0)
+			fprintf(stderr, " (%.1f million instructions/s)", instruction_count / seconds / 1e6);
+		fprintf(stderr, "\n");
+	}
+	free(machine);
+	unload_program(&program);
+	return status == machine_halted ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,84 @@
+//
+//  runtime.c
+//  Oberon
+//
+//  Created by Alvaro Costa Neto on 10/17/26.
+//  Copyright (c) 2026 Alvaro Costa Neto. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "backend.h"
+
+// Suporte de execução para o código gerado com “Oberon -n”. Uso típico:
+//
+//   Oberon -n programa.txt programa.s
+//   cc -I Oberon programa.s Runtime/runtime.c -o programa
+//
+// As opções são as mesmas da máquina virtual: “-s” mostra o tempo de execução, “-d” mostra a área de dados ao final e
+// “-r n” repete a execução “n” vezes (a área de dados é zerada antes de cada execução). O suporte precisa ser compilado
+// com o mesmo “VALUE_BITS” do compilador que gerou o código
+
+extern value_t oberon_data[];
+extern const unsigned int oberon_data_size;
+extern const unsigned int oberon_value_bits;
+void oberon_main(void);
+
+// Consultada pelas versões vetoriais dos laços, que usam AVX2 quando o processador o suporta e SSE2 caso contrário
+int oberon_avx2 = 0;
+
+static bool dump = false;
+
+void dump_data(void)
+{
+	for (unsigned int address = 0; address < oberon_data_size; address++)
+		printf("[%.4X] %lld\n", address, (long long)oberon_data[address]);
+}
+
+// Chamada pela instrução “TRAP”: assim como na máquina virtual, a execução termina com a mensagem do erro e a área de
+// dados ainda é mostrada
+void oberon_trap(int trap)
+{
+	if (trap == trap_index_out_of_range)
+		printf("Index out of range.\n");
+	else if (trap == trap_stack_overflow)
+		printf("Stack overflow.\n");
+	if (dump)
+		dump_data();
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, const char *argv[])
+{
+	if (oberon_value_bits != VALUE_BITS) {
+		fprintf(stderr, "The program was compiled for %u-bit values, but the runtime uses %d-bit values.\n",
+		        oberon_value_bits, VALUE_BITS);
+		return EXIT_FAILURE;
+	}
+	oberon_avx2 = __builtin_cpu_supports("avx2");
+	bool statistics = false;
+	long repetitions = 1;
+	for (int index = 1; index < argc; index++) {
+		if (strcmp(argv[index], "-s") == 0)
+			statistics = true;
+		else if (strcmp(argv[index], "-d") == 0)
+			dump = true;
+		else if (strcmp(argv[index], "-r") == 0 && index + 1 < argc)
+			repetitions = strtol(argv[++index], NULL, 10);
+	}
+	clock_t start = clock();
+	for (long repetition = 0; repetition < repetitions; repetition++) {
+		memset(oberon_data, 0, ((size_t)MAX_ADDRESS + 1) * sizeof(value_t));
+		oberon_main();
+	}
+	double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	if (dump)
+		dump_data();
+	if (statistics)
+		fprintf(stderr, "%ld runs in %.3f s\n", repetitions, seconds);
+	return EXIT_SUCCESS;
+}